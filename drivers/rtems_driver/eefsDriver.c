@@ -63,6 +63,17 @@ extern uint32_t rtems_eefs_b_address;
 
 #define EEFS_VOLUME_SEMAPHORE_TIMEOUT    RTEMS_NO_TIMEOUT
 
+/*
+** Set once the EEFS library global data (file descriptor pools and
+** directory descriptor) has been initialized by the first mount.
+*/
+static uint32_t rtems_eefs_lib_initialized = 0;
+
+/*
+** Global lock of the EEFS library, see eefs_macros.h
+*/
+rtems_id rtems_eefs_lib_mutex;
+
 /*
 ** Define EEFS Node types
 */
@@ -189,6 +200,21 @@ int rtems_eefs_initialize ( rtems_filesystem_mount_table_entry_t *mt_entry,
    mt_entry->fs_info                  = fs;
    mt_entry->mt_fs_root.node_access   = (void *)ROOT_INODE;
    mt_entry->mt_fs_root.node_access_2 = (void *)EEFS_FILE_NOT_FOUND;
+
+   /*
+   ** Initialize the EEFS library global data on the first mount
+   */
+   if (rtems_eefs_lib_initialized == 0)
+   {
+      sc = EEFS_LIB_RTEMS_MUTEX_CREATE(rtems_eefs_lib_mutex);
+      if (sc != RTEMS_SUCCESSFUL)
+      {
+         free(fs);
+         rtems_set_errno_and_return_minus_one (ENOMEM);
+      }
+      EEFS_LibInit();
+      rtems_eefs_lib_initialized = 1;
+   }
   
    /*
    ** Initalize the EEFS
@@ -505,7 +531,9 @@ int rtems_eefs_eval_path (const char*                        path,
 /* 
 ** rtems_eefs_statvfs
 **     Return information about the mounted EEFS file system.
-**     used for determining available space.
+**     used for determining available space.  The free blocks include the
+**     slots of deleted files, which can be reclaimed by reusing or compacting
+**     them, while the available blocks are only the contiguous free memory.
 **
 ** PARAMETERS:
 **     loc - IN - RTEMS location info structure for the file system to evaluate
@@ -521,7 +549,9 @@ int rtems_eefs_statvfs(
 )
 {
     eefs_info_t     *fs           = loc->mt_entry->fs_info;
+    EEFS_SpaceInfo_t SpaceInfo;
     uint32_t         FreeBlocks;
+    uint32_t         AvailableBlocks;
     uint32_t         TotalBlocks;
     uint32_t         FreeInodes;
 
@@ -529,8 +559,10 @@ int rtems_eefs_statvfs(
        printf("eefs_statvfs\n");
     #endif
 
-    FreeBlocks = fs->eefs_inode_table.FreeMemorySize / 512;
-    TotalBlocks =  (2048 * 1024) / 512; 
+    EEFS_LibGetSpaceInfo(&fs->eefs_inode_table, &SpaceInfo);
+    FreeBlocks = (SpaceInfo.FreeSpace + SpaceInfo.DeletedSpace) / 512;
+    AvailableBlocks = SpaceInfo.FreeSpace / 512;
+    TotalBlocks = SpaceInfo.TotalSpace / 512;
     FreeInodes =  EEFS_MAX_FILES - fs->eefs_inode_table.NumberOfFiles;
 
     /*
@@ -540,7 +572,7 @@ int rtems_eefs_statvfs(
     buf->f_frsize = 512;              /* fragment size */
     buf->f_blocks = TotalBlocks;      /* size of fs in f_frsize units */
     buf->f_bfree  = FreeBlocks;       /* # free blocks */
-    buf->f_bavail = FreeBlocks;       /* # free blocks for non-root */
+    buf->f_bavail = AvailableBlocks;  /* # free blocks for non-root */
     buf->f_files  = EEFS_MAX_FILES;   /* # inodes */
     buf->f_ffree  = FreeInodes;       /* # free inodes */
     buf->f_favail = FreeInodes;       /* # free inodes for non-root */
@@ -1009,22 +1041,101 @@ int rtems_eefs_fstat(rtems_filesystem_location_info_t *loc, struct stat  *buf)
 }
 
 /* 
-** rtems_eefs_fopen 
-**     stub implementation to allow fopen to work properly 
+** rtems_eefs_ftruncate 
+**     Truncate an open EEFS file.  This is also called by open() when a file
+**     is opened with O_TRUNC, so the space of the file is kept and the file
+**     can be rewritten to its old size.  The EEFS does not support holes, so
+**     a file can not be made longer.
+**
+** PARAMETERS:
+**     iop      - RTEMS iop structure, which keeps track of an open file.
+**     length   - new length of the file
 **
 ** RETURNS:
-**     RC_OK 
+**     RC_OK on success, or -1 if error occured (errno set appropriately)
 */
 static int rtems_eefs_ftruncate(
-    rtems_libio_t   *iop __attribute__((unused)),
-    rtems_off64_t    count __attribute__((unused))
+    rtems_libio_t   *iop,
+    rtems_off64_t    length
 )
 {
-    #ifdef EEFS_DEBUG
-       printf("eefs_fopen\n");
-    #endif
+   rtems_status_code  sc = RTEMS_SUCCESSFUL;
+   eefs_info_t       *fs = iop->pathinfo.mt_entry->fs_info;
+   int32              eefs_fd = (int32 )iop->file_info;
+   int32              eefs_status;
 
-    return(RC_OK);
+   #ifdef EEFS_DEBUG
+      printf("eefs_ftruncate\n");
+   #endif
+
+   if ( (length < 0) || (length > 0xFFFFFFFF) )
+   {
+      rtems_set_errno_and_return_minus_one(EINVAL);
+   }
+
+   sc = rtems_semaphore_obtain(fs->eefs_mutex, RTEMS_WAIT,
+                                EEFS_VOLUME_SEMAPHORE_TIMEOUT);
+   if (sc != RTEMS_SUCCESSFUL)
+   {
+       rtems_set_errno_and_return_minus_one(EIO);
+   }
+
+   eefs_status = EEFS_LibFtruncate(eefs_fd, (uint32)length);
+   if ( eefs_status == EEFS_PERMISSION_DENIED )
+   {
+      rtems_semaphore_release(fs->eefs_mutex);
+      rtems_set_errno_and_return_minus_one(EBADF);
+   }
+   else if ( eefs_status < 0 )
+   {
+      rtems_semaphore_release(fs->eefs_mutex);
+      rtems_set_errno_and_return_minus_one(EINVAL);
+   }
+
+   rtems_semaphore_release(fs->eefs_mutex);
+   return(RC_OK);
+}
+
+/* 
+** rtems_eefs_fsync 
+**     Writes the size of an open EEFS file to EEPROM so the data written so
+**     far survives a reset without closing the file.
+**
+** PARAMETERS:
+**     iop      - RTEMS iop structure, which keeps track of an open file.
+**
+** RETURNS:
+**     RC_OK on success, or -1 if error occured (errno set appropriately)
+*/
+static int rtems_eefs_fsync(
+    rtems_libio_t   *iop
+)
+{
+   rtems_status_code  sc = RTEMS_SUCCESSFUL;
+   eefs_info_t       *fs = iop->pathinfo.mt_entry->fs_info;
+   int32              eefs_fd = (int32 )iop->file_info;
+   int32              eefs_status;
+
+   #ifdef EEFS_DEBUG
+      printf("eefs_fsync\n");
+   #endif
+
+   sc = rtems_semaphore_obtain(fs->eefs_mutex, RTEMS_WAIT,
+                                EEFS_VOLUME_SEMAPHORE_TIMEOUT);
+   if (sc != RTEMS_SUCCESSFUL)
+   {
+       rtems_set_errno_and_return_minus_one(EIO);
+   }
+
+   eefs_status = EEFS_LibFsync(eefs_fd);
+   if ( eefs_status < 0 )
+   {
+      rtems_semaphore_release(fs->eefs_mutex);
+      rtems_set_errno_and_return_minus_one(EBADF);
+   }
+
+   rtems_semaphore_release(fs->eefs_mutex);
+   return(RC_OK);
 }
 
 /* 
@@ -1173,7 +1284,8 @@ int rtems_eefs_rename(
 {
    rtems_status_code    sc = RTEMS_SUCCESSFUL;
    eefs_info_t         *fs = old_loc->mt_entry->fs_info;
-   EEFS_FileHeader_t    FileHeader;
+   char                 old_name[EEFS_MAX_FILENAME_SIZE];
+   int32                eefs_status;
    uint32               inode;
 
    if ((int)old_loc->node_access == ROOT_INODE)
@@ -1193,19 +1305,28 @@ int rtems_eefs_rename(
              {
                 rtems_set_errno_and_return_minus_one(EIO);
              }
-             EEFS_LIB_EEPROM_READ(&FileHeader, fs->eefs_inode_table.File[inode].FileHeaderPointer,
-                            sizeof(EEFS_FileHeader_t));
-             if ( FileHeader.InUse == TRUE )
+             if ( fs->eefs_inode_table.File[inode].InUse == TRUE )
              {
                 /*
-                ** Rename
+                ** Rename through the EEFS library so the inode table
+                ** filename index stays in sync with the file header
                 */
-                strncpy(FileHeader.Filename, name, EEFS_MAX_FILENAME_SIZE);
-
-                EEFS_LIB_EEPROM_WRITE(fs->eefs_inode_table.File[inode].FileHeaderPointer, 
-                                   &FileHeader, sizeof(EEFS_FileHeader_t));
-                EEFS_LIB_EEPROM_FLUSH;
+                strncpy(old_name, fs->eefs_inode_table.File[inode].Filename, EEFS_MAX_FILENAME_SIZE);
+                old_name[EEFS_MAX_FILENAME_SIZE - 1] = '\0';
+                eefs_status = EEFS_LibRename(&(fs->eefs_inode_table), old_name, (char *)name);
                 rtems_semaphore_release(fs->eefs_mutex);
+                if ( eefs_status == EEFS_FILE_NOT_FOUND )
+                {
+                   rtems_set_errno_and_return_minus_one(ENOENT);
+                }
+                else if ( eefs_status == EEFS_READ_ONLY_FILE_SYSTEM )
+                {
+                   rtems_set_errno_and_return_minus_one(EROFS);
+                }
+                else if ( eefs_status != EEFS_SUCCESS )
+                {
+                   rtems_set_errno_and_return_minus_one(EACCES);
+                }
             }
             else
             {
@@ -1240,7 +1361,8 @@ int rtems_eefs_unlink(
 {
    rtems_status_code    sc = RTEMS_SUCCESSFUL;
    eefs_info_t       *fs = pathloc->mt_entry->fs_info;
-   EEFS_FileHeader_t    FileHeader;
+   char                 name[EEFS_MAX_FILENAME_SIZE];
+   int32                eefs_status;
    uint32               inode;
 
    #ifdef EEFS_DEBUG
@@ -1264,15 +1386,28 @@ int rtems_eefs_unlink(
              {
                 rtems_set_errno_and_return_minus_one(EIO);
              }
-             EEFS_LIB_EEPROM_READ(&FileHeader, fs->eefs_inode_table.File[inode].FileHeaderPointer,
-                            sizeof(EEFS_FileHeader_t));
-             if ( FileHeader.InUse == TRUE )
+             if ( fs->eefs_inode_table.File[inode].InUse == TRUE )
              {
-                FileHeader.InUse = FALSE;
-                EEFS_LIB_EEPROM_WRITE(fs->eefs_inode_table.File[inode].FileHeaderPointer, 
-                                   &FileHeader, sizeof(EEFS_FileHeader_t));
-                EEFS_LIB_EEPROM_FLUSH;
+                /*
+                ** Remove through the EEFS library so the inode table
+                ** filename index stays in sync with the file header
+                */
+                strncpy(name, fs->eefs_inode_table.File[inode].Filename, EEFS_MAX_FILENAME_SIZE);
+                name[EEFS_MAX_FILENAME_SIZE - 1] = '\0';
+                eefs_status = EEFS_LibRemove(&(fs->eefs_inode_table), name);
                 rtems_semaphore_release(fs->eefs_mutex);
+                if ( eefs_status == EEFS_FILE_NOT_FOUND )
+                {
+                   rtems_set_errno_and_return_minus_one(ENOENT);
+                }
+                else if ( eefs_status == EEFS_READ_ONLY_FILE_SYSTEM )
+                {
+                   rtems_set_errno_and_return_minus_one(EROFS);
+                }
+                else if ( eefs_status != EEFS_SUCCESS )
+                {
+                   rtems_set_errno_and_return_minus_one(EACCES);
+                }
             }
             else
             {
@@ -1585,7 +1720,7 @@ const rtems_filesystem_file_handlers_r rtems_eefs_file_handlers =
    .fchmod_h        = NULL, 
    .ftruncate_h     = rtems_eefs_ftruncate,
    .fpathconf_h     = NULL, 
-   .fsync_h         = NULL, 
+   .fsync_h         = rtems_eefs_fsync,
    .fdatasync_h     = NULL, 
    .fcntl_h         = NULL, 
    .rmnod_h         = NULL 
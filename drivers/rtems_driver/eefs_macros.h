@@ -0,0 +1,89 @@
+/*
+** Filename: eefs_macros.h
+**
+**      Copyright (c) 2010-2014, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+*/
+
+/*
+**
+** Purpose: This file contains system dependent macros for eefs lower level functions
+**   when the EEFS is used through the RTEMS file system driver.
+**
+** Design Notes:
+**   The global lock is a semaphore created by the driver on the first mount.  The
+**   per volume and per file descriptor locks are RTEMS semaphores whose ids are kept
+**   in the Inode Table and in each File Descriptor.
+**
+** References:
+**
+*/
+
+#ifndef _eefs_macros_
+#define	_eefs_macros_
+
+/*
+ * Includes
+ */
+
+#include <rtems.h>
+#include <string.h>
+
+/*
+ * Exported Global Data
+ */
+
+extern rtems_id rtems_eefs_lib_mutex;
+
+/*
+ * System Dependent Lower Level Functions
+ */
+
+/* These macros define the lower level EEPROM interface functions.  Defaults to memcpy(Dest, Src, Length) */
+#define EEFS_LIB_EEPROM_WRITE(Dest, Src, Length) memcpy(Dest, Src, Length)
+#define EEFS_LIB_EEPROM_READ(Dest, Src, Length)  memcpy(Dest, Src, Length)
+#define EEFS_LIB_EEPROM_FLUSH
+#define EEFS_LIB_EEPROM_SYNC
+
+/* This macro creates a priority inheriting mutex and stores its id in Id */
+#define EEFS_LIB_RTEMS_MUTEX_CREATE(Id)          rtems_semaphore_create(rtems_build_name('E', 'E', 'F', 'l'), 1, \
+                                                     RTEMS_PRIORITY | RTEMS_BINARY_SEMAPHORE | RTEMS_INHERIT_PRIORITY | \
+                                                     RTEMS_NO_PRIORITY_CEILING | RTEMS_LOCAL, 0, (rtems_id *)&(Id))
+
+/* These macros define the lock and unlock interface functions used to guarentee
+ * exclusive access to shared resources. */
+#define EEFS_LIB_LOCK                            rtems_semaphore_obtain(rtems_eefs_lib_mutex, RTEMS_WAIT, RTEMS_NO_TIMEOUT)
+#define EEFS_LIB_UNLOCK                          rtems_semaphore_release(rtems_eefs_lib_mutex)
+
+/* These macros define the per volume lock that protects an Inode Table */
+#define EEFS_LIB_INODE_LOCK_CREATE(InodeTable)   EEFS_LIB_RTEMS_MUTEX_CREATE((InodeTable)->LockId)
+#define EEFS_LIB_INODE_LOCK_DELETE(InodeTable)   rtems_semaphore_delete((rtems_id)(InodeTable)->LockId)
+#define EEFS_LIB_INODE_LOCK(InodeTable)          rtems_semaphore_obtain((rtems_id)(InodeTable)->LockId, RTEMS_WAIT, RTEMS_NO_TIMEOUT)
+#define EEFS_LIB_INODE_UNLOCK(InodeTable)        rtems_semaphore_release((rtems_id)(InodeTable)->LockId)
+
+/* These macros define the per file descriptor lock that protects an open file during data transfers */
+#define EEFS_LIB_FD_LOCK_CREATE(FileDescriptor)  EEFS_LIB_RTEMS_MUTEX_CREATE((FileDescriptor)->LockId)
+#define EEFS_LIB_FD_LOCK_DELETE(FileDescriptor)  rtems_semaphore_delete((rtems_id)(FileDescriptor)->LockId)
+#define EEFS_LIB_FD_LOCK(FileDescriptor)         rtems_semaphore_obtain((rtems_id)(FileDescriptor)->LockId, RTEMS_WAIT, RTEMS_NO_TIMEOUT)
+#define EEFS_LIB_FD_UNLOCK(FileDescriptor)       rtems_semaphore_release((rtems_id)(FileDescriptor)->LockId)
+
+/* This macro defines the time interface function.  Defaults to time(NULL) */
+#define EEFS_LIB_TIME                            time(NULL)
+
+/* This macro defines the file system write protection interface function.  If the file system
+   is read-only then set this macro to TRUE.  If the file system is always write enabled then
+   set this macro to FALSE.  If the eeprom has an external write protection interface then a custom
+   function can be called to determine the write protect status. */
+#define EEFS_LIB_IS_WRITE_PROTECTED              FALSE
+
+#endif
+
+/************************/
+/*  End of File Comment */
+/************************/
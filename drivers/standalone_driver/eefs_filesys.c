@@ -241,6 +241,21 @@ int32 EEFS_Close(int32 FileDescriptor)
     return(ReturnCode);
 }
 
+/* Makes the data written to an open file so far survive a reset without closing the file. */
+int32 EEFS_Fsync(int32 FileDescriptor)
+{
+    int32       ReturnCode;
+
+    if (EEFS_LibFsync(FileDescriptor) == EEFS_SUCCESS) {
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else {
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
 /* Read from a file. */
 int32 EEFS_Read(int32 FileDescriptor, void *Buffer, uint32 Length)
 {
@@ -328,6 +343,44 @@ int32 EEFS_Creat(char *Path, uint32 Mode)
     return(ReturnCode);
 }
 
+/* Creates a new file of an expected size and opens it for writing. */
+int32 EEFS_CreatSized(char *Path, uint32 ReservedBytes, uint32 Mode)
+{
+    EEFS_SplitPath_t             SplitPath;
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        FileDescriptor;
+    int32                        ReturnCode;
+
+    if (EEFS_SplitPath(Path, &SplitPath) == 0) {
+
+        if ((Volume = EEFS_FindVolume(SplitPath.MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if ((FileDescriptor = EEFS_LibCreatSized(&Device->InodeTable, SplitPath.Filename, ReservedBytes, Mode)) >= 0) {
+
+                    ReturnCode = FileDescriptor;
+                }
+                else { /* error creating file */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid filename */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
 /* Removes the specified file from the file system. */
 int32 EEFS_Remove(char *Path)
 {
@@ -365,6 +418,218 @@ int32 EEFS_Remove(char *Path)
     return(ReturnCode);
 }
 
+/* Compacts the Volume by moving files down over the slots of deleted files and returning the space to free memory. */
+int32 EEFS_Compact(char *MountPoint, uint32 MaxBytesToCopy)
+{
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if ((MountPoint != NULL) && (strlen(MountPoint) < EEFS_MAX_MOUNTPOINT_SIZE)) {
+
+        if ((Volume = EEFS_FindVolume(MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if ((ReturnCode = EEFS_LibCompact(&Device->InodeTable, MaxBytesToCopy)) < 0) {
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid mount point name */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Grows the slot of the specified file so it can hold at least NewMaxFileSize bytes, moving the file to free memory if its
+ * slot cannot be extended in place. */
+int32 EEFS_Resize(char *Path, uint32 NewMaxFileSize)
+{
+    EEFS_SplitPath_t             SplitPath;
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if (EEFS_SplitPath(Path, &SplitPath) == 0) {
+
+        if ((Volume = EEFS_FindVolume(SplitPath.MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibResize(&Device->InodeTable, SplitPath.Filename, NewMaxFileSize) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* error resizing file */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid filename */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Truncates a file that is open for write to Length bytes and keeps the space of the file so it can be rewritten.  Truncate
+ * cannot make a file longer. */
+int32 EEFS_Ftruncate(int32 FileDescriptor, uint32 Length)
+{
+    int32       ReturnCode;
+
+    if (EEFS_LibFtruncate(FileDescriptor, Length) == EEFS_SUCCESS) {
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else {
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Truncates a file that is open for write to Length bytes and releases the space past the new end of the file if no other
+ * File Descriptor has the file open.  Truncate cannot make a file longer. */
+int32 EEFS_FtruncateRelease(int32 FileDescriptor, uint32 Length)
+{
+    int32       ReturnCode;
+
+    if (EEFS_LibFtruncateRelease(FileDescriptor, Length) == EEFS_SUCCESS) {
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else {
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Truncates the specified file to Length bytes and releases the space past the new end of the file.  The file must not be
+ * open.  Truncate cannot make a file longer. */
+int32 EEFS_Truncate(char *Path, uint32 Length)
+{
+    EEFS_SplitPath_t             SplitPath;
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if (EEFS_SplitPath(Path, &SplitPath) == 0) {
+
+        if ((Volume = EEFS_FindVolume(SplitPath.MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibTruncate(&Device->InodeTable, SplitPath.Filename, Length) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* error truncating file */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid filename */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Sets the spare byte policy of the Volume. */
+int32 EEFS_SetSparePolicy(char *MountPoint, uint32 Policy, uint32 Parameter, EEFS_SparePolicyFunction_t Function)
+{
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if ((MountPoint != NULL) && (strlen(MountPoint) < EEFS_MAX_MOUNTPOINT_SIZE)) {
+
+        if ((Volume = EEFS_FindVolume(MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibSetSparePolicy(&Device->InodeTable, Policy, Parameter, Function) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* invalid policy */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid mount point name */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Returns the spare byte statistics of the Volume in SpareStats, and clears them if Reset is TRUE. */
+int32 EEFS_GetSpareStats(char *MountPoint, EEFS_SpareStats_t *SpareStats, uint8 Reset)
+{
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if ((MountPoint != NULL) && (strlen(MountPoint) < EEFS_MAX_MOUNTPOINT_SIZE)) {
+
+        if ((Volume = EEFS_FindVolume(MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibGetSpareStats(&Device->InodeTable, SpareStats, Reset) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* invalid spare stats */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid mount point name */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
 /* Renames the specified file.  Note that you cannot move a file by renaming it to a different volume. */
 int32 EEFS_Rename(char *OldPath, char *NewPath)
 {
@@ -448,6 +713,114 @@ int32 EEFS_Stat(char *Path, EEFS_Stat_t *StatBuffer)
     return(ReturnCode);
 }
 
+/* Returns file information for every file in use on the Volume in the caller supplied StatBuffers array in a single pass. */
+int32 EEFS_Snapshot(char *MountPoint, EEFS_Stat_t *StatBuffers, uint32 MaxEntries, uint32 *Count, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if ((MountPoint != NULL) && (strlen(MountPoint) < EEFS_MAX_MOUNTPOINT_SIZE)) {
+
+        if ((Volume = EEFS_FindVolume(MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibSnapshot(&Device->InodeTable, StatBuffers, MaxEntries, Count, SpaceInfo) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* error getting snapshot */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid mount point name */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Returns the space totals of the Volume in SpaceInfo. */
+int32 EEFS_GetSpaceInfo(char *MountPoint, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if ((MountPoint != NULL) && (strlen(MountPoint) < EEFS_MAX_MOUNTPOINT_SIZE)) {
+
+        if ((Volume = EEFS_FindVolume(MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibGetSpaceInfo(&Device->InodeTable, SpaceInfo) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* invalid space info */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid mount point name */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Waits until every change that has been made to the Volume has been programmed into EEPROM. */
+int32 EEFS_Sync(char *MountPoint)
+{
+    EEFS_Volume_t               *Volume;
+    EEFS_Device_t               *Device;
+    int32                        ReturnCode;
+
+    if ((MountPoint != NULL) && (strlen(MountPoint) < EEFS_MAX_MOUNTPOINT_SIZE)) {
+
+        if ((Volume = EEFS_FindVolume(MountPoint)) != NULL) {
+
+            if ((Device = EEFS_FindDevice(Volume->DeviceName)) != NULL) {
+
+                if (EEFS_LibSync(&Device->InodeTable) == EEFS_SUCCESS) {
+
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* sync failed */
+                    ReturnCode = EEFS_ERROR;
+                }
+            }
+            else { /* device not found */
+                ReturnCode = EEFS_ERROR;
+            }
+        }
+        else { /* volume not found */
+            ReturnCode = EEFS_ERROR;
+        }
+    }
+    else { /* invalid mount point name */
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
 /* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
  * attribute.  To read file attributes use the stat function. */
 int32 EEFS_SetFileAttributes(char *Path, uint32 Attributes)
@@ -530,6 +903,33 @@ EEFS_DirectoryEntry_t *EEFS_ReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescrip
     return(EEFS_LibReadDir(DirectoryDescriptor));
 }
 
+/* Reentrant version of EEFS_ReadDir that copies the next file directory entry into the caller supplied DirectoryEntry.
+ * Returns 1 if an entry was read, 0 if no more file directory entries exist, or EEFS_ERROR on error. */
+int32 EEFS_ReadDir_r(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntry)
+{
+    int32       ReturnCode;
+
+    if ((ReturnCode = EEFS_LibReadDir_r(DirectoryDescriptor, DirectoryEntry)) < 0) {
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
+/* Reads up to MaxEntries file directory entries into the caller supplied DirectoryEntries array.  If Flags contains
+ * EEFS_READDIR_SKIP_DELETED then empty slots are skipped.  Returns the number of entries read, 0 if no more file directory
+ * entries exist, or EEFS_ERROR on error. */
+int32 EEFS_ReadDirBatch(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntries, uint32 MaxEntries, uint32 Flags)
+{
+    int32       ReturnCode;
+
+    if ((ReturnCode = EEFS_LibReadDirBatch(DirectoryDescriptor, DirectoryEntries, MaxEntries, Flags)) < 0) {
+        ReturnCode = EEFS_ERROR;
+    }
+
+    return(ReturnCode);
+}
+
 /* Close file system for reading the file directory. */
 int32 EEFS_CloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
 {
@@ -107,9 +107,16 @@ int32                           EEFS_Open(char *Path, uint32 Flags);
 /* Creates a new file and opens it for writing. */
 int32                           EEFS_Creat(char *Path, uint32 Mode);
 
+/* Creates a new file of an expected size and opens it for writing.  The file is created in the smallest deleted slot that
+ * can hold ReservedBytes bytes, or a slot of exactly ReservedBytes bytes is reserved in free memory. */
+int32                           EEFS_CreatSized(char *Path, uint32 ReservedBytes, uint32 Mode);
+
 /* Closes a file. */
 int32                           EEFS_Close(int32 FileDescriptor);
 
+/* Makes the data written to an open file so far survive a reset without closing the file. */
+int32                           EEFS_Fsync(int32 FileDescriptor);
+
 /* Read from a file. */
 int32                           EEFS_Read(int32 FileDescriptor, void *Buffer, uint32 Length);
 
@@ -121,16 +128,56 @@ int32                           EEFS_Write(int32 FileDescriptor, void *Buffer, u
 int32                           EEFS_LSeek(int32 FileDescriptor, uint32 ByteOffset, uint16 Origin);
 
 /* Removes the specified file from the file system.  Note that this just marks the file as deleted and does not free the memory
- * in use by the file.  Once a file is deleted, the only way the slot can be reused is to manually write a new file into the
- * slot, i.e. there is no way to reuse the memory through a EEFS api function */
+ * in use by the file.  The memory is returned to free memory by EEFS_Compact. */
 int32                           EEFS_Remove(char *Path);
 
+/* Compacts the Volume by moving files down over the slots of deleted files and returning the space to free memory.  Each call
+ * stops once MaxBytesToCopy bytes have been written to EEPROM, so a Volume can be compacted incrementally by calling this
+ * function until it returns 0.  Returns the number of bytes written to EEPROM or EEFS_ERROR on error. */
+int32                           EEFS_Compact(char *MountPoint, uint32 MaxBytesToCopy);
+
+/* Grows the slot of the specified file so it can hold at least NewMaxFileSize bytes, moving the file to free memory if its
+ * slot cannot be extended in place.  The file must not be open. */
+int32                           EEFS_Resize(char *Path, uint32 NewMaxFileSize);
+
+/* Truncates a file that is open for write to Length bytes and keeps the space of the file so it can be rewritten.  Truncate
+ * cannot make a file longer. */
+int32                           EEFS_Ftruncate(int32 FileDescriptor, uint32 Length);
+
+/* Truncates a file that is open for write to Length bytes and releases the space past the new end of the file if no other
+ * File Descriptor has the file open.  Truncate cannot make a file longer. */
+int32                           EEFS_FtruncateRelease(int32 FileDescriptor, uint32 Length);
+
+/* Truncates the specified file to Length bytes and releases the space past the new end of the file.  The file must not be
+ * open.  Truncate cannot make a file longer. */
+int32                           EEFS_Truncate(char *Path, uint32 Length);
+
+/* Sets the spare byte policy of the Volume, which chooses the spare bytes added to the slot of a file that is created by
+ * EEFS_Creat when it is closed.  See EEFS_LibSetSparePolicy for the meaning of Parameter for each policy. */
+int32                           EEFS_SetSparePolicy(char *MountPoint, uint32 Policy, uint32 Parameter, EEFS_SparePolicyFunction_t Function);
+
+/* Returns the spare byte statistics of the Volume in SpareStats, and clears them if Reset is TRUE. */
+int32                           EEFS_GetSpareStats(char *MountPoint, EEFS_SpareStats_t *SpareStats, uint8 Reset);
+
 /* Renames the specified file.  Note that you cannot move a file by renaming it to a different volume. */
 int32                           EEFS_Rename(char *OldPath, char *NewPath);
 
 /* Returns file information for the specified file in StatBuffer. */
 int32                           EEFS_Stat(char *Path, EEFS_Stat_t *StatBuffer);
 
+/* Returns file information for every file in use on the Volume in the caller supplied StatBuffers array in a single pass.
+ * At most MaxEntries entries are filled in, and Count is set to the number of files in use, which may be larger than
+ * MaxEntries.  If SpaceInfo is not NULL it is filled in with the space totals of the Volume. */
+int32                           EEFS_Snapshot(char *MountPoint, EEFS_Stat_t *StatBuffers, uint32 MaxEntries, uint32 *Count, EEFS_SpaceInfo_t *SpaceInfo);
+
+/* Returns the space totals of the Volume in SpaceInfo, including the space in the slots of deleted files that can be reclaimed
+ * by reusing them or by EEFS_Compact. */
+int32                           EEFS_GetSpaceInfo(char *MountPoint, EEFS_SpaceInfo_t *SpaceInfo);
+
+/* Waits until every change that has been made to the Volume has been programmed into EEPROM.  Only needed when the port
+ * flushes EEPROM in the background. */
+int32                           EEFS_Sync(char *MountPoint);
+
 /* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
  * attribute.  To read file attributes use the stat function. */
 int32                           EEFS_SetFileAttributes(char *Path, uint32 Attributes);
@@ -143,6 +190,15 @@ EEFS_DirectoryDescriptor_t     *EEFS_OpenDir(char *MountPoint);
  * set to FALSE for empty slots) */
 EEFS_DirectoryEntry_t          *EEFS_ReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor);
 
+/* Reentrant version of EEFS_ReadDir that copies the next file directory entry into the caller supplied DirectoryEntry.
+ * Returns 1 if an entry was read, 0 if no more file directory entries exist, or EEFS_ERROR on error. */
+int32                           EEFS_ReadDir_r(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntry);
+
+/* Reads up to MaxEntries file directory entries into the caller supplied DirectoryEntries array.  If Flags contains
+ * EEFS_READDIR_SKIP_DELETED then empty slots are skipped.  Returns the number of entries read, 0 if no more file directory
+ * entries exist, or EEFS_ERROR on error. */
+int32                           EEFS_ReadDirBatch(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntries, uint32 MaxEntries, uint32 Flags);
+
 /* Close file system for reading the file directory. */
 int32                           EEFS_CloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor);
 
@@ -32,12 +32,63 @@
 #define EEFS_LIB_EEPROM_WRITE(Dest, Src, Length) memcpy(Dest, Src, Length)
 #define EEFS_LIB_EEPROM_READ(Dest, Src, Length)  memcpy(Dest, Src, Length)
 #define EEFS_LIB_EEPROM_FLUSH
+#define EEFS_LIB_EEPROM_SYNC
+
+#ifdef EEFS_PTHREAD_LOCKS
+
+/* When EEFS_PTHREAD_LOCKS is defined the locks are implemented with pthreads in eefs_pthread_locks.c.  The volume
+ * lock is a reader/writer lock so readers of a volume run in parallel. */
+void    EEFS_PthreadGlobalLock(void);
+void    EEFS_PthreadGlobalUnlock(void);
+uint32  EEFS_PthreadCreateLock(void);
+void    EEFS_PthreadDeleteLock(uint32 LockId);
+void    EEFS_PthreadReadLock(uint32 LockId);
+void    EEFS_PthreadWriteLock(uint32 LockId);
+void    EEFS_PthreadUnlock(uint32 LockId);
+
+#define EEFS_LIB_LOCK                            EEFS_PthreadGlobalLock()
+#define EEFS_LIB_UNLOCK                          EEFS_PthreadGlobalUnlock()
+
+#define EEFS_LIB_INODE_LOCK_CREATE(InodeTable)   ((InodeTable)->LockId = EEFS_PthreadCreateLock())
+#define EEFS_LIB_INODE_LOCK_DELETE(InodeTable)   EEFS_PthreadDeleteLock((InodeTable)->LockId)
+#define EEFS_LIB_INODE_LOCK(InodeTable)          EEFS_PthreadWriteLock((InodeTable)->LockId)
+#define EEFS_LIB_INODE_RDLOCK(InodeTable)        EEFS_PthreadReadLock((InodeTable)->LockId)
+#define EEFS_LIB_INODE_WRLOCK(InodeTable)        EEFS_PthreadWriteLock((InodeTable)->LockId)
+#define EEFS_LIB_INODE_UNLOCK(InodeTable)        EEFS_PthreadUnlock((InodeTable)->LockId)
+
+#define EEFS_LIB_FD_LOCK_CREATE(FileDescriptor)  ((FileDescriptor)->LockId = EEFS_PthreadCreateLock())
+#define EEFS_LIB_FD_LOCK_DELETE(FileDescriptor)  EEFS_PthreadDeleteLock((FileDescriptor)->LockId)
+#define EEFS_LIB_FD_LOCK(FileDescriptor)         EEFS_PthreadWriteLock((FileDescriptor)->LockId)
+#define EEFS_LIB_FD_UNLOCK(FileDescriptor)       EEFS_PthreadUnlock((FileDescriptor)->LockId)
+
+#else
 
 /* These macros define the lock and unlock interface functions used to guarentee
  * exclusive access to shared resources.  Defaults to undefined since it is implementation dependent */
 #define EEFS_LIB_LOCK
 #define EEFS_LIB_UNLOCK
 
+/* These macros define the per volume lock that protects an Inode Table.  The lock handle can be stored in
+ * InodeTable->LockId.  Defaults to undefined since it is implementation dependent */
+#define EEFS_LIB_INODE_LOCK_CREATE(InodeTable)
+#define EEFS_LIB_INODE_LOCK_DELETE(InodeTable)
+#define EEFS_LIB_INODE_LOCK(InodeTable)
+#define EEFS_LIB_INODE_UNLOCK(InodeTable)
+
+/* These optional macros make the per volume lock a reader/writer lock.  If they are not defined then
+ * EEFS_LIB_INODE_LOCK is used for both readers and writers. */
+#define EEFS_LIB_INODE_RDLOCK(InodeTable)
+#define EEFS_LIB_INODE_WRLOCK(InodeTable)
+
+/* These macros define the per file descriptor lock that protects an open file during data transfers.  The lock
+ * handle can be stored in FileDescriptor->LockId.  Defaults to undefined since it is implementation dependent */
+#define EEFS_LIB_FD_LOCK_CREATE(FileDescriptor)
+#define EEFS_LIB_FD_LOCK_DELETE(FileDescriptor)
+#define EEFS_LIB_FD_LOCK(FileDescriptor)
+#define EEFS_LIB_FD_UNLOCK(FileDescriptor)
+
+#endif
+
 /* This macro defines the time interface function.  Defaults to time(NULL) */
 #define EEFS_LIB_TIME                           time(NULL)
 
@@ -0,0 +1,98 @@
+/*
+**      Copyright (c) 2010-2014, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+*/
+
+/*
+** Filename: eefs_pthread_locks.c
+**
+** Purpose:
+**     This file contains a pthread implementation of the eeprom file system locks for host builds.  It is only
+**     used when EEFS_PTHREAD_LOCKS is defined, see eefs_macros.h.  The volume locks and file descriptor locks are
+**     pthread reader/writer locks, so readers of the same volume run in parallel and the scaling of read mostly
+**     workloads can be measured on the host.  The global lock is a pthread mutex.
+**
+*/
+
+/*
+ * Includes
+ */
+
+#include "common_types.h"
+#include "eefs_macros.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/*
+ * Local Data
+ */
+
+pthread_mutex_t                 EEFS_PthreadGlobalMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Function Definitions
+ */
+
+/* Takes the global lock */
+void EEFS_PthreadGlobalLock(void)
+{
+    pthread_mutex_lock(&EEFS_PthreadGlobalMutex);
+} /* End of EEFS_PthreadGlobalLock() */
+
+/* Releases the global lock */
+void EEFS_PthreadGlobalUnlock(void)
+{
+    pthread_mutex_unlock(&EEFS_PthreadGlobalMutex);
+} /* End of EEFS_PthreadGlobalUnlock() */
+
+/* Creates a reader/writer lock and returns its LockId, or 0 if the lock could not be created */
+uint32 EEFS_PthreadCreateLock(void)
+{
+    pthread_rwlock_t           *Lock;
+
+    if ((Lock = malloc(sizeof(pthread_rwlock_t))) != NULL) {
+        if (pthread_rwlock_init(Lock, NULL) != 0) {
+            free(Lock);
+            Lock = NULL;
+        }
+    }
+    return((uint32)Lock);
+
+} /* End of EEFS_PthreadCreateLock() */
+
+/* Deletes a reader/writer lock created by EEFS_PthreadCreateLock */
+void EEFS_PthreadDeleteLock(uint32 LockId)
+{
+    if (LockId != 0) {
+        pthread_rwlock_destroy((pthread_rwlock_t *)LockId);
+        free((pthread_rwlock_t *)LockId);
+    }
+} /* End of EEFS_PthreadDeleteLock() */
+
+/* Takes a reader/writer lock for shared read access */
+void EEFS_PthreadReadLock(uint32 LockId)
+{
+    pthread_rwlock_rdlock((pthread_rwlock_t *)LockId);
+} /* End of EEFS_PthreadReadLock() */
+
+/* Takes a reader/writer lock for exclusive write access */
+void EEFS_PthreadWriteLock(uint32 LockId)
+{
+    pthread_rwlock_wrlock((pthread_rwlock_t *)LockId);
+} /* End of EEFS_PthreadWriteLock() */
+
+/* Releases a reader/writer lock taken for either read or write access */
+void EEFS_PthreadUnlock(uint32 LockId)
+{
+    pthread_rwlock_unlock((pthread_rwlock_t *)LockId);
+} /* End of EEFS_PthreadUnlock() */
+
+/************************/
+/*  End of File Comment */
+/************************/
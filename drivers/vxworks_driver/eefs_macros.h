@@ -42,12 +42,27 @@ extern SEM_ID EEFS_semId;
 #define EEFS_LIB_EEPROM_WRITE(Dest, Src, Length) memcpy(Dest, Src, Length)
 #define EEFS_LIB_EEPROM_READ(Dest, Src, Length)  memcpy(Dest, Src, Length)
 #define EEFS_LIB_EEPROM_FLUSH
+#define EEFS_LIB_EEPROM_SYNC
 
 /* These macros define the lock and unlock interface functions used to guarentee
  * exclusive access to shared resources.  Defaults to undefined since it is implementation dependent */
 #define EEFS_LIB_LOCK                            semTake(EEFS_semId, WAIT_FOREVER);  
 #define EEFS_LIB_UNLOCK                          semGive(EEFS_semId);
 
+/* These macros define the per volume lock that protects an Inode Table.  A mutex semaphore is created for each
+ * volume when it is mounted and the SEM_ID is kept in the Inode Table */
+#define EEFS_LIB_INODE_LOCK_CREATE(InodeTable)   ((InodeTable)->LockId = (uint32)semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE))
+#define EEFS_LIB_INODE_LOCK_DELETE(InodeTable)   semDelete((SEM_ID)(InodeTable)->LockId)
+#define EEFS_LIB_INODE_LOCK(InodeTable)          semTake((SEM_ID)(InodeTable)->LockId, WAIT_FOREVER)
+#define EEFS_LIB_INODE_UNLOCK(InodeTable)        semGive((SEM_ID)(InodeTable)->LockId)
+
+/* These macros define the per file descriptor lock that protects an open file during data transfers.  A mutex
+ * semaphore is created for each entry of a file descriptor pool and the SEM_ID is kept in the File Descriptor */
+#define EEFS_LIB_FD_LOCK_CREATE(FileDescriptor)  ((FileDescriptor)->LockId = (uint32)semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE))
+#define EEFS_LIB_FD_LOCK_DELETE(FileDescriptor)  semDelete((SEM_ID)(FileDescriptor)->LockId)
+#define EEFS_LIB_FD_LOCK(FileDescriptor)         semTake((SEM_ID)(FileDescriptor)->LockId, WAIT_FOREVER)
+#define EEFS_LIB_FD_UNLOCK(FileDescriptor)       semGive((SEM_ID)(FileDescriptor)->LockId)
+
 /* This macro defines the time interface function.  Defaults to time(NULL) */
 #define EEFS_LIB_TIME                            time(NULL)
 
@@ -75,9 +75,11 @@ int                             EEFS_Funread(EEFS_OpenFileDescriptor_t *OpenFile
 int                             EEFS_ReadDir(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, DIR *Directory);
 int                             EEFS_Fstat(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, struct stat *StatBuffer);
 int                             EEFS_Rename(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, char *NewFilename);
+int                             EEFS_Truncate(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Length);
 int                             EEFS_ChkDsk(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Arg);
 int                             EEFS_FreeSpace(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, uint32 *FreeCount);
 int                             EEFS_FreeSpace64(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, uint64 *FreeCount);
+int                             EEFS_Flush(EEFS_OpenFileDescriptor_t *OpenFileDescriptor);
 char                           *EEFS_ExtractFilename(char *Path);
 
 /*
@@ -169,6 +171,46 @@ int EEFS_DevDelete(EEFS_DeviceDescriptor_t *DeviceDescriptor)
     
 } /* End of EEFS_DevDelete() */
 
+/* Returns the space totals of a eeprom file system device, including the space in the slots of deleted files and the unused
+ * space at the end of each file.  Returns OK on success or ERROR if there was an error. */
+int EEFS_DevSpaceInfo(EEFS_DeviceDescriptor_t *DeviceDescriptor, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    int ReturnCode;
+
+    if ((DeviceDescriptor != NULL) && (SpaceInfo != NULL)) {
+
+        EEFS_LibGetSpaceInfo(&DeviceDescriptor->InodeTable, SpaceInfo);
+        ReturnCode = OK;
+    }
+    else { /* invalid device descriptor or space info */
+        ReturnCode = ERROR;
+        errnoSet(EINVAL);
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_DevSpaceInfo() */
+
+/* Waits until every change that has been made to a eeprom file system device has been programmed into eeprom.  Returns OK
+ * on success or ERROR if there was an error. */
+int EEFS_DevSync(EEFS_DeviceDescriptor_t *DeviceDescriptor)
+{
+    int ReturnCode;
+
+    if (DeviceDescriptor != NULL) {
+
+        EEFS_LibSync(&DeviceDescriptor->InodeTable);
+        ReturnCode = OK;
+    }
+    else { /* invalid device descriptor */
+        ReturnCode = ERROR;
+        errnoSet(EINVAL);
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_DevSync() */
+
 /* Create a new file or re-write an existing file.  The EEFS does not support directories so a new directory cannot be created
  * with this function.  Returns a pointer to a EEFS_OpenFileDescriptor_t on success or ERROR if there was an error. */
 int EEFS_Creat(EEFS_DeviceDescriptor_t *DeviceDescriptor, char *Path, int Mode)
@@ -492,6 +534,10 @@ int EEFS_Ioctl(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Function, int
             return(EEFS_Rename(OpenFileDescriptor, (char *)Arg));
             break;
 
+        case FIOTRUNC: /* truncate a file to a specified length */
+            return(EEFS_Truncate(OpenFileDescriptor, Arg));
+            break;
+
         case FIONFREE: /* return amount of free space */
             return(EEFS_FreeSpace(OpenFileDescriptor, (uint32 *)Arg));
             break;
@@ -504,6 +550,11 @@ int EEFS_Ioctl(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Function, int
             return(EEFS_ChkDsk(OpenFileDescriptor, Arg));
             break;
 
+        case FIOFLUSH: /* write the size of a file, or the whole file system, to eeprom */
+        case FIOSYNC:
+            return(EEFS_Flush(OpenFileDescriptor));
+            break;
+
         default:
             errnoSet(ENOTSUP);
             return(ERROR);
@@ -639,10 +690,10 @@ int EEFS_ReadDir(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, DIR *Directory)
                  * InodeIndex variable back to 0. */
                 if (Directory->dd_cookie == 0) { OpenFileDescriptor->DirectoryDescriptor->InodeIndex = 0; }
 
-                /* the EEFS function returns an entry for all slots, even empty ones, however for this implementation we want
-                 * to skip the empty slots */
+                /* the EEFS function returns an entry for all slots, even empty ones and extents, however for this implementation
+                 * we want to skip them */
                 DirectoryEntry = EEFS_LibReadDir(OpenFileDescriptor->DirectoryDescriptor);
-                while ((DirectoryEntry != NULL) && (DirectoryEntry->InUse == FALSE)) {
+                while ((DirectoryEntry != NULL) && (DirectoryEntry->InUse != TRUE)) {
                     DirectoryEntry = EEFS_LibReadDir(OpenFileDescriptor->DirectoryDescriptor);
                 }
 
@@ -781,6 +832,51 @@ int EEFS_Rename(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, char *Path)
     
 } /* End of EEFS_Rename() */
 
+/* Truncates a file that is open for write and keeps the space of the file so it can be rewritten.  The file can not be
+ * made longer.  Returns OK on success or ERROR if there was an error. */
+int EEFS_Truncate(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Length)
+{
+    int32                   Status;
+    int                     ReturnCode;
+
+    if (OpenFileDescriptor != NULL) {
+
+        if (OpenFileDescriptor->Type == EEFS_FILE) {
+
+            if (Length >= 0) {
+
+                Status = EEFS_LibFtruncate(OpenFileDescriptor->FileDescriptor, Length);
+                if (Status == EEFS_SUCCESS) {
+                    ReturnCode = OK;
+                }
+                else if (Status == EEFS_PERMISSION_DENIED) {
+                    ReturnCode = ERROR;
+                    errnoSet(EBADF);
+                }
+                else { /* invalid length or EEFS file descriptor */
+                    ReturnCode = ERROR;
+                    errnoSet(EINVAL);
+                }
+            }
+            else { /* invalid length */
+                ReturnCode = ERROR;
+                errnoSet(EINVAL);
+            }
+        }
+        else { /* not a EEFS_FILE file descriptor */
+            ReturnCode = ERROR;
+            errnoSet(EBADF);
+        }
+    }
+    else { /* invalid open file descriptor */
+        ReturnCode = ERROR;
+        errnoSet(EBADF);
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_Truncate() */
+
 /* Checks the file system for errors and dumps the Inode Table */
 int EEFS_ChkDsk(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Arg)
 {
@@ -809,16 +905,18 @@ int EEFS_ChkDsk(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, int Arg)
     
 } /* End of EEFS_ChkDsk() */
 
-/* Returns the file system free space */
+/* Returns the contiguous free space of the file system, EEFS_DevSpaceInfo() also returns the space that can be reclaimed */
 int EEFS_FreeSpace(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, uint32 *FreeCount)
 {
+    EEFS_SpaceInfo_t        SpaceInfo;
     int                     ReturnCode;
     
     if (OpenFileDescriptor != NULL) {
 
         if (OpenFileDescriptor->Type == EEFS_DIRECTORY) {
 
-            *FreeCount = OpenFileDescriptor->DirectoryDescriptor->InodeTable->FreeMemorySize;
+            EEFS_LibGetSpaceInfo(OpenFileDescriptor->DirectoryDescriptor->InodeTable, &SpaceInfo);
+            *FreeCount = SpaceInfo.FreeSpace;
             ReturnCode = OK;
         }
         else { /* not a EEFS_DIRECTORY file descriptor */
@@ -835,16 +933,18 @@ int EEFS_FreeSpace(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, uint32 *FreeCo
     
 } /* End of EEFS_FreeSpace() */
 
-/* Returns the file system free space */
+/* Returns the contiguous free space of the file system */
 int EEFS_FreeSpace64(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, uint64 *FreeCount)
 {
+    EEFS_SpaceInfo_t        SpaceInfo;
     int                     ReturnCode;
 
     if (OpenFileDescriptor != NULL) {
 
         if (OpenFileDescriptor->Type == EEFS_DIRECTORY) {
 
-            *FreeCount = OpenFileDescriptor->DirectoryDescriptor->InodeTable->FreeMemorySize;
+            EEFS_LibGetSpaceInfo(OpenFileDescriptor->DirectoryDescriptor->InodeTable, &SpaceInfo);
+            *FreeCount = SpaceInfo.FreeSpace;
             ReturnCode = OK;
         }
         else { /* not a EEFS_DIRECTORY file descriptor */
@@ -861,6 +961,38 @@ int EEFS_FreeSpace64(EEFS_OpenFileDescriptor_t *OpenFileDescriptor, uint64 *Free
 
 } /* End of EEFS_FreeSpace64() */
 
+/* Makes the data written to an open file so far survive a reset without closing the file, or for a directory waits until
+ * every change that has been made to the file system has been programmed into eeprom */
+int EEFS_Flush(EEFS_OpenFileDescriptor_t *OpenFileDescriptor)
+{
+    int                     ReturnCode;
+
+    if (OpenFileDescriptor != NULL) {
+
+        if (OpenFileDescriptor->Type == EEFS_FILE) {
+
+            if (EEFS_LibFsync(OpenFileDescriptor->FileDescriptor) == EEFS_SUCCESS) {
+                ReturnCode = OK;
+            }
+            else { /* error in EEFS_LibFsync */
+                ReturnCode = ERROR;
+                errnoSet(EBADF);
+            }
+        }
+        else { /* EEFS_DIRECTORY file descriptor */
+            EEFS_LibSync(OpenFileDescriptor->DirectoryDescriptor->InodeTable);
+            ReturnCode = OK;
+        }
+    }
+    else { /* invalid open file descriptor */
+        ReturnCode = ERROR;
+        errnoSet(EBADF);
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_Flush() */
+
 /* Strip leading slashes from the specified path */
 char *EEFS_ExtractFilename(char *Path)
 {
@@ -76,6 +76,15 @@ int                 EEFS_DevCreate(int DriverNumber, char *DeviceName, uint32 Ba
  * was an error.  */
 int                 EEFS_DevDelete(EEFS_DeviceDescriptor_t *DeviceDescriptor);
 
+/* Returns the space totals of a eeprom file system device in SpaceInfo.  This includes the space in the slots of deleted files,
+ * which can be reclaimed by reusing them or by compacting the file system, and the unused space at the end of each file.
+ * Returns OK on success or ERROR if there was an error. */
+int                 EEFS_DevSpaceInfo(EEFS_DeviceDescriptor_t *DeviceDescriptor, EEFS_SpaceInfo_t *SpaceInfo);
+
+/* Waits until every change that has been made to a eeprom file system device has been programmed into eeprom.  Only needed
+ * when EEFS_LIB_EEPROM_FLUSH returns before eeprom is programmed.  Returns OK on success or ERROR if there was an error. */
+int                 EEFS_DevSync(EEFS_DeviceDescriptor_t *DeviceDescriptor);
+
 #endif
 
 /************************/
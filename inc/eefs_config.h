@@ -30,10 +30,50 @@
 /* Maximum number of file descriptors */
 #define EEFS_MAX_OPEN_FILES                 20
 
+/* Maximum number of file descriptor pools, including the shared pool
+   of EEFS_MAX_OPEN_FILES file descriptors */
+#define EEFS_MAX_FILE_DESCRIPTOR_POOLS      4
+
+/* Maximum number of directory descriptors, i.e. the number of directory
+   listings that can be in progress at one time across all file systems */
+#define EEFS_MAX_OPEN_DIRECTORIES           4
+
 /* Default number of spare bytes added to the end of a slot when a 
-   new file is created by calling the EEFS_LibCreat function */
+   new file is created by calling the EEFS_LibCreat function.  This is
+   the Parameter of the fixed spare byte policy each volume starts with */
 #define EEFS_DEFAULT_CREAT_SPARE_BYTES      512
 
+/* Number of removed files per volume whose MaxFileSize is remembered by
+   the learned spare byte policy, so a file that is removed and created
+   again gets back a slot of the same size */
+#define EEFS_SPARE_HISTORY_SIZE             8
+
+/* Number of buckets in the ram filename hash index used to locate files
+   by name.  A value close to EEFS_MAX_FILES keeps the hash chains short */
+#define EEFS_FILENAME_HASH_SIZE             64
+
+/* Set to TRUE to keep a write-through ram copy of every file header in the
+   inode table so metadata operations do not read file headers from EEPROM */
+#define EEFS_HEADER_CACHE                   FALSE
+
+/* Number of bytes copied at a time when EEFS_LibCompact moves a file.  This
+   should be the eeprom page size, each chunk ends on a page boundary */
+#define EEFS_COMPACT_PAGE_SIZE              256
+
+/* Set to TRUE to let a file that outgrows its slot continue in extents that
+   are chained from its file header.  This adds a field to the file header,
+   so the file system image must be built with the same setting */
+#define EEFS_EXTENT_CHAINING                FALSE
+
+/* Minimum number of bytes in an extent that is added to a file when a write
+   reaches the end of the last slot of the file */
+#define EEFS_MIN_EXTENT_SIZE                512
+
+/* Set to TRUE to let a write that reaches the end of the slot of a file
+   move the file to a larger slot in free memory, as long as no other file
+   descriptor has the file open */
+#define EEFS_RELOCATE_ON_GROW               FALSE
+
 #endif 
 
 /************************/
@@ -47,7 +47,8 @@
  * File Allocation Table:
  *   The File Allocation Table defines where in memory each slot starts as well as the maximum slot size for each file.
  *   This table is a fixed size regardless of how many files actually reside in the file system and never changes unless
- *   a new file is added to the file system using the EEFS_LibCreat() function or the whole file system is reloaded.  The
+ *   a new file is added to the file system using the EEFS_LibCreat() function, the file system is compacted using the
+ *   EEFS_LibCompact() function or the whole file system is reloaded.  The
  *   maximum number of files that can be added to the file system is determined at compile time by the EEFS_MAX_FILES
  *   define.  It is important to choose this number carefully since a code patch would be required to change it.  The file
  *   offsets for each file defined in the File Allocation Table are relative offsets from the beginning of the file system
@@ -58,52 +59,202 @@
  *
  * File Header:
  *   Each slot in the file system starts with a File Header.  The File Header contains information about the file
- *   contained in the slot.  The File Header will be all 0's if the file has been deleted or is unused.
+ *   contained in the slot.  When a file is deleted only the InUse field of its File Header is cleared, and the other fields
+ *   keep their old values, see Field Writes.
  *
  * File Data:
  *   File Data starts immediately following the File Header and may or may not use all of the available space in the slot.
  *
+ * Compaction:
+ *   Deleting a file only clears the InUse flag in its File Header, so the slot of a deleted file is not available to new
+ *   files.  EEFS_LibCompact() recovers this space by sliding files that are in use down over the slots of deleted files, one
+ *   file at a time, until the deleted slots reach the end of the file system where their space is returned to free memory.
+ *   Each slot keeps its File Allocation Table entry, so once a file system has been compacted the slots are no longer in the
+ *   same order in memory as in the File Allocation Table.  A deleted slot whose space has been returned to free memory keeps
+ *   its File Header so its File Allocation Table entry remains valid, unless it is the last entry in the table in which case
+ *   the entry is removed.  File data is copied one EEFS_COMPACT_PAGE_SIZE page at a time.  Before each step a compaction
+ *   journal is written to the start of free memory that describes the new File Allocation Table entries, and while a file is
+ *   moved the journal records how much of the file has been copied.  If a reset occurs during a step the journal is found by
+ *   EEFS_LibInitFS() and the step is completed before the file system is mounted.  Note that tools that read the file system
+ *   directly, such as the Micro EEPROM File System, will not see a file that was being moved when the reset occurred until
+ *   the file system has been mounted once.  Compaction is not possible while a file of unknown size is being created, and a
+ *   file that is open is not moved.
+ *
+ * Slot Reuse:
+ *   The Inode Table keeps a list of the slots of deleted files in order of increasing MaxFileSize, linked through the
+ *   NextFreeSlot field.  The list is built by EEFS_LibInitFS() and is updated every time a File Header is written by the
+ *   file system api.  When the caller of EEFS_LibCreatSized() supplies the expected size of a new file, the file is created
+ *   in the smallest deleted slot that can hold it, so both the File Allocation Table entry and the memory of the slot are
+ *   reused and the File Allocation Table does not change.  Any space left over in the slot remains available for the file to
+ *   grow.  If no deleted slot is large enough, or the size is not known, the file is created in free memory.  A deleted slot
+ *   that ends at the start of free memory is then reused as the start of the new file.  Otherwise the new file takes over the
+ *   File Allocation Table entry of a deleted slot that EEFS_LibCompact() has reduced to a File Header, and the slot in front
+ *   of it is extended over that File Header.  A new File Allocation Table entry is only used when there is no entry to
+ *   recycle.  If a reset occurs before a file created in a deleted slot is closed the file will exist with a size of 0, and
+ *   EEFS_LibInitFS() recovers any memory between slots that was left behind by the reset.
+ *
+ * Concurrent File Creation:
+ *   A file created by EEFS_LibCreat() owns all of free memory until it is closed since its size is not known, so only one
+ *   such file can be created at a time.  EEFS_LibCreatSized() instead reserves a slot of exactly the requested size, either a
+ *   deleted slot or a new slot taken from free memory, and adds it to the File Allocation Table before it returns.  The new
+ *   file is then open for writing like any existing file, so any number of sized creats can be in progress at the same time
+ *   and they do not block EEFS_LibCreat() or EEFS_LibCompact().  A sized creat that needs free memory does have to wait for
+ *   a creat of unknown size to complete.  If a reset occurs before a sized creat is closed the file will exist with a size
+ *   of 0.
+ *
+ * Extent Chaining:
+ *   By default a write that reaches the end of the slot of a file is cut short.  When EEFS_EXTENT_CHAINING is set to TRUE
+ *   in eefs_config.h the write instead continues in an extent, which is another slot that is taken the same way as the slot
+ *   of a sized creat and is at least EEFS_MIN_EXTENT_SIZE bytes.  The File Header of an extent has its InUse flag set to
+ *   EEFS_EXTENT_IN_USE, and the NextExtent field of each File Header links the slots of a file in order, so append heavy
+ *   files such as event logs can grow without being rewritten.  The FileSize in the File Header of the file is the size of
+ *   the whole file and every slot except the last one is full.  The slots of a file are linked by their File Allocation
+ *   Table entries, which do not change when compaction moves a slot, and a slot that is followed by an extent is never
+ *   resized.  EEFS_LibRead(), EEFS_LibWrite() and EEFS_LibLSeek() follow the chain using the ram copy of the links in the
+ *   Inode Table.  An extent is written before it is linked to the file and EEFS_LibRemove() deletes the file before its
+ *   extents, so a reset can only leave extents that are not linked to a file, and these are deleted by EEFS_LibInitFS().
+ *   Extents stay with a file that is truncated by O_TRUNC or EEFS_LibFtruncate() until the file is removed or truncated by
+ *   EEFS_LibTruncate() or EEFS_LibFtruncateRelease().  A file that is being created by EEFS_LibCreat() already owns all of
+ *   free memory and does not get extents.  Tools that read the file system directly, such as the Micro EEPROM File System,
+ *   only see the part of a file that is in its first slot.
+ *
+ * Resizing Files:
+ *   EEFS_LibResize() grows the slot of a file that is not open.  A slot that ends at free memory is extended in place,
+ *   otherwise the File Header and data of the file are copied to a new slot at the start of free memory one
+ *   EEFS_COMPACT_PAGE_SIZE page at a time, and the File Allocation Table entry of the file is then pointed at the copy
+ *   in a single write.  The old slot is given a File Allocation Table entry as a deleted slot so it can be reused or
+ *   reclaimed by EEFS_LibCompact().  A reset before the File Allocation Table entry is written leaves the file in its old
+ *   slot, and a reset after it leaves at most some space that EEFS_LibInitFS() recovers.  When EEFS_RELOCATE_ON_GROW is
+ *   set to TRUE in eefs_config.h EEFS_LibWrite() does the same when a write reaches the end of the slot of a file that is
+ *   only open by the File Descriptor being written, so the file stays contiguous and keeps the fastest read path.  If
+ *   extent chaining is also enabled a file is only given an extent when it cannot be moved.
+ *
+ * Truncating Files:
+ *   EEFS_LibTruncate() and EEFS_LibFtruncateRelease() set the FileSize in the File Header of a file, then release the space
+ *   past the new end of the file.  Extents that are no longer needed are unlinked from the file and deleted, and if the last
+ *   slot of the file ends at free memory it is shrunk to the new size plus the spare bytes given by the spare byte policy of
+ *   the volume, which returns the rest of the slot to free memory without copying any data.  The space of a file that is
+ *   open by another File Descriptor is not released since their FileDataPointers may point into it.  EEFS_LibFtruncate()
+ *   only sets the FileSize and keeps all of the space of the file, since it is also used by drivers to truncate a file that
+ *   is opened with O_TRUNC and is about to be rewritten.  Opening a file with O_TRUNC only sets the size of the file when it
+ *   is closed and does not release any space.
+ *
+ * Spare Bytes:
+ *   The slot of a file that is created by EEFS_LibCreat() is sized when the file is closed to the size of the file plus a
+ *   number of spare bytes that leave room for the file to grow.  The number of spare bytes is chosen by the spare byte policy
+ *   of the volume, which is set by EEFS_LibSetSparePolicy().  EEFS_SPARE_POLICY_FIXED adds the same number of bytes to every
+ *   file and is the default, with EEFS_DEFAULT_CREAT_SPARE_BYTES bytes.  EEFS_SPARE_POLICY_PERCENT adds a percentage of the
+ *   size of the file, and EEFS_SPARE_POLICY_POWER_OF_TWO rounds the slot up to the next power of two bytes, so large files
+ *   get proportionally more room and small files waste little.  EEFS_SPARE_POLICY_LEARNED gives a file that is removed and
+ *   then created again a slot the size of its old slot and its extents.  The Inode Table remembers the name and capacity of
+ *   the last EEFS_SPARE_HISTORY_SIZE files that were removed for this, so nothing is stored in EEPROM.  A port can also
+ *   supply its own policy function with EEFS_SPARE_POLICY_CUSTOM.  The same policy sizes the slot of a file that is shrunk
+ *   by EEFS_LibTruncate() and the headroom given to a file that is moved by EEFS_RELOCATE_ON_GROW.  EEFS_LibGetSpareStats()
+ *   returns how many spare bytes have been given out and how often a write reached the end of the last slot of a file, so
+ *   the policy can be tuned to trade unused EEPROM against files that have to be moved or extended.
+ *
  * Inode Table:
  *   The Inode Table is a ram table that is used by the file system api to access the file system and is similar in structure
  *   to the File Allocation Table.  The Inode table is initialized when the function EEFS_LibInitFS() is called and once the
  *   Inode table is initialized the File Allocation Table is no longer used. One important difference between the File
  *   Allocation Table and the Inode Table is that the Inode Table contains physical address pointers to the start of each file
- *   instead of relative offsets.  Note also that the Inode table does not cache any information about the file in ram.  This
- *   means that the file could be patched or reloaded to EEPROM without the need to patch the Inode Table, i.e. the file
- *   updates are available to the file system immediately.  A disadvantage to this approach is that each File Header must be
- *   read from EEPROM when searching the file system for a specific file, for example when a file is opened.
+ *   instead of relative offsets.  The Inode Table also keeps a ram copy of the Filename and InUse flag from each File Header
+ *   so that files can be located without reading EEPROM, see Filename Hash Index below.  This means that if a File Header
+ *   is patched or reloaded to EEPROM without going through the file system api then the file system must be remounted, i.e.
+ *   EEFS_LibFreeFS() followed by EEFS_LibInitFS(), before the change is visible to the file system.  The file data itself is
+ *   not cached, so patches to the File Data are available to the file system immediately.
+ *
+ * Filename Hash Index:
+ *   Every open, stat, rename, remove and create must first locate a file by name.  To avoid reading every File Header from
+ *   EEPROM for each lookup the Inode Table contains a hash index of the Filenames of all files that are in use.  The index
+ *   is a table of EEFS_FILENAME_HASH_SIZE buckets, each bucket is the head of a chain of Inode Table entries linked through
+ *   the NextHashEntry field.  The index is built by EEFS_LibInitFS() and is updated every time a File Header is written by
+ *   the file system api.
+ *
+ * File Header Cache:
+ *   When EEFS_HEADER_CACHE is set to TRUE in eefs_config.h the Inode Table keeps a ram copy of every File Header, not just the
+ *   Filename and InUse flag.  The copy is loaded by EEFS_LibInitFS() and is updated write-through every time a File Header is
+ *   written, so open, stat, fstat, readdir, remove, rename, set attributes and close never read File Headers from EEPROM.
+ *   This is intended for metadata heavy workloads such as directory polling, at the cost of some additional ram in the Inode
+ *   Table.  The same remount rule applies to File Headers that are patched without going through the file system api.
+ *
+ * Field Writes:
+ *   Operations that only change some fields of a File Header only write those fields to EEPROM.  Remove only clears the InUse
+ *   flag, rename only writes the Filename, set attributes only writes the Attributes, and close and truncate only write the
+ *   Crc, FileSize and ModificationDate.  The other fields of a deleted File Header are left as they were and are ignored, and
+ *   the File Header is written in full when the slot is reused.
+ *
+ * Space Accounting:
+ *   The Inode Table keeps running totals of the space used by the volume so EEFS_LibGetSpaceInfo(), and the statvfs and
+ *   free space calls of the drivers, never have to scan the Inode Table.  Each Inode Table entry records the InUse flag, slot
+ *   size and FileSize that it last added to the totals, and every time a File Header or a File Allocation Table entry is
+ *   written the old values are subtracted and the new values are added.  AllocatedSpace covers the slots of files and
+ *   extents, SlackSpace the unused bytes at the end of those slots, and DeletedSpace the slots of deleted files, which are
+ *   reclaimed by reusing them or by EEFS_LibCompact().  FreeSpace is the contiguous free memory after the last slot.  While a
+ *   file of unknown size is being created its slot covers all of free memory, so until the file is closed FreeSpace is 0 and
+ *   the free memory is counted as slack.
  *
  * File Descriptor Table:
- *   The File Descriptor Table manages all File Descriptors for the EEPROM File System.  There is only one File Descriptor
- *   Table that is shared by all EEPROM File System volumes.  The maximum number of files that can be open at one time is
- *   determined at compile time by the EEFS_MAX_OPEN_FILES define.
+ *   The File Descriptor Table manages all File Descriptors for the EEPROM File System.  By default there is only one File
+ *   Descriptor Table that is shared by all EEPROM File System volumes.  The maximum number of files that can be open at one
+ *   time in the shared table is determined at compile time by the EEFS_MAX_OPEN_FILES define.  A volume can instead be given
+ *   its own pool of File Descriptors by calling EEFS_LibInitFileDescriptorPool() after the volume is mounted.  The pool is
+ *   sized by the caller at run time, and a busy volume can then no longer use up the File Descriptors of another volume.
+ *   Up to EEFS_MAX_FILE_DESCRIPTOR_POOLS pools, including the shared pool, may exist at one time.  The upper bits of each
+ *   File Descriptor identify the pool and the lower bits identify the entry in the pool, and the free entries of each pool
+ *   are kept in a linked list so allocating and freeing File Descriptors takes constant time.  Each Inode Table entry
+ *   counts the File Descriptors that are open for read, write and creat on that file, and the Inode Table counts the File
+ *   Descriptors open on the volume, so checking whether a file or volume is in use never requires a search of the File
+ *   Descriptor Table.
  *
  * Directory Descriptor Table:
- *   The Directory Descriptor Table manages the Directory Descriptor for the EEPROM File System.  There is currently only
- *   one Directory Descriptor that is shared by all EEPROM File System volumes.
+ *   The Directory Descriptor Table manages the Directory Descriptors for the EEPROM File System.  The table is shared by all
+ *   EEPROM File System volumes and the maximum number of directory listings that can be in progress at one time is
+ *   determined at compile time by the EEFS_MAX_OPEN_DIRECTORIES define.  Each Directory Descriptor contains its own
+ *   Directory Entry, so the entry returned by EEFS_LibReadDir() is only overwritten by the next read of the same Directory
+ *   Descriptor.  EEFS_LibReadDir_r() copies the entry into a caller supplied buffer instead.  The Inode Table counts the
+ *   Directory Descriptors open on the volume.  Directory entries are built from the ram copy of the File Headers in the
+ *   Inode Table, so reading a directory never reads EEPROM.  EEFS_LibReadDirBatch() returns many entries per call while
+ *   holding the volume lock once, and can optionally skip the slots of deleted files.
  *
  * EEPROM Access:
  *   The EEPROM File System software never directly reads or writes to EEPROM, instead it uses implementation specific EEPROM
  *   interface functions.  Since not all EEPROM is memory mapped, some EEPROM implementations may require implementation
  *   specific functions for accessing EEPROM.  The implementation specific EEPROM interface functions are defined as macros
  *   in the file eefs_macros.h.  By default these macros are defined to use memcpy.  Note also that the EEPROM interface
- *   functions are protected from shared access by the EEPROM File System however there is nothing that prevents other
- *   processes from calling the EEPROM interface functions from outside of the EEPROM File System.
+ *   functions may be called by more than one task at a time for different volumes or files, see Mutual Exclusion below, and
+ *   there is nothing that prevents other processes from calling the EEPROM interface functions from outside of the EEPROM
+ *   File System.  EEFS_LIB_EEPROM_FLUSH is called at the end of each operation that changes the file system and may return
+ *   before the data has been programmed, for example when it only queues the data for a background task.  A port like that
+ *   defines EEFS_LIB_EEPROM_SYNC to wait until everything has been programmed, and EEFS_LibSync() calls it for applications
+ *   that need their changes to be durable.  EEFS_LIB_EEPROM_SYNC defaults to EEFS_LIB_EEPROM_FLUSH.
  *
  * Mutual Exclusion:
- *   Mutual exclusion is implemented by the functions EEFS_LibLock and EEFS_LibUnlock.  Since the EEPROM File System is not
- *   intended to be used very often and to keep things simple it was decided to implement a single locking mechanism that is
- *   shared by all EEPROM File System volumes.  This locking mechanism simply locks the shared resource at the start of each
- *   function and unlocks the shared resource at the end of each function.  It is recommended that semaphores be used as the
- *   locking mechanism vs disabling interrupts.  Note that since the shared resource is locked for all lower level functions,
- *   lower level functions should not be called recursively.  The implementation of the EEFS_LibLock and EEFS_LibUnlock
- *   functions are defined as macros in the file eefs_macros.h.
- *
- *   The EEFS_Lock and EEFS_Unlock functions are intended to protect the following resources from shared access:
- *   1. File Descriptor Table - File Descriptors are maintained in a single table that is shared by all EEFS file systems.
- *   2. Inode Table - Some functions require that the state of the file system be preserved during critical sections of code.
- *   3. File Directory Descriptor Table - The File Directory Table is shared by all EEFS file systems.
- *   4. EEPROM interface routines - The implementation of these functions is unknown since they may be implementation specific.
+ *   Mutual exclusion is implemented by three levels of locks so that independent volumes and independent files can be
+ *   accessed in parallel.  The implementation of each lock is defined as a set of macros in the file eefs_macros.h.  It is
+ *   recommended that semaphores be used as the locking mechanism vs disabling interrupts.  Note that since the locks are not
+ *   required to be recursive, lower level functions should not be called recursively.
+ *
+ *   1. Global Lock (EEFS_LIB_LOCK, EEFS_LIB_UNLOCK) - A short lock shared by all EEFS file systems that protects the File
+ *      Descriptor Pools and the Directory Descriptor Table.  It is only held while a File Descriptor or Directory Descriptor
+ *      is allocated or freed and is never held during EEPROM access.
+ *   2. Volume Lock (EEFS_LIB_INODE_LOCK, EEFS_LIB_INODE_UNLOCK) - One lock per Inode Table that protects the Inode Table,
+ *      the File Headers and the File Allocation Table of the volume.  It is held by all functions that locate, create,
+ *      modify or close files on the volume.  The lock is created by EEFS_LibInitFS() and deleted by EEFS_LibFreeFS() using
+ *      the EEFS_LIB_INODE_LOCK_CREATE and EEFS_LIB_INODE_LOCK_DELETE macros.  A port may optionally define the
+ *      EEFS_LIB_INODE_RDLOCK and EEFS_LIB_INODE_WRLOCK macros to make this a reader/writer lock.  The read lock is taken
+ *      by functions that do not modify the volume: EEFS_LibStat(), EEFS_LibFstat(), EEFS_LibReadDir(), EEFS_LibOpen()
+ *      without O_CREAT, and EEFS_LibClose() and EEFS_LibFsync() of a file that was only open for read.  All other
+ *      functions take the write lock.  Since opens and closes may run in parallel under the read lock, the open file counts
+ *      in the Inode Table are updated while holding the global lock.
+ *   3. File Descriptor Lock (EEFS_LIB_FD_LOCK, EEFS_LIB_FD_UNLOCK) - One lock per File Descriptor that protects the file
+ *      position and size of an open file.  EEFS_LibRead(), EEFS_LibWrite() and EEFS_LibLSeek() only hold this lock, so
+ *      large data transfers do not block access to other files or volumes.  The locks are created when the File Descriptor
+ *      Pool is initialized using the EEFS_LIB_FD_LOCK_CREATE and EEFS_LIB_FD_LOCK_DELETE macros.
+ *
+ *   When more than one lock is held they are always taken in the order File Descriptor Lock, Volume Lock, Global Lock.
+ *   Since the EEPROM interface functions may now be called by more than one task at a time, implementation specific
+ *   EEPROM interface functions must be reentrant or provide their own locking.
  *
  * Time Stamps:
  *   Time Stamps are implemented by the function EEFS_LibTime.  Time stamps are based on the standard library time_t.  The
@@ -166,6 +317,7 @@
  */
 
 #define EEFS_FILESYS_MAGIC              0xEEF51234
+#define EEFS_COMPACT_MAGIC              0xEEF5C0DE
 #define EEFS_MAX_FILENAME_SIZE          40
 
 /*
@@ -175,6 +327,14 @@
 #define EEFS_ATTRIBUTE_NONE             0
 #define EEFS_ATTRIBUTE_READONLY         1
 
+/*
+ * File Header InUse Values
+ */
+
+/* The InUse flag is TRUE for a file and FALSE for a deleted slot.  The slot of an extent of a file has this value instead,
+ * see Extent Chaining. */
+#define EEFS_EXTENT_IN_USE              2
+
 /*
  * File Modes
  */
@@ -187,6 +347,31 @@
 #define EEFS_FWRITE                     2       /* (O_WRONLY + 1) */
 #define EEFS_FCREAT                     4
 
+/*
+ * Directory Read Flags
+ */
+
+/* Used with EEFS_LibReadDirBatch() to only return the entries of files that are in use */
+#define EEFS_READDIR_SKIP_DELETED       1
+
+/*
+ * Compaction Limits
+ */
+
+/* Used with EEFS_LibCompact() to compact the whole file system in one call */
+#define EEFS_COMPACT_NO_LIMIT           0xFFFFFFFF
+
+/*
+ * Spare Byte Policies
+ */
+
+/* Used with EEFS_LibSetSparePolicy() to choose the spare bytes added to the slot of a new file, see Spare Bytes */
+#define EEFS_SPARE_POLICY_FIXED         0       /* Parameter spare bytes */
+#define EEFS_SPARE_POLICY_PERCENT       1       /* Parameter percent of the file size */
+#define EEFS_SPARE_POLICY_POWER_OF_TWO  2       /* slot rounded up to a power of two, at least Parameter bytes */
+#define EEFS_SPARE_POLICY_LEARNED       3       /* capacity of the removed file of the same name, otherwise Parameter bytes */
+#define EEFS_SPARE_POLICY_CUSTOM        4       /* spare bytes returned by a caller supplied function */
+
 /*
  * Error Codes
  */
@@ -238,22 +423,59 @@ typedef struct
     time_t                              ModificationDate;
     time_t                              CreationDate;
     char                                Filename[EEFS_MAX_FILENAME_SIZE];
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    uint32                              NextExtent;         /* one more than the inode of the next extent of the file, 0 if none */
+#endif
 } EEFS_FileHeader_t;
 
 typedef struct
 {
-    void                               *FileHeaderPointer;
-    uint32                              MaxFileSize;
-} EEFS_InodeTableEntry_t;
+    uint32                              Magic;              /* EEFS_COMPACT_MAGIC while a compaction step is in progress */
+    uint32                              InodeIndex[2];      /* the File Allocation Table entries updated by the step */
+    EEFS_FileAllocationTableEntry_t     File[2];            /* new File Allocation Table entries, File[1] is always a deleted slot */
+    uint32                              SourceOffset;       /* relative offset of the File Header of the file being moved to File[0], 0 if none */
+    uint32                              BytesCopied;        /* number of bytes of file data that are known to be copied */
+    EEFS_FileHeader_t                   FileHeader;         /* File Header of the file being moved */
+} EEFS_CompactJournal_t;
+
+typedef struct EEFS_InodeTable_s EEFS_InodeTable_t;
+
+/* Returns the number of spare bytes to add to the slot of a file of FileSize bytes.  PreviousMaxFileSize is the capacity of
+ * the removed file with the same Filename, or 0 if it is not known. */
+typedef uint32 (*EEFS_SparePolicyFunction_t)(char *Filename, uint32 FileSize, uint32 PreviousMaxFileSize, uint32 Parameter);
 
 typedef struct
 {
-    uint32                              BaseAddress;
-    void                               *FreeMemoryPointer;
-    uint32                              FreeMemorySize;
-    uint32                              NumberOfFiles;
-    EEFS_InodeTableEntry_t              File[EEFS_MAX_FILES];
-} EEFS_InodeTable_t;
+    uint32                              Policy;             /* EEFS_SPARE_POLICY_FIXED etc */
+    uint32                              Parameter;          /* meaning depends on the Policy */
+    EEFS_SparePolicyFunction_t          Function;           /* only used by EEFS_SPARE_POLICY_CUSTOM */
+} EEFS_SparePolicy_t;
+
+typedef struct
+{
+    char                                Filename[EEFS_MAX_FILENAME_SIZE]; /* empty if the entry is unused */
+    uint32                              MaxFileSize;        /* capacity of the file when it was removed */
+} EEFS_SpareHistoryEntry_t;
+
+typedef struct
+{
+    uint32                              SizedFiles;         /* number of new files whose slot was sized by the policy */
+    uint32                              LearnedFiles;       /* number of those that were sized from the spare history */
+    uint32                              SpareBytes;         /* total spare bytes added to those slots */
+    uint32                              RegrowEvents;       /* number of writes that reached the end of the last slot of a file */
+    uint32                              FailedRegrows;      /* number of those that were cut short since the file could not grow */
+} EEFS_SpareStats_t;
+
+typedef struct
+{
+    uint32                              TotalSpace;         /* size of the volume, including the File Allocation Table */
+    uint32                              AllocatedSpace;     /* total size of the slots of files and extents, including file headers */
+    uint32                              UsedSpace;          /* total FileSize of all files in use */
+    uint32                              SlackSpace;         /* total unused bytes at the end of the slots of files and extents */
+    uint32                              DeletedSpace;       /* total size of the slots of deleted files, including file headers */
+    uint32                              FreeSpace;          /* unallocated eeprom after the last file */
+    uint32                              FilesInUse;         /* number of files in use */
+} EEFS_SpaceInfo_t;
 
 typedef struct
 {
@@ -266,14 +488,71 @@ typedef struct
     uint32                              MaxFileSize;
     EEFS_InodeTable_t                  *InodeTable;
     uint32                              InodeIndex;
+    int32                               NextFree;           /* next free file descriptor in the pool, -1 if last */
+    uint32                              LockId;             /* implementation specific file descriptor lock, see eefs_macros.h */
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    int32                               ExtentIndex;        /* inode of the slot that contains FileDataPointer */
+    uint32                              ExtentOffset;       /* file offset of the first byte of that slot */
+#endif
 } EEFS_FileDescriptor_t;
 
 typedef struct
 {
-    uint32                              InUse;
-    uint32                              InodeIndex;
-    EEFS_InodeTable_t                  *InodeTable;
-} EEFS_DirectoryDescriptor_t;
+    EEFS_FileDescriptor_t              *FileDescriptorTable;
+    uint32                              NumberOfFileDescriptors;
+    uint32                              PoolIndex;          /* identifies the pool in the upper bits of each file descriptor */
+    int32                               FreeList;           /* first free file descriptor in the pool, -1 if none are free */
+    uint32                              FileDescriptorsInUse;
+    uint32                              FileDescriptorsHighWaterMark;
+} EEFS_FileDescriptorPool_t;
+
+typedef struct
+{
+    void                               *FileHeaderPointer;
+    uint32                              MaxFileSize;
+    uint32                              InUse;              /* ram copy of the File Header InUse flag */
+    int32                               NextHashEntry;      /* next inode in the same filename hash bucket, -1 if last */
+    int32                               NextFreeSlot;       /* next deleted slot in the free slot list, -1 if last */
+    char                                Filename[EEFS_MAX_FILENAME_SIZE]; /* ram copy of the File Header Filename */
+    uint16                              ReadCount;          /* number of file descriptors open for read access */
+    uint16                              WriteCount;         /* number of file descriptors open for write access */
+    uint16                              CreatCount;         /* number of file descriptors open for creat */
+    uint32                              FileSize;           /* ram copy of the File Header FileSize */
+    uint32                              CountedInUse;       /* InUse flag last added to the space totals, see Space Accounting */
+    uint32                              CountedSlotSize;    /* slot size last added to the space totals, 0 if not counted */
+    uint32                              CountedFileSize;    /* FileSize last added to the space totals */
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    int32                               NextExtent;         /* ram copy of the File Header NextExtent link, -1 if none */
+    int32                               Owner;              /* inode of the file an extent belongs to, -1 if none */
+#endif
+#if (EEFS_HEADER_CACHE == TRUE)
+    uint32                              Crc;                /* ram copy of the remaining File Header fields */
+    uint32                              Attributes;
+    time_t                              ModificationDate;
+    time_t                              CreationDate;
+#endif
+} EEFS_InodeTableEntry_t;
+
+struct EEFS_InodeTable_s
+{
+    uint32                              BaseAddress;
+    void                               *FreeMemoryPointer;
+    uint32                              FreeMemorySize;
+    uint32                              NumberOfFiles;
+    uint32                              OpenFileCount;      /* number of file descriptors open on this volume */
+    uint32                              OpenCreatCount;     /* number of file descriptors open for creat on this volume */
+    uint32                              OpenDirCount;       /* number of directory descriptors open on this volume */
+    int32                               FilenameHashTable[EEFS_FILENAME_HASH_SIZE]; /* first inode in each bucket, -1 if empty */
+    int32                               FreeSlotList;       /* deleted slot with the smallest MaxFileSize, -1 if none */
+    EEFS_FileDescriptorPool_t           FileDescriptorPool; /* private file descriptor pool, unused if FileDescriptorTable is NULL */
+    EEFS_SparePolicy_t                  SparePolicy;        /* spare byte policy of the volume, see Spare Bytes */
+    EEFS_SpareStats_t                   SpareStats;
+    EEFS_SpareHistoryEntry_t            SpareHistory[EEFS_SPARE_HISTORY_SIZE]; /* most recently removed files */
+    uint32                              SpareHistoryNext;   /* entry of SpareHistory that is replaced next */
+    EEFS_SpaceInfo_t                    SpaceInfo;          /* space totals of the volume, see Space Accounting */
+    uint32                              LockId;             /* implementation specific volume lock, see eefs_macros.h */
+    EEFS_InodeTableEntry_t              File[EEFS_MAX_FILES];
+};
 
 typedef struct
 {
@@ -284,12 +563,21 @@ typedef struct
     uint32                              MaxFileSize;
 } EEFS_DirectoryEntry_t;
 
+typedef struct
+{
+    uint32                              InUse;
+    uint32                              InodeIndex;
+    EEFS_InodeTable_t                  *InodeTable;
+    EEFS_DirectoryEntry_t               DirectoryEntry;     /* entry returned by EEFS_LibReadDir() */
+} EEFS_DirectoryDescriptor_t;
+
 typedef struct
 {
     uint32                              InodeIndex;
     uint32                              Crc;
     uint32                              Attributes;
     uint32                              FileSize;
+    uint32                              MaxFileSize;        /* size of the file slot and any extents, not including the file headers */
     time_t                              ModificationDate;
     time_t                              CreationDate;
     char                                Filename[EEFS_MAX_FILENAME_SIZE];
@@ -314,26 +602,41 @@ int32                           EEFS_LibFreeFS(EEFS_InodeTable_t *InodeTable);
  * EEFS_INVALID_ARGUMENT, or EEFS_FILE_NOT_FOUND on error. */
 int32                           EEFS_LibOpen(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Flags, uint32 Attributes);
 
-/* Creates a new file and opens it for writing.  If the file already exists then the existing file is opened for write
- * access and the file is truncated.  If the file does not already exist then a new file is created.  Since we don't know
- * the size of the file yet all remaining free eeprom is allocated for the new file. When the file is closed then the
- * MaxFileSize is updated to be the actual size of the file + EEFS_DEFAULT_CREAT_SPARE_BYTES.  Note that since all free eeprom
- * is allocated for the file while it is open, only one new file can be created at a time. Returns a file descriptor on
- * success, EEFS_NO_FREE_FILE_DESCRIPTOR, EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or EEFS_NO_SPACE_LEFT_ON_DEVICE
- * on error.*/
+/* Creates a new file and opens it for writing.  If the file already exists then the existing file is opened for write access
+ * and the file is truncated.  If the file does not already exist then a new file is created.  Since we don't know the size
+ * of the file yet all remaining free eeprom is allocated for the new file. When the file is closed then the MaxFileSize is
+ * updated to be the actual size of the file plus the spare bytes given by the spare byte policy of the volume, see
+ * EEFS_LibSetSparePolicy().  Note that since all free eeprom is allocated for the file while it is open, only one new file
+ * can be created at a time, see EEFS_LibCreatSized().  Returns a file descriptor on success, EEFS_NO_FREE_FILE_DESCRIPTOR,
+ * EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or EEFS_NO_SPACE_LEFT_ON_DEVICE on error. */
 int32                           EEFS_LibCreat(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes);
 
+/* Creates a new file of an expected size and opens it for writing.  If the file already exists then the existing file is
+ * opened for write access and the file is truncated.  Otherwise the new file is created in the smallest deleted slot that can
+ * hold ReservedBytes bytes, or a slot of ReservedBytes bytes rounded up to a 4 byte boundary is reserved in free memory.
+ * The slot is added to the File Allocation Table before this function returns, so other files can be created while the new
+ * file is open.  Writes are limited to the size of the slot.  Returns a file descriptor on success,
+ * EEFS_NO_FREE_FILE_DESCRIPTOR, EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or EEFS_NO_SPACE_LEFT_ON_DEVICE on error. */
+int32                           EEFS_LibCreatSized(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes);
+
 /* Closes a file.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error.  If a new file is being created then the
- * MaxFileSize is updated to be the actual size of the file + EEFS_DEFAULT_CREAT_SPARE_BYTES. Note that the File Allocation
- * Table is not updated until the file is closed to reduce the number of EEPROM Writes. */
+ * MaxFileSize is updated to be the actual size of the file plus the spare bytes given by the spare byte policy of the volume.
+ * Note that the File Allocation Table is not updated until the file is closed to reduce the number of EEPROM Writes. */
 int32                           EEFS_LibClose(int32 FileDescriptor);
 
+/* Makes the data written to an open file so far survive a reset without closing the file.  Only the FileSize,
+ * ModificationDate and Crc of the File Header are written, and a file that is being created is also committed to the File
+ * Allocation Table with a provisional MaxFileSize.  Everything written is programmed into EEPROM before this returns.
+ * Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibFsync(int32 FileDescriptor);
+
 /* Read from a file.  Returns the number of bytes read, 0 bytes if we have reached the end of file, or EEFS_INVALID_ARGUMENT
  * on error. */
 int32                           EEFS_LibRead(int32 FileDescriptor, void *Buffer, uint32 Length);
 
-/* Write to a file.  Returns the number of bytes written, 0 bytes if we have run out of memory or EEFS_INVALID_ARGUMENT
- * on error. */
+/* Write to a file.  If EEFS_RELOCATE_ON_GROW is TRUE the file is moved to a larger slot, or if EEFS_EXTENT_CHAINING is
+ * TRUE an extent is added to the file, when the write reaches the end of its last slot.  Returns the number of bytes
+ * written, 0 bytes if we have run out of memory or EEFS_INVALID_ARGUMENT on error. */
 int32                           EEFS_LibWrite(int32 FileDescriptor, void *Buffer, uint32 Length);
 
 /* Set the file pointer to a specific offset in the file.  This implementation does not support seeking beyond the end of a file.  
@@ -342,12 +645,55 @@ int32                           EEFS_LibWrite(int32 FileDescriptor, void *Buffer
  * on success, or EEFS_INVALID_ARGUMENT on error. */
 int32                           EEFS_LibLSeek(int32 FileDescriptor, int32 ByteOffset, uint16 Origin);
 
-/* Removes the specified file from the file system.  Note that this just marks the file as deleted and does not free the memory
- * in use by the file.  Once a file is deleted, the only way the slot can be reused is to manually write a new file into the
- * slot, i.e. there is no way to reuse the memory through a EEFS api function.  Returns a file descriptor on success,
+/* Removes the specified file from the file system.  Note that this just marks the file and its extents as deleted and does not
+ * free the memory in use by the file.  The slot can be reused by EEFS_LibCreatSized() and the memory is returned to free memory by
+ * EEFS_LibCompact().  Returns a file descriptor on success,
  * EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error. */
 int32                           EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename);
 
+/* Compacts the file system by moving files down over the slots of deleted files and returning the space to free memory.
+ * Each call stops once MaxBytesToCopy bytes have been written to EEPROM, except that at least one step is always taken, so
+ * the file system can be compacted incrementally by calling this function until it returns 0.  Files that are open, and
+ * their extents, are not moved.  Returns the number of bytes written to EEPROM, 0 if nothing more can be compacted, or EEFS_PERMISSION_DENIED,
+ * EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibCompact(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToCopy);
+
+/* Grows the slot of the specified file so it can hold at least NewMaxFileSize bytes, moving the file to free memory if its
+ * slot cannot be extended in place.  A slot that is already large enough is not changed.  The file must not be open and
+ * must not have extents.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * EEFS_NO_SPACE_LEFT_ON_DEVICE, EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibResize(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 NewMaxFileSize);
+
+/* Truncates a file that is open for write to Length bytes without releasing any space, so the file can be rewritten up to
+ * its old size after it has been truncated.  Truncate cannot make a file longer since the file system does not support
+ * holes.  The file pointer is moved to the new end of the file if it was past it.  Returns EEFS_SUCCESS on success,
+ * EEFS_PERMISSION_DENIED or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibFtruncate(int32 FileDescriptor, uint32 Length);
+
+/* Truncates a file that is open for write to Length bytes like EEFS_LibFtruncate(), then releases the space past Length as
+ * EEFS_LibTruncate() does if no other File Descriptor has the file open.  Returns EEFS_SUCCESS on success,
+ * EEFS_PERMISSION_DENIED or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibFtruncateRelease(int32 FileDescriptor, uint32 Length);
+
+/* Truncates the specified file to Length bytes.  The extents of the file that are past Length are deleted, and if the last
+ * slot of the file ends at free memory it is shrunk to Length plus the spare bytes given by the spare byte policy of the
+ * volume and the rest is returned to free memory.  The file must not be open.  Truncate cannot make a file longer since the
+ * file system does not support holes.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibTruncate(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Length);
+
+/* Sets the spare byte policy of the volume, which chooses the spare bytes added to the slot of a file that is created by
+ * EEFS_LibCreat() when it is closed.  Parameter is the number of spare bytes for EEFS_SPARE_POLICY_FIXED, the percentage of
+ * the file size for EEFS_SPARE_POLICY_PERCENT, the smallest slot for EEFS_SPARE_POLICY_POWER_OF_TWO, the spare bytes of a
+ * file that is not in the spare history for EEFS_SPARE_POLICY_LEARNED, and is passed to Function for
+ * EEFS_SPARE_POLICY_CUSTOM.  Function is ignored by the other policies.  Returns EEFS_SUCCESS on success or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibSetSparePolicy(EEFS_InodeTable_t *InodeTable, uint32 Policy, uint32 Parameter, EEFS_SparePolicyFunction_t Function);
+
+/* Returns the spare byte statistics of the volume in SpareStats.  If Reset is TRUE the statistics are cleared after they are
+ * read.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibGetSpareStats(EEFS_InodeTable_t *InodeTable, EEFS_SpareStats_t *SpareStats, uint8 Reset);
+
 /* Renames the specified file.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
  * or EEFS_INVALID_ARGUMENT on error. */
 int32                           EEFS_LibRename(EEFS_InodeTable_t *InodeTable, char *OldFilename, char *NewFilename);
@@ -360,21 +706,46 @@ int32                           EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char
  * EEFS_INVALID_ARGUMENT on error. */
 int32                           EEFS_LibFstat(int32 FileDescriptor, EEFS_Stat_t *StatBuffer);
 
+/* Returns file information for every file in use in the caller supplied StatBuffers array in a single pass over the
+ * Inode Table.  At most MaxEntries entries are filled in, and Count is set to the number of files in use, which may be
+ * larger than MaxEntries.  If SpaceInfo is not NULL it is filled in with the space totals of the file system.  Returns
+ * EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibSnapshot(EEFS_InodeTable_t *InodeTable, EEFS_Stat_t *StatBuffers, uint32 MaxEntries, uint32 *Count, EEFS_SpaceInfo_t *SpaceInfo);
+
+/* Returns the space totals of the file system in SpaceInfo, see Space Accounting.  The totals are kept up to date as files
+ * are changed, so this does not read EEPROM or scan the Inode Table.  Returns EEFS_SUCCESS on success or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibGetSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo);
+
+/* Waits until every change that has been made to the file system has been programmed into EEPROM, see EEPROM Access.
+ * Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibSync(EEFS_InodeTable_t *InodeTable);
+
 /* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
  * attribute.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error.  To read file
  * attributes use the stat function. */
 int32                           EEFS_LibSetFileAttributes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes);
 
 /* Opens a file system for reading the file directory.  This should be followed by calls to EEFS_ReadDir() and EEFS_CloseDir().
- * Note that currently only one process can read the file directory at a time.  Returns a pointer to a directory descriptor
+ * Up to EEFS_MAX_OPEN_DIRECTORIES directories can be read at the same time.  Returns a pointer to a directory descriptor
  * on success and a NULL pointer on error. */
 EEFS_DirectoryDescriptor_t     *EEFS_LibOpenDir(EEFS_InodeTable_t *InodeTable);
 
 /* Read the next file directory entry.  Returns a pointer to a EEFS_DirectoryEntry_t if successful or NULL if no more file
  * directory entries exist or an error occurs.  Note that all entries are returned, even empty slots. (The InUse flag will be
- * set to FALSE for empty slots) */
+ * set to FALSE for empty slots and to EEFS_EXTENT_IN_USE for extents).  The entry belongs to the directory descriptor and is
+ * overwritten by the next call. */
 EEFS_DirectoryEntry_t          *EEFS_LibReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor);
 
+/* Reentrant version of EEFS_LibReadDir() that copies the next file directory entry into the caller supplied DirectoryEntry.
+ * Returns 1 if an entry was read, 0 if no more file directory entries exist, or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibReadDir_r(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntry);
+
+/* Reads up to MaxEntries file directory entries into the caller supplied DirectoryEntries array.  If Flags contains
+ * EEFS_READDIR_SKIP_DELETED then empty slots and extents are skipped.  Returns the number of entries read, 0 if no more file
+ * directory entries exist, or EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibReadDirBatch(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntries, uint32 MaxEntries, uint32 Flags);
+
 /* Close file system for reading the file directory.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
 int32                           EEFS_LibCloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor);
 
@@ -384,6 +755,12 @@ uint8                           EEFS_LibHasOpenFiles(EEFS_InodeTable_t *InodeTab
 /* Returns TRUE if a directory is open. */
 uint8                           EEFS_LibHasOpenDir(EEFS_InodeTable_t *InodeTable);
 
+/* Gives a volume its own pool of File Descriptors using the caller supplied FileDescriptorTable.  This must be called after
+ * EEFS_LibInitFS() and before any files are opened on the volume, and the FileDescriptorTable must remain valid until
+ * EEFS_LibFreeFS() is called.  Returns EEFS_SUCCESS on success, EEFS_DEVICE_IS_BUSY, EEFS_NO_FREE_FILE_DESCRIPTOR or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32                           EEFS_LibInitFileDescriptorPool(EEFS_InodeTable_t *InodeTable, EEFS_FileDescriptor_t *FileDescriptorTable, uint32 NumberOfFileDescriptors);
+
 /* Returns a pointer to the specified File Descriptor, or NULL if the specified
  * File Descriptor is not valid */
 EEFS_FileDescriptor_t          *EEFS_LibFileDescriptor2Pointer(int32 FileDescriptor);
@@ -391,10 +768,10 @@ EEFS_FileDescriptor_t          *EEFS_LibFileDescriptor2Pointer(int32 FileDescrip
 /* Checks file system integrity and dumps the contents of the Inode Table and all File Headers */
 int32                           EEFS_LibChkDsk(EEFS_InodeTable_t *InodeTable, uint32 Flags);
 
-/* Returns the number of file descriptors currently in use */
+/* Returns the number of file descriptors currently in use in the shared file descriptor table */
 uint32                          EEFS_LibGetFileDescriptorsInUse(void);
 
-/* Returns the file descriptors high water mark - useful for determining if the file descriptor table
+/* Returns the shared file descriptor table high water mark - useful for determining if the file descriptor table
  * is large enough */
 uint32                          EEFS_LibGetFileDescriptorsHighWaterMark(void);
 
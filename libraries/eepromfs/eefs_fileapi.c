@@ -25,6 +25,7 @@
 #include "eefs_fileapi.h"
 #include "eefs_macros.h"
 #include <string.h>
+#include <stddef.h>
 #include <math.h>
 
 /*
@@ -35,32 +36,129 @@
 #define EEFS_MIN(x,y) (((x) < (y)) ? (x) : (y))
 #define EEFS_ROUND_UP(x, align)	(((int) (x) + (align - 1)) & ~(align - 1))
 
+/* The volume lock can optionally be a reader/writer lock.  Ports that only define EEFS_LIB_INODE_LOCK in eefs_macros.h use
+ * the same lock for readers and writers. */
+#ifndef EEFS_LIB_INODE_RDLOCK
+#define EEFS_LIB_INODE_RDLOCK(InodeTable)       EEFS_LIB_INODE_LOCK(InodeTable)
+#endif
+#ifndef EEFS_LIB_INODE_WRLOCK
+#define EEFS_LIB_INODE_WRLOCK(InodeTable)       EEFS_LIB_INODE_LOCK(InodeTable)
+#endif
+
+/* EEFS_LIB_EEPROM_SYNC waits until everything written has been programmed.  Ports whose EEFS_LIB_EEPROM_FLUSH does not
+ * return until then do not need to define it. */
+#ifndef EEFS_LIB_EEPROM_SYNC
+#define EEFS_LIB_EEPROM_SYNC                    EEFS_LIB_EEPROM_FLUSH
+#endif
+
+/* Expand to the offset and size within a File Header of one field, or of the fields from First to Last, for
+ * EEFS_LibWriteFileHeaderFields() */
+#define EEFS_FILE_HEADER_FIELD(Field)               offsetof(EEFS_FileHeader_t, Field), sizeof(((EEFS_FileHeader_t *)0)->Field)
+#define EEFS_FILE_HEADER_FIELDS(First, Last)        offsetof(EEFS_FileHeader_t, First), \
+                                                    (offsetof(EEFS_FileHeader_t, Last) + sizeof(((EEFS_FileHeader_t *)0)->Last) - offsetof(EEFS_FileHeader_t, First))
+
+/* Terminates a chain in the filename hash index */
+#define EEFS_END_OF_HASH_CHAIN  (-1)
+
+/* Terminates the free list of a file descriptor pool */
+#define EEFS_END_OF_FREE_LIST   (-1)
+
+/* Terminates the free slot list of an Inode Table */
+#define EEFS_END_OF_FREE_SLOT_LIST  (-1)
+
+/* Terminates the chain of extents of a file */
+#define EEFS_END_OF_EXTENT_CHAIN    (-1)
+
+/* The ReservedBytes of a file creat when the size of the new file is not known, no deleted slot is large enough */
+#define EEFS_UNKNOWN_FILE_SIZE  0xFFFFFFFF
+
+/* A file descriptor is made up of the pool index in the upper bits and the index of the entry in the pool in the lower bits */
+#define EEFS_FILE_DESCRIPTOR_POOL_SHIFT     16
+#define EEFS_FILE_DESCRIPTOR_ENTRY_MASK     0xFFFF
+
 /*
  * Local Data
  */
 
-/* Note: the file descriptors are shared across all file systems */
-uint32                          EEFS_FileDescriptorsInUse;
-uint32                          EEFS_FileDescriptorsHighWaterMark;
+/* Note: the file descriptors are shared across all file systems that do not have their own file descriptor pool */
 EEFS_FileDescriptor_t           EEFS_FileDescriptorTable[EEFS_MAX_OPEN_FILES];
+EEFS_FileDescriptorPool_t       EEFS_SharedFileDescriptorPool;
+
+/* All file descriptor pools, indexed by the pool index contained in each file descriptor.  Entry 0 is always the shared pool. */
+EEFS_FileDescriptorPool_t      *EEFS_FileDescriptorPools[EEFS_MAX_FILE_DESCRIPTOR_POOLS];
 
-/* Note: at the moment there is only one directory descriptor, so only one process can use it at a time */
-EEFS_DirectoryDescriptor_t      EEFS_DirectoryDescriptor;
-EEFS_DirectoryEntry_t           EEFS_DirectoryEntry;
+/* Note: the directory descriptors are shared across all file systems */
+EEFS_DirectoryDescriptor_t      EEFS_DirectoryDescriptorTable[EEFS_MAX_OPEN_DIRECTORIES];
 
 /*
  * Local Function Prototypes
  */
 
 int32                           EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 Flags, uint32 Attributes);
-int32                           EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes);
+int32                           EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes);
+int32                           EEFS_LibFindNewSlot(EEFS_InodeTable_t *InodeTable, uint32 ReservedBytes, void **FileHeaderPointer, uint32 *MaxFileSize, uint32 *Mode, uint8 *ReserveSlot);
+void                            EEFS_LibWriteNewSlot(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, void *FileHeaderPointer, uint32 MaxFileSize, uint8 ReserveSlot, EEFS_FileHeader_t *FileHeader);
+void                            EEFS_LibDeleteFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+void                            EEFS_LibSeekFileData(EEFS_FileDescriptor_t *FileDescriptorPointer);
+uint32                          EEFS_LibContiguousBytes(EEFS_FileDescriptor_t *FileDescriptorPointer);
+uint32                          EEFS_LibFileCapacity(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+uint32                          EEFS_LibFileOwner(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+uint8                           EEFS_LibHasNextExtent(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+int32                           EEFS_LibRelocateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 NewMaxFileSize, uint32 BytesToCopy);
+int32                           EEFS_LibFtruncateFile(int32 FileDescriptor, uint32 Length, uint8 ReleaseSpace);
+void                            EEFS_LibTruncateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Length, uint8 ReleaseSpace);
+uint32                          EEFS_LibSpareBytes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 FileSize, uint32 PreviousMaxFileSize);
+void                            EEFS_LibAddToSpareHistory(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+uint32                          EEFS_LibTakeFromSpareHistory(EEFS_InodeTable_t *InodeTable, char *Filename);
+void                            EEFS_LibCountRegrow(EEFS_FileDescriptor_t *FileDescriptorPointer, uint32 BytesToWrite);
+#if (EEFS_RELOCATE_ON_GROW == TRUE)
+uint32                          EEFS_LibGrowFile(EEFS_FileDescriptor_t *FileDescriptorPointer, uint32 Length);
+#endif
+#if (EEFS_EXTENT_CHAINING == TRUE)
+uint32                          EEFS_LibAddExtent(EEFS_FileDescriptor_t *FileDescriptorPointer, uint32 Length);
+void                            EEFS_LibBuildExtentChains(EEFS_InodeTable_t *InodeTable);
+#endif
 uint32                          EEFS_LibFmode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
 int32                           EEFS_LibFindFile(EEFS_InodeTable_t *InodeTable, char *Filename);
-int32                           EEFS_LibGetFileDescriptor(void);
+int32                           EEFS_LibGetFileDescriptor(EEFS_InodeTable_t *InodeTable);
 int32                           EEFS_LibFreeFileDescriptor(int32 FileDescriptor);
 uint8                           EEFS_LibIsValidFileDescriptor(int32 FileDescriptor);
+EEFS_FileDescriptor_t          *EEFS_LibFileDescriptorEntry(int32 FileDescriptor);
+EEFS_FileDescriptor_t          *EEFS_LibLockFileDescriptor(int32 FileDescriptor);
+void                            EEFS_LibInitFreeList(EEFS_FileDescriptorPool_t *FileDescriptorPool);
 uint8                           EEFS_LibHasOpenCreat(EEFS_InodeTable_t *InodeTable);
 uint8                           EEFS_LibIsValidFilename(char *Filename);
+void                            EEFS_LibAddOpenMode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Mode);
+void                            EEFS_LibRemoveOpenMode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Mode);
+void                            EEFS_LibReadFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader);
+void                            EEFS_LibWriteFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader);
+void                            EEFS_LibWriteFileHeaderFields(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader, uint32 FieldOffset, uint32 FieldSize);
+void                            EEFS_LibCacheFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader);
+void                            EEFS_LibAccountSlot(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+uint32                          EEFS_LibHashFilename(char *Filename);
+void                            EEFS_LibAddToFilenameIndex(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+void                            EEFS_LibRemoveFromFilenameIndex(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+void                            EEFS_LibBuildFreeSlotList(EEFS_InodeTable_t *InodeTable);
+void                            EEFS_LibAddToFreeSlotList(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+void                            EEFS_LibRemoveFromFreeSlotList(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+int32                           EEFS_LibFindFreeSlot(EEFS_InodeTable_t *InodeTable, uint32 ReservedBytes);
+int32                           EEFS_LibFindLastFreeSlot(EEFS_InodeTable_t *InodeTable);
+int32                           EEFS_LibFindEmptySlot(EEFS_InodeTable_t *InodeTable);
+int32                           EEFS_LibFindSlotEnd(EEFS_InodeTable_t *InodeTable, void *Address);
+void                            EEFS_LibMoveEmptySlot(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, void *FileHeaderPointer, EEFS_FileHeader_t *FileHeader);
+int32                           EEFS_LibFillSlotGaps(EEFS_InodeTable_t *InodeTable);
+void                            EEFS_LibFillDirectoryEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_DirectoryEntry_t *DirectoryEntry);
+void                            EEFS_LibFillStat(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_Stat_t *StatBuffer);
+void                            EEFS_LibFillSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo);
+void                            EEFS_LibWriteFileAllocationTableHeader(EEFS_InodeTable_t *InodeTable);
+void                            EEFS_LibWriteFileAllocationTableEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+int32                           EEFS_LibNextSlot(EEFS_InodeTable_t *InodeTable, void *Address);
+int32                           EEFS_LibFindSlot(EEFS_InodeTable_t *InodeTable, void *Address);
+int32                           EEFS_LibTrimFreeMemory(EEFS_InodeTable_t *InodeTable);
+int32                           EEFS_LibCompactStep(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToWrite);
+int32                           EEFS_LibCommitCompactJournal(EEFS_InodeTable_t *InodeTable, EEFS_CompactJournal_t *Journal);
+void                            EEFS_LibApplyCompactJournal(uint32 BaseAddress, EEFS_CompactJournal_t *JournalPointer, EEFS_CompactJournal_t *Journal);
+void                            EEFS_LibRecoverCompactJournal(uint32 BaseAddress, EEFS_FileAllocationTableHeader_t *FileAllocationTableHeader);
 
 /*
  * Function Definitions
@@ -69,11 +167,20 @@ uint8                           EEFS_LibIsValidFilename(char *Filename);
 /* Initialize global data shared by all file systems */
 void EEFS_LibInit(void)
 {
-    EEFS_FileDescriptorsInUse = 0;
-    EEFS_FileDescriptorsHighWaterMark = 0;
+    uint32      i;
+
     memset(EEFS_FileDescriptorTable, 0, sizeof(EEFS_FileDescriptorTable));
-    memset(&EEFS_DirectoryDescriptor, 0, sizeof(EEFS_DirectoryDescriptor_t));
-    memset(&EEFS_DirectoryEntry, 0, sizeof(EEFS_DirectoryEntry_t));
+    memset(&EEFS_SharedFileDescriptorPool, 0, sizeof(EEFS_FileDescriptorPool_t));
+    memset(EEFS_FileDescriptorPools, 0, sizeof(EEFS_FileDescriptorPools));
+    EEFS_SharedFileDescriptorPool.FileDescriptorTable = EEFS_FileDescriptorTable;
+    EEFS_SharedFileDescriptorPool.NumberOfFileDescriptors = EEFS_MAX_OPEN_FILES;
+    EEFS_SharedFileDescriptorPool.PoolIndex = 0;
+    EEFS_LibInitFreeList(&EEFS_SharedFileDescriptorPool);
+    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
+        EEFS_LIB_FD_LOCK_CREATE(&EEFS_FileDescriptorTable[i]);
+    }
+    EEFS_FileDescriptorPools[0] = &EEFS_SharedFileDescriptorPool;
+    memset(EEFS_DirectoryDescriptorTable, 0, sizeof(EEFS_DirectoryDescriptorTable));
 
 } /* End of EEFS_LibInit() */
 
@@ -83,10 +190,11 @@ int32 EEFS_LibInitFS(EEFS_InodeTable_t *InodeTable, uint32 BaseAddress)
     EEFS_FileAllocationTable_t         *FileAllocationTable;
     EEFS_FileAllocationTableHeader_t    FileAllocationTableHeader;
     EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
+    EEFS_FileHeader_t                   FileHeader;
     uint32                              i;
     int32                               ReturnCode;
   
-    EEFS_LIB_LOCK;
+    /* No lock is taken here since the Inode Table is not visible to other tasks until the volume is mounted */
     if (InodeTable != NULL) {
 
         /* Load the File Allocation Table Header from EEPROM */
@@ -96,17 +204,52 @@ int32 EEFS_LibInitFS(EEFS_InodeTable_t *InodeTable, uint32 BaseAddress)
             (FileAllocationTableHeader.Version == 1) &&
             (FileAllocationTableHeader.NumberOfFiles <= EEFS_MAX_FILES)) {
 
+            /* Complete a compaction step that was interrupted by a reset before the File Allocation Table is loaded */
+            EEFS_LibRecoverCompactJournal(BaseAddress, &FileAllocationTableHeader);
+
             /* Initialize the Inode Table */
             memset(InodeTable, 0, sizeof(EEFS_InodeTable_t));
+            EEFS_LIB_INODE_LOCK_CREATE(InodeTable);
             InodeTable->BaseAddress = BaseAddress;
             InodeTable->FreeMemoryPointer = (void *)(InodeTable->BaseAddress + FileAllocationTableHeader.FreeMemoryOffset);
             InodeTable->FreeMemorySize = FileAllocationTableHeader.FreeMemorySize;
             InodeTable->NumberOfFiles = FileAllocationTableHeader.NumberOfFiles;
+            InodeTable->SparePolicy.Policy = EEFS_SPARE_POLICY_FIXED;
+            InodeTable->SparePolicy.Parameter = EEFS_DEFAULT_CREAT_SPARE_BYTES;
             for (i=0; i < InodeTable->NumberOfFiles; i++) {
                 EEFS_LIB_EEPROM_READ(&FileAllocationTableEntry, &FileAllocationTable->File[i], sizeof(EEFS_FileAllocationTableEntry_t));
                 InodeTable->File[i].FileHeaderPointer = (void *)(BaseAddress + FileAllocationTableEntry.FileHeaderOffset);
                 InodeTable->File[i].MaxFileSize = FileAllocationTableEntry.MaxFileSize;
+
+                /* Keep a ram copy of the File Header for the filename hash index and the header cache */
+                EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[i].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+                EEFS_LibCacheFileHeader(InodeTable, i, &FileHeader);
+                EEFS_LibAccountSlot(InodeTable, i);
+            }
+
+            /* Build the filename hash index.  Files are added in reverse order so if the file system contains duplicate
+             * filenames the lowest inode is found first, the same as a sequential search of the Inode Table. */
+            for (i=0; i < EEFS_FILENAME_HASH_SIZE; i++) {
+                InodeTable->FilenameHashTable[i] = EEFS_END_OF_HASH_CHAIN;
+            }
+            for (i=InodeTable->NumberOfFiles; i > 0; i--) {
+                if (InodeTable->File[i-1].InUse == TRUE) {
+                    EEFS_LibAddToFilenameIndex(InodeTable, (i-1));
+                }
+            }
+            InodeTable->FreeSlotList = EEFS_END_OF_FREE_SLOT_LIST;
+
+#if (EEFS_EXTENT_CHAINING == TRUE)
+            /* Link the extents to their files and delete any extents that were left behind by a reset */
+            EEFS_LibBuildExtentChains(InodeTable);
+#endif
+
+            /* Recover any space left behind by a compaction step or a file creat that was interrupted by a reset */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+                EEFS_LibFillSlotGaps(InodeTable);
+                EEFS_LibTrimFreeMemory(InodeTable);
             }
+            EEFS_LibBuildFreeSlotList(InodeTable);
             ReturnCode = EEFS_SUCCESS;
         }
         else { /* invalid file allocation table */
@@ -117,7 +260,6 @@ int32 EEFS_LibInitFS(EEFS_InodeTable_t *InodeTable, uint32 BaseAddress)
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibInitFS() */
@@ -125,26 +267,41 @@ int32 EEFS_LibInitFS(EEFS_InodeTable_t *InodeTable, uint32 BaseAddress)
 /* Clears the Inode Table.  Returns EEFS_SUCCESS on success, EEFS_DEVICE_IS_BUSY or EEFS_INVALID_ARGUMENT on error. */
 int32 EEFS_LibFreeFS(EEFS_InodeTable_t *InodeTable)
 {
+    uint32      i;
     int32       ReturnCode;
 
-    EEFS_LIB_LOCK;
     if (InodeTable != NULL) {
 
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        EEFS_LIB_LOCK;
         if ((EEFS_LibHasOpenFiles(InodeTable) == FALSE) &&
             (EEFS_LibHasOpenDir(InodeTable) == FALSE)) {
 
-            memset(InodeTable, 0, sizeof(EEFS_InodeTable_t));
+            /* Release the private file descriptor pool if the volume has one */
+            if (InodeTable->FileDescriptorPool.FileDescriptorTable != NULL) {
+                EEFS_FileDescriptorPools[InodeTable->FileDescriptorPool.PoolIndex] = NULL;
+            }
             ReturnCode = EEFS_SUCCESS;
         }
         else { /* files or directory descriptor open */
             ReturnCode = EEFS_DEVICE_IS_BUSY;
         }
+        EEFS_LIB_UNLOCK;
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+
+        /* The locks can only be deleted once they are released */
+        if (ReturnCode == EEFS_SUCCESS) {
+            for (i=0; i < InodeTable->FileDescriptorPool.NumberOfFileDescriptors; i++) {
+                EEFS_LIB_FD_LOCK_DELETE(&InodeTable->FileDescriptorPool.FileDescriptorTable[i]);
+            }
+            EEFS_LIB_INODE_LOCK_DELETE(InodeTable);
+            memset(InodeTable, 0, sizeof(EEFS_InodeTable_t));
+        }
     }
     else { /* invalid inode table */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibFreeFS() */
@@ -158,9 +315,16 @@ int32 EEFS_LibOpen(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Flags,
     int32                           InodeIndex;
     int32                           ReturnCode;
 
-    EEFS_LIB_LOCK;
     if (InodeTable != NULL) {
 
+        /* Opening an existing file only changes the open file counts, which are protected by the global lock, so only a
+         * read lock is needed unless the file may have to be created */
+        if (Flags & O_CREAT) {
+            EEFS_LIB_INODE_WRLOCK(InodeTable);
+        }
+        else {
+            EEFS_LIB_INODE_RDLOCK(InodeTable);
+        }
         if (EEFS_LibIsValidFilename(Filename)) {
 
             if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
@@ -169,7 +333,7 @@ int32 EEFS_LibOpen(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Flags,
             }
             else if (Flags & O_CREAT) {
             
-                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, EEFS_ATTRIBUTE_NONE);
+                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, EEFS_UNKNOWN_FILE_SIZE, EEFS_ATTRIBUTE_NONE);
             }           
             else { /* file not found */
             
@@ -179,31 +343,31 @@ int32 EEFS_LibOpen(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Flags,
         else { /* invalid filename size */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
     }
     else { /* invalid inode table */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibOpen() */
 
-/* Creates a new file and opens it for writing.  If the file already exists then the existing file is opened for write
- * access and the file is truncated.  If the file does not already exist then a new file is created.  Since we don't know
- * the size of the file yet all remaining free eeprom is allocated for the new file. When the file is closed then the
- * MaxFileSize is updated to be the actual size of the file + EEFS_DEFAULT_CREAT_SPARE_BYTES.  Note that since all free eeprom
- * is allocated for the file while it is open, only one new file can be created at a time. Returns a file descriptor on
- * success, EEFS_NO_FREE_FILE_DESCRIPTOR, EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or EEFS_NO_SPACE_LEFT_ON_DEVICE
- * on error.*/
+/* Creates a new file and opens it for writing.  If the file already exists then the existing file is opened for write access
+ * and the file is truncated.  If the file does not already exist then a new file is created.  Since we don't know the size
+ * of the file yet all remaining free eeprom is allocated for the new file. When the file is closed then the MaxFileSize is
+ * updated to be the actual size of the file plus the spare bytes given by the spare byte policy of the volume, see
+ * EEFS_LibSetSparePolicy().  Note that since all free eeprom is allocated for the file while it is open, only one new file
+ * can be created at a time, see EEFS_LibCreatSized().  Returns a file descriptor on success, EEFS_NO_FREE_FILE_DESCRIPTOR,
+ * EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or EEFS_NO_SPACE_LEFT_ON_DEVICE on error. */
 int32 EEFS_LibCreat(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
 {
     int32                               InodeIndex;
     int32                               ReturnCode;
 
-    EEFS_LIB_LOCK;
     if (InodeTable != NULL) {
 
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
         if (EEFS_LibIsValidFilename(Filename)) {
 
             /* If the file already exists then open it for write access otherwise create a new file */
@@ -213,26 +377,64 @@ int32 EEFS_LibCreat(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attrib
             }
             else {
 
-                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, Attributes);
+                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, EEFS_UNKNOWN_FILE_SIZE, Attributes);
             }
         }
         else { /* filename too long */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
     }
     else { /* invalid inode table */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibCreat() */
 
+/* Creates a new file of an expected size and opens it for writing.  The new file is created in the smallest deleted slot
+ * that can hold ReservedBytes bytes, or a slot of exactly ReservedBytes bytes is reserved in free memory, so other files can
+ * be created while the new file is open.  Returns a file descriptor on success, EEFS_NO_FREE_FILE_DESCRIPTOR,
+ * EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or EEFS_NO_SPACE_LEFT_ON_DEVICE on error.*/
+int32 EEFS_LibCreatSized(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes)
+{
+    int32                               InodeIndex;
+    int32                               ReturnCode;
+
+    if (InodeTable != NULL) {
+
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        if (EEFS_LibIsValidFilename(Filename)) {
+
+            /* If the file already exists then open it for write access otherwise create a new file */
+            if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                ReturnCode = EEFS_LibOpenFile(InodeTable, InodeIndex, (O_WRONLY | O_TRUNC), Attributes);
+            }
+            else {
+
+                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, ReservedBytes, Attributes);
+            }
+        }
+        else { /* filename too long */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibCreatSized() */
+
 /* Internal function to open a file. */
 int32 EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 Flags, uint32 Attributes)
 {
     int32                           FileDescriptor;
+    EEFS_FileDescriptor_t          *FileDescriptorPointer;
     EEFS_FileHeader_t               FileHeader;
     int32                           ReturnCode;
     uint32                          Fmode;
@@ -247,37 +449,40 @@ int32 EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 F
              (EEFS_LIB_IS_WRITE_PROTECTED == FALSE)) {                          /* open for writing and the file system is not write protected */
 
             /* Don't allow the file to be opened for write if it has the read only attribute set */
-            EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
             if (((Flags & O_ACCMODE) == O_RDONLY) ||                         /* open only for reading OR */
                  (FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) {   /* open for writing and read only file attribute not set */
 
                 /* This always allows the file to be opened for read only access, however it does not allow the
-                 * file to be opened for shared write access */
+                 * file to be opened for shared write access.  The global lock keeps the check and the update of the
+                 * open file counts atomic since the volume may only be read locked. */
+                EEFS_LIB_LOCK;
                 Fmode = EEFS_LibFmode(InodeTable, InodeIndex);
                 if (((Flags & O_ACCMODE) == O_RDONLY) ||                     /* open only for reading OR */
                      (Fmode & EEFS_FWRITE) == 0) {                           /* open for writing and file is not already open for writing */
 
-                    if ((FileDescriptor = EEFS_LibGetFileDescriptor()) != EEFS_NO_FREE_FILE_DESCRIPTOR) {
+                    if ((FileDescriptor = EEFS_LibGetFileDescriptor(InodeTable)) != EEFS_NO_FREE_FILE_DESCRIPTOR) {
 
                         /* Initialize the File Descriptor */
-                        EEFS_FileDescriptorTable[FileDescriptor].Mode = (Flags & O_ACCMODE) + 1;
-                        EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
-                        EEFS_FileDescriptorTable[FileDescriptor].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
-                        EEFS_FileDescriptorTable[FileDescriptor].InodeTable = InodeTable;
-                        EEFS_FileDescriptorTable[FileDescriptor].InodeIndex = InodeIndex;
+                        FileDescriptorPointer = EEFS_LibFileDescriptor2Pointer(FileDescriptor);
+                        FileDescriptorPointer->Mode = (Flags & O_ACCMODE) + 1;
+                        FileDescriptorPointer->FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+                        FileDescriptorPointer->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                        FileDescriptorPointer->InodeTable = InodeTable;
+                        FileDescriptorPointer->InodeIndex = InodeIndex;
+                        EEFS_LibAddOpenMode(InodeTable, InodeIndex, FileDescriptorPointer->Mode);
 
                         if ((((Flags & O_ACCMODE) == O_WRONLY) ||
                              ((Flags & O_ACCMODE) == O_RDWR))  &&
                               (Flags & O_TRUNC)) {
-                            EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
-                            EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = 0;
-                            EEFS_FileDescriptorTable[FileDescriptor].FileSize = 0;
+                            FileDescriptorPointer->ByteOffset = 0;
+                            FileDescriptorPointer->FileSize = 0;
                         }
                         else {
-                            EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
-                            EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = 0;
-                            EEFS_FileDescriptorTable[FileDescriptor].FileSize = FileHeader.FileSize;
+                            FileDescriptorPointer->ByteOffset = 0;
+                            FileDescriptorPointer->FileSize = FileHeader.FileSize;
                         }
+                        EEFS_LibSeekFileData(FileDescriptorPointer);
 
                         /* Return the File Descriptor */
                         ReturnCode = FileDescriptor;
@@ -289,6 +494,7 @@ int32 EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 F
                 else { /* file is already open for write */
                     ReturnCode = EEFS_PERMISSION_DENIED;
                 }
+                EEFS_LIB_UNLOCK;
             }
             else { /* file is read only */
                 ReturnCode = EEFS_PERMISSION_DENIED;
@@ -306,84 +512,70 @@ int32 EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 F
     
 } /* End of EEFS_LibOpenFile() */
 
-/* Internal function to create a new file */
-int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
+/* Internal function to create a new file.  The file is created in the smallest deleted slot that can hold ReservedBytes
+ * bytes, otherwise it is created in free memory.  A file of unknown size is given all of free memory until it is closed. */
+int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes)
 {
 
     EEFS_FileHeader_t                   FileHeader;
     int32                               InodeIndex;
+    void                               *FileHeaderPointer;
+    uint32                              MaxFileSize;
+    uint32                              Mode;
+    uint8                               ReserveSlot;
     int32                               FileDescriptor;
+    EEFS_FileDescriptor_t              *FileDescriptorPointer;
     int32                               ReturnCode;
 
     /* If the file system is not write protected */
     if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
 
-        /* Make sure there is a free slot in the File Allocation Table */
-        if (InodeTable->NumberOfFiles < EEFS_MAX_FILES) {
-
-            /* Since we use all available free memory when creating a new file we can only create one new file at
-             * a time */
-            if (EEFS_LibHasOpenCreat(InodeTable) == FALSE) {
-
-                /* Make sure there is enough room in eeprom for at least a file header */
-                if (InodeTable->FreeMemorySize > sizeof(EEFS_FileHeader_t)) {
-
-                    if ((Attributes == EEFS_ATTRIBUTE_NONE) || (Attributes == EEFS_ATTRIBUTE_READONLY)) {
-
-                        if ((FileDescriptor = EEFS_LibGetFileDescriptor()) != EEFS_NO_FREE_FILE_DESCRIPTOR) {
-
-                            /* Add the new entry to the InodeTable.  Temporarily set the MaxFileSize equal to all free eeprom.
-                             * The FreeMemoryPointer and the FreeMemorySize variables are NOT updated until the file is
-                             * closed and the actual file size is known.  Setting EEFS_FCREAT in the Mode variable
-                             * will prevent any other file creations until the current one is complete and the FreeMemoryPointer 
-                             * and the FreeMemorySize variables are updated. */
-                            InodeIndex = InodeTable->NumberOfFiles;
-                            InodeTable->NumberOfFiles++;
-                            InodeTable->File[InodeIndex].FileHeaderPointer = InodeTable->FreeMemoryPointer;
-                            InodeTable->File[InodeIndex].MaxFileSize = (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t));
-
-                            /* Initialize a new File Header and write it to EEPROM*/
-                            FileHeader.Crc = 0;    /* Automatically updating the CRC is not supported at this time */
-                            FileHeader.InUse = TRUE;
-                            FileHeader.Attributes = Attributes;
-                            FileHeader.FileSize = 0;
-                            FileHeader.ModificationDate = EEFS_LIB_TIME;
-                            FileHeader.CreationDate = FileHeader.ModificationDate;
-                            strncpy(FileHeader.Filename, Filename, EEFS_MAX_FILENAME_SIZE);
-                            EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-                            EEFS_LIB_EEPROM_FLUSH;
-
-                            /* Initialize the File Descriptor */
-                            EEFS_FileDescriptorTable[FileDescriptor].Mode = (EEFS_FCREAT | EEFS_FWRITE);
-                            EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
-                            EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
-                            EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = 0;
-                            EEFS_FileDescriptorTable[FileDescriptor].FileSize = 0;
-                            EEFS_FileDescriptorTable[FileDescriptor].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
-                            EEFS_FileDescriptorTable[FileDescriptor].InodeTable = InodeTable;
-                            EEFS_FileDescriptorTable[FileDescriptor].InodeIndex = InodeIndex;
-
-                            /* Return the File Descriptor */
-                            ReturnCode = FileDescriptor;
-                        }
-                        else { /* no available file descriptor */
-                            ReturnCode = EEFS_NO_FREE_FILE_DESCRIPTOR;
-                        }
-                    }
-                    else { /* invalid attributes */
-                        ReturnCode = EEFS_INVALID_ARGUMENT;
-                    }
+        if ((InodeIndex = EEFS_LibFindNewSlot(InodeTable, ReservedBytes, &FileHeaderPointer, &MaxFileSize, &Mode, &ReserveSlot)) >= 0) {
+
+            if ((Attributes == EEFS_ATTRIBUTE_NONE) || (Attributes == EEFS_ATTRIBUTE_READONLY)) {
+
+                EEFS_LIB_LOCK;
+                FileDescriptor = EEFS_LibGetFileDescriptor(InodeTable);
+                EEFS_LIB_UNLOCK;
+
+                if (FileDescriptor != EEFS_NO_FREE_FILE_DESCRIPTOR) {
+
+                    /* Initialize a new File Header and write it to EEPROM */
+                    memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
+                    FileHeader.Crc = 0;    /* Automatically updating the CRC is not supported at this time */
+                    FileHeader.InUse = TRUE;
+                    FileHeader.Attributes = Attributes;
+                    FileHeader.FileSize = 0;
+                    FileHeader.ModificationDate = EEFS_LIB_TIME;
+                    FileHeader.CreationDate = FileHeader.ModificationDate;
+                    strncpy(FileHeader.Filename, Filename, EEFS_MAX_FILENAME_SIZE);
+                    EEFS_LibWriteNewSlot(InodeTable, InodeIndex, FileHeaderPointer, MaxFileSize, ReserveSlot, &FileHeader);
+
+                    /* Initialize the File Descriptor */
+                    FileDescriptorPointer = EEFS_LibFileDescriptor2Pointer(FileDescriptor);
+                    FileDescriptorPointer->Mode = Mode;
+                    FileDescriptorPointer->FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+                    FileDescriptorPointer->ByteOffset = 0;
+                    FileDescriptorPointer->FileSize = 0;
+                    FileDescriptorPointer->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                    FileDescriptorPointer->InodeTable = InodeTable;
+                    FileDescriptorPointer->InodeIndex = InodeIndex;
+                    EEFS_LibSeekFileData(FileDescriptorPointer);
+                    EEFS_LibAddOpenMode(InodeTable, InodeIndex, FileDescriptorPointer->Mode);
+
+                    /* Return the File Descriptor */
+                    ReturnCode = FileDescriptor;
                 }
-                else { /* not enough free space in eeprom */
-                    ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+                else { /* no available file descriptor */
+                    ReturnCode = EEFS_NO_FREE_FILE_DESCRIPTOR;
                 }
             }
-            else { /* a file creat is already in progress */
-                ReturnCode = EEFS_PERMISSION_DENIED;
+            else { /* invalid attributes */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
             }
         }
-        else { /* no available slots in the File Allocation Table */
-            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+        else { /* no slot is available */
+            ReturnCode = InodeIndex;
         }
     }
     else { /* file system is write protected */
@@ -394,107 +586,319 @@ int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 At
     
 } /* End of EEFS_LibCreatFile() */
 
+/* Finds the slot for a new file or extent that is expected to hold ReservedBytes bytes.  A deleted slot that is large enough
+ * is reused as it is, so the File Allocation Table and free memory are not changed.  Otherwise the slot is taken from free
+ * memory, all of it if the size is not known, in which case Mode is set to (EEFS_FCREAT | EEFS_FWRITE), or a slot of exactly
+ * ReservedBytes bytes rounded up to a 4 byte boundary, in which case ReserveSlot is set to TRUE.  Nothing is written to
+ * EEPROM until the slot is claimed by EEFS_LibWriteNewSlot().  Returns the Inode of the slot on success,
+ * EEFS_PERMISSION_DENIED or EEFS_NO_SPACE_LEFT_ON_DEVICE on error.  The caller must hold the volume write lock. */
+int32 EEFS_LibFindNewSlot(EEFS_InodeTable_t *InodeTable, uint32 ReservedBytes, void **FileHeaderPointer, uint32 *MaxFileSize, uint32 *Mode, uint8 *ReserveSlot)
+{
+    int32                               InodeIndex;
+    int32                               ReturnCode;
+
+    *ReserveSlot = FALSE;
+
+    if ((InodeIndex = EEFS_LibFindFreeSlot(InodeTable, ReservedBytes)) != EEFS_FILE_NOT_FOUND) {
+
+        *FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+        *MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+        *Mode = EEFS_FWRITE;
+        ReturnCode = InodeIndex;
+    }
+
+    /* A file of unknown size that is being created owns all of free memory until it is closed */
+    else if (EEFS_LibHasOpenCreat(InodeTable) == FALSE) {
+
+        /* A deleted slot that ends at the start of free memory becomes the start of the new slot.  Otherwise the new slot
+         * starts at free memory and takes over the File Allocation Table entry of a deleted slot that has been reduced
+         * to a File Header, or a new entry is added to the File Allocation Table if there are none. */
+        if ((InodeIndex = EEFS_LibFindLastFreeSlot(InodeTable)) != EEFS_FILE_NOT_FOUND) {
+            *FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+        }
+        else {
+            if ((InodeIndex = EEFS_LibFindEmptySlot(InodeTable)) == EEFS_FILE_NOT_FOUND) {
+                InodeIndex = InodeTable->NumberOfFiles;
+            }
+            *FileHeaderPointer = InodeTable->FreeMemoryPointer;
+        }
+        *MaxFileSize = (uint32)((InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize) - *FileHeaderPointer);
+
+        /* Make sure there is a free slot in the File Allocation Table */
+        if (InodeIndex < EEFS_MAX_FILES) {
+
+            /* Make sure there is enough room in eeprom for at least a file header */
+            if (*MaxFileSize <= sizeof(EEFS_FileHeader_t)) {
+                ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+            }
+
+            /* If the size of the file is not known all free eeprom is allocated to the file until it is closed */
+            else if (ReservedBytes == EEFS_UNKNOWN_FILE_SIZE) {
+                *MaxFileSize -= sizeof(EEFS_FileHeader_t);
+                *Mode = (EEFS_FCREAT | EEFS_FWRITE);
+                ReturnCode = InodeIndex;
+            }
+
+            /* Otherwise exactly the requested slot, rounded up to a 4 byte boundary, is taken from free memory */
+            else if (ReservedBytes <= (*MaxFileSize - sizeof(EEFS_FileHeader_t))) {
+                *MaxFileSize = EEFS_MIN((uint32)EEFS_ROUND_UP(ReservedBytes, 4), (*MaxFileSize - sizeof(EEFS_FileHeader_t)));
+                *ReserveSlot = TRUE;
+                *Mode = EEFS_FWRITE;
+                ReturnCode = InodeIndex;
+            }
+            else { /* not enough free space in eeprom */
+                ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+            }
+        }
+        else { /* no available slots in the File Allocation Table */
+            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+        }
+    }
+    else { /* a file creat is already in progress */
+        ReturnCode = EEFS_PERMISSION_DENIED;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibFindNewSlot() */
+
+/* Claims a slot found by EEFS_LibFindNewSlot() by writing FileHeader to it.  The slot that is taken over is moved to free
+ * memory first if needed.  When a file of unknown size is created the MaxFileSize is temporarily set to all free eeprom.  The
+ * FreeMemoryPointer and the FreeMemorySize variables are NOT updated until the file is closed and the actual file size is
+ * known.  Setting EEFS_FCREAT in the Mode variable will prevent any other slots being taken from free memory until the
+ * current one is complete and the FreeMemoryPointer and the FreeMemorySize variables are updated.  A slot that is reserved in
+ * free memory is added to the File Allocation Table now.  The caller must hold the volume write lock. */
+void EEFS_LibWriteNewSlot(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, void *FileHeaderPointer, uint32 MaxFileSize, uint8 ReserveSlot, EEFS_FileHeader_t *FileHeader)
+{
+    void                               *EndOfFreeMemory;
+
+    if ((uint32)InodeIndex == InodeTable->NumberOfFiles) {
+        InodeTable->NumberOfFiles++;
+        InodeTable->File[InodeIndex].FileHeaderPointer = FileHeaderPointer;
+        EEFS_LibWriteFileHeader(InodeTable, InodeIndex, FileHeader);
+    }
+    else if (InodeTable->File[InodeIndex].FileHeaderPointer != FileHeaderPointer) {
+        EEFS_LibMoveEmptySlot(InodeTable, InodeIndex, FileHeaderPointer, FileHeader);
+    }
+    else {
+        EEFS_LibWriteFileHeader(InodeTable, InodeIndex, FileHeader);
+    }
+
+    /* The slot exists with a size of 0 until it is written */
+    if (ReserveSlot == TRUE) {
+        EndOfFreeMemory = InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize;
+        InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
+        InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + MaxFileSize;
+        InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+        EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+    }
+    InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
+    EEFS_LibAccountSlot(InodeTable, InodeIndex);
+
+} /* End of EEFS_LibWriteNewSlot() */
+
 /* Closes a file.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error.  If a new file is being created then the
- * MaxFileSize is updated to be the actual size of the file + EEFS_DEFAULT_CREAT_SPARE_BYTES. Note that the File Allocation
- * Table is not updated until the file is closed to reduce the number of EEPROM Writes. */
+ * MaxFileSize is updated to be the actual size of the file plus the spare bytes given by the spare byte policy of the volume.
+ * Note that the File Allocation Table is not updated until the file is closed to reduce the number of EEPROM Writes. */
 int32 EEFS_LibClose(int32 FileDescriptor)
 {
-    EEFS_FileAllocationTable_t         *FileAllocationTable;
-    EEFS_FileAllocationTableHeader_t    FileAllocationTableHeader;
-    EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
+    EEFS_FileDescriptor_t              *FileDescriptorPointer;
     EEFS_FileHeader_t                   FileHeader;
     uint32                              MaxFileSize;
+    uint32                              PreviousMaxFileSize;
+    uint32                              SpareBytes;
+    void                               *EndOfFreeMemory;
     EEFS_InodeTable_t                  *InodeTable;
     uint32                              InodeIndex;
     int32                               ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
+
+        InodeTable = FileDescriptorPointer->InodeTable;
+        InodeIndex = FileDescriptorPointer->InodeIndex;
+
+        /* The File Header is only updated if the file was open for write or creat */
+        if (FileDescriptorPointer->Mode & (EEFS_FCREAT | EEFS_FWRITE)) {
+            EEFS_LIB_INODE_WRLOCK(InodeTable);
+        }
+        else {
+            EEFS_LIB_INODE_RDLOCK(InodeTable);
+        }
 
         /* Note that both the EEFS_FCREAT and EEFS_FWRITE bits are set when a new file is created, so we check for the
          * EEFS_CREAT bit first */
-        if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FCREAT) {
+        if (FileDescriptorPointer->Mode & EEFS_FCREAT) {
 
-            InodeTable = EEFS_FileDescriptorTable[FileDescriptor].InodeTable;
-            InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
-
-            /* Calculate the New MaxFileSize and round it up to a 4 byte boundary */
-            MaxFileSize = EEFS_ROUND_UP((EEFS_FileDescriptorTable[FileDescriptor].FileSize + EEFS_DEFAULT_CREAT_SPARE_BYTES), 4);
+            /* Calculate the New MaxFileSize from the spare byte policy and round it up to a 4 byte boundary */
+            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+            PreviousMaxFileSize = EEFS_LibTakeFromSpareHistory(InodeTable, FileHeader.Filename);
+            SpareBytes = EEFS_LibSpareBytes(InodeTable, FileHeader.Filename, FileDescriptorPointer->FileSize, PreviousMaxFileSize);
+            SpareBytes = EEFS_MIN(SpareBytes, (FileDescriptorPointer->MaxFileSize - FileDescriptorPointer->FileSize));
+            MaxFileSize = EEFS_ROUND_UP((FileDescriptorPointer->FileSize + SpareBytes), 4);
 
             /* Make sure since we added some spare bytes to the end of the file we do not exceed the free memory size */
-            MaxFileSize = EEFS_MIN(MaxFileSize, (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t)));
+            MaxFileSize = EEFS_MIN(MaxFileSize, FileDescriptorPointer->MaxFileSize);
+
+            InodeTable->SpareStats.SizedFiles++;
+            InodeTable->SpareStats.SpareBytes += (MaxFileSize - FileDescriptorPointer->FileSize);
+            if ((InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_LEARNED) && (PreviousMaxFileSize > 0)) {
+                InodeTable->SpareStats.LearnedFiles++;
+            }
 
-            /* Update the Inode Table with the new MaxFileSize */
-            InodeTable->FreeMemoryPointer += (sizeof(EEFS_FileHeader_t) + MaxFileSize);
-            InodeTable->FreeMemorySize -= (sizeof(EEFS_FileHeader_t) + MaxFileSize);
+            /* Update the Inode Table with the new MaxFileSize.  Free memory now starts at the end of the new slot, which is
+             * below the old start of free memory if the file reused a deleted slot and stayed within it. */
+            EndOfFreeMemory = InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize;
             InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
-            
-            /* Update the File Header */
-            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-            FileHeader.FileSize = EEFS_FileDescriptorTable[FileDescriptor].FileSize;
-            FileHeader.Crc = 0;      /* Automatically updating the CRC is not supported at this time */
-            EEFS_LIB_EEPROM_WRITE(EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-            EEFS_LIB_EEPROM_FLUSH;
+            InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + MaxFileSize;
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
 
-            /* Add the new entry to the File Allocation Table */
-            FileAllocationTable = (void *)InodeTable->BaseAddress;
+            /* Add the new entry to the File Allocation Table.  This is done before the File Header is updated so the File
+             * Header of a reused slot never describes more data than its File Allocation Table entry. */
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
 
-            FileAllocationTableEntry.FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
-            FileAllocationTableEntry.MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
-            EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->File[InodeIndex], &FileAllocationTableEntry, sizeof(EEFS_FileAllocationTableEntry_t));
-            EEFS_LIB_EEPROM_FLUSH;
+            /* Update the File Header */
+            FileHeader.FileSize = FileDescriptorPointer->FileSize;
+            FileHeader.Crc = 0;      /* Automatically updating the CRC is not supported at this time */
+            EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELDS(Crc, FileSize));
 
             /* This is done last to reduce the chance that a reset during a file creat will cause the file system to be corrupted.  If a 
                reset occurs the new file will not exist in the file system until the following lines of code are executed. */
-            EEFS_LIB_EEPROM_READ(&FileAllocationTableHeader, &FileAllocationTable->Header, sizeof(EEFS_FileAllocationTableHeader_t));
-            FileAllocationTableHeader.FreeMemoryOffset = (uint32)(InodeTable->FreeMemoryPointer - InodeTable->BaseAddress);
-            FileAllocationTableHeader.FreeMemorySize = InodeTable->FreeMemorySize;
-            FileAllocationTableHeader.NumberOfFiles = InodeTable->NumberOfFiles;
-            EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->Header, &FileAllocationTableHeader, sizeof(EEFS_FileAllocationTableHeader_t));
-            EEFS_LIB_EEPROM_FLUSH;
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
         }
-        else if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FWRITE) {
-            
+        else if (FileDescriptorPointer->Mode & EEFS_FWRITE) {
+
             /* Update the File Header */
-            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-            FileHeader.FileSize = EEFS_FileDescriptorTable[FileDescriptor].FileSize;
+            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+            FileHeader.FileSize = FileDescriptorPointer->FileSize;
             FileHeader.ModificationDate = EEFS_LIB_TIME;
             FileHeader.Crc = 0;   /* Automatically updating the CRC is not supported at this time */
-            EEFS_LIB_EEPROM_WRITE(EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-            EEFS_LIB_EEPROM_FLUSH;
+            EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELDS(Crc, ModificationDate));
         }
 
+        EEFS_LIB_LOCK;
         EEFS_LibFreeFileDescriptor(FileDescriptor);
+        EEFS_LIB_UNLOCK;
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
         ReturnCode = EEFS_SUCCESS;
     }
     else { /* invalid file descriptor */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibClose() */
 
+/* Makes the data written to an open file so far survive a reset without closing the file.  The FileSize, ModificationDate
+ * and Crc of the File Header are updated and everything written is programmed into EEPROM.  If a new file is being created
+ * its File Allocation Table entry is also committed with a provisional MaxFileSize that just holds the data written so far,
+ * and the File Allocation Table Header in EEPROM places free memory after the provisional slot, while the file keeps all of
+ * free memory in the Inode Table until it is closed.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFsync(int32 FileDescriptor)
+{
+    EEFS_FileDescriptor_t              *FileDescriptorPointer;
+    EEFS_FileHeader_t                   FileHeader;
+    uint32                              MaxFileSize;
+    uint32                              ProvisionalMaxFileSize;
+    void                               *ProvisionalSlotEnd;
+    void                               *FreeMemoryPointer;
+    uint32                              FreeMemorySize;
+    EEFS_InodeTable_t                  *InodeTable;
+    uint32                              InodeIndex;
+    int32                               ReturnCode;
+
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
+
+        InodeTable = FileDescriptorPointer->InodeTable;
+        InodeIndex = FileDescriptorPointer->InodeIndex;
+
+        /* The File Header is only updated if the file is open for write or creat */
+        if (FileDescriptorPointer->Mode & (EEFS_FCREAT | EEFS_FWRITE)) {
+
+            EEFS_LIB_INODE_WRLOCK(InodeTable);
+
+            /* A reset before the file is closed leaves the provisional slot and the rest of the memory taken by the file is
+             * free memory again.  The File Allocation Table entry is written before the File Header for the same reason as in
+             * EEFS_LibClose(). */
+            ProvisionalMaxFileSize = 0;
+            if (FileDescriptorPointer->Mode & EEFS_FCREAT) {
+                MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                ProvisionalMaxFileSize = EEFS_MIN((uint32)EEFS_ROUND_UP(FileDescriptorPointer->FileSize, 4), MaxFileSize);
+                InodeTable->File[InodeIndex].MaxFileSize = ProvisionalMaxFileSize;
+                EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+                InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
+                EEFS_LibAccountSlot(InodeTable, InodeIndex);
+            }
+
+            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+            FileHeader.FileSize = FileDescriptorPointer->FileSize;
+            FileHeader.ModificationDate = EEFS_LIB_TIME;
+            FileHeader.Crc = 0;   /* Automatically updating the CRC is not supported at this time */
+            EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELDS(Crc, ModificationDate));
+
+            /* Makes the new file part of the file system in EEPROM.  Free memory in EEPROM must not overlap the provisional
+             * slot or a reader that trusts the File Allocation Table Header would put a new file on top of it, so free
+             * memory is moved past the provisional slot just while the header is written. */
+            if (FileDescriptorPointer->Mode & EEFS_FCREAT) {
+                FreeMemoryPointer = InodeTable->FreeMemoryPointer;
+                FreeMemorySize = InodeTable->FreeMemorySize;
+                ProvisionalSlotEnd = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + ProvisionalMaxFileSize;
+                if (ProvisionalSlotEnd > FreeMemoryPointer) {
+                    InodeTable->FreeMemoryPointer = ProvisionalSlotEnd;
+                    InodeTable->FreeMemorySize = (uint32)((FreeMemoryPointer + FreeMemorySize) - ProvisionalSlotEnd);
+                }
+                EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+                InodeTable->FreeMemoryPointer = FreeMemoryPointer;
+                InodeTable->FreeMemorySize = FreeMemorySize;
+            }
+        }
+        else {
+            EEFS_LIB_INODE_RDLOCK(InodeTable);
+        }
+
+        EEFS_LIB_EEPROM_SYNC;
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid file descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibFsync() */
+
 /* Read from a file.  Returns the number of bytes read, 0 bytes if we have reached the end of file, or EEFS_INVALID_ARGUMENT
  * on error. */
 int32 EEFS_LibRead(int32 FileDescriptor, void *Buffer, uint32 Length)
 {
+    EEFS_FileDescriptor_t  *FileDescriptorPointer;
     uint32      BytesToRead;
+    uint32      BytesRead;
+    uint32      SpanLength;
     int32       ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
 
         if (Buffer != NULL) {
             
-            if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FREAD) {
-
-                BytesToRead = EEFS_MIN((EEFS_FileDescriptorTable[FileDescriptor].FileSize - EEFS_FileDescriptorTable[FileDescriptor].ByteOffset), Length);
-                EEFS_LIB_EEPROM_READ(Buffer, EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer, BytesToRead);
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer += BytesToRead;
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset += BytesToRead;
-                ReturnCode = BytesToRead;
+            if (FileDescriptorPointer->Mode & EEFS_FREAD) {
+
+                /* The data is read one slot at a time since the extents of a file are not contiguous */
+                BytesToRead = EEFS_MIN((FileDescriptorPointer->FileSize - FileDescriptorPointer->ByteOffset), Length);
+                BytesRead = 0;
+                SpanLength = 1;
+                while ((BytesRead < BytesToRead) && (SpanLength > 0)) {
+                    SpanLength = EEFS_MIN(EEFS_LibContiguousBytes(FileDescriptorPointer), (BytesToRead - BytesRead));
+                    EEFS_LIB_EEPROM_READ((Buffer + BytesRead), FileDescriptorPointer->FileDataPointer, SpanLength);
+                    FileDescriptorPointer->FileDataPointer += SpanLength;
+                    FileDescriptorPointer->ByteOffset += SpanLength;
+                    BytesRead += SpanLength;
+                }
+                ReturnCode = BytesRead;
             }
             else { /* file not open for reading */
                 ReturnCode = EEFS_PERMISSION_DENIED;
@@ -503,12 +907,12 @@ int32 EEFS_LibRead(int32 FileDescriptor, void *Buffer, uint32 Length)
         else { /* invalid buffer pointer */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
     }
     else { /* invalid file descriptor */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibRead() */
@@ -517,24 +921,46 @@ int32 EEFS_LibRead(int32 FileDescriptor, void *Buffer, uint32 Length)
  * on error. */
 int32 EEFS_LibWrite(int32 FileDescriptor, void *Buffer, uint32 Length)
 {
+    EEFS_FileDescriptor_t  *FileDescriptorPointer;
     uint32      BytesToWrite;
+    uint32      BytesWritten;
     int32       ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
 
         if (Buffer != NULL) {
             
-            if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FWRITE) {
-
-                BytesToWrite = EEFS_MIN((EEFS_FileDescriptorTable[FileDescriptor].MaxFileSize - EEFS_FileDescriptorTable[FileDescriptor].ByteOffset), Length);
-                EEFS_LIB_EEPROM_WRITE((void *)EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer, Buffer, BytesToWrite);
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer += BytesToWrite;
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset += BytesToWrite;
-                if (EEFS_FileDescriptorTable[FileDescriptor].ByteOffset > EEFS_FileDescriptorTable[FileDescriptor].FileSize) {
-                    EEFS_FileDescriptorTable[FileDescriptor].FileSize = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+            if (FileDescriptorPointer->Mode & EEFS_FWRITE) {
+
+                /* The write is cut short at the end of the last slot of the file, unless the file can be moved to a larger
+                 * slot or an extent can be added */
+                BytesWritten = 0;
+                BytesToWrite = 1;
+                while ((BytesWritten < Length) && (BytesToWrite > 0)) {
+                    BytesToWrite = EEFS_LibContiguousBytes(FileDescriptorPointer);
+                    if (BytesToWrite == 0) {
+#if (EEFS_RELOCATE_ON_GROW == TRUE)
+                        BytesToWrite = EEFS_LibGrowFile(FileDescriptorPointer, (Length - BytesWritten));
+#endif
+#if (EEFS_EXTENT_CHAINING == TRUE)
+                        if (BytesToWrite == 0) {
+                            BytesToWrite = EEFS_LibAddExtent(FileDescriptorPointer, (Length - BytesWritten));
+                        }
+#endif
+                        EEFS_LibCountRegrow(FileDescriptorPointer, BytesToWrite);
+                    }
+                    BytesToWrite = EEFS_MIN(BytesToWrite, (Length - BytesWritten));
+                    EEFS_LIB_EEPROM_WRITE((void *)FileDescriptorPointer->FileDataPointer, (Buffer + BytesWritten), BytesToWrite);
+                    FileDescriptorPointer->FileDataPointer += BytesToWrite;
+                    FileDescriptorPointer->ByteOffset += BytesToWrite;
+                    BytesWritten += BytesToWrite;
+
+                    /* The FileSize is kept up to date since a file that is moved to a larger slot is copied up to its FileSize */
+                    if (FileDescriptorPointer->ByteOffset > FileDescriptorPointer->FileSize) {
+                        FileDescriptorPointer->FileSize = FileDescriptorPointer->ByteOffset;
+                    }
                 }
-                ReturnCode = BytesToWrite;
+                ReturnCode = BytesWritten;
             }
             else { /* file not open for writing */
                 ReturnCode = EEFS_PERMISSION_DENIED;
@@ -543,12 +969,12 @@ int32 EEFS_LibWrite(int32 FileDescriptor, void *Buffer, uint32 Length)
         else { /* invalid buffer pointer */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
     }
     else { /* invalid file descriptor */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }   
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibWrite() */
@@ -559,80 +985,73 @@ int32 EEFS_LibWrite(int32 FileDescriptor, void *Buffer, uint32 Length)
  * on success, or EEFS_INVALID_ARGUMENT on error. */
 int32 EEFS_LibLSeek(int32 FileDescriptor, int32 ByteOffset, uint16 Origin)
 {
-    void       *BeginningOfFilePointer;
-    void       *EndOfFilePointer;
+    EEFS_FileDescriptor_t  *FileDescriptorPointer;
     int32       ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
-
-        BeginningOfFilePointer = EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
-        EndOfFilePointer = BeginningOfFilePointer + EEFS_FileDescriptorTable[FileDescriptor].FileSize;
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
 
         if (Origin == SEEK_SET) {
 
             if (ByteOffset < 0) {
                 ReturnCode = EEFS_INVALID_ARGUMENT;
             }
-            else if (ByteOffset > (int32)EEFS_FileDescriptorTable[FileDescriptor].FileSize) {
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = EndOfFilePointer;
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = EEFS_FileDescriptorTable[FileDescriptor].FileSize;
-                ReturnCode = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+            else if (ByteOffset > (int32)FileDescriptorPointer->FileSize) {
+                FileDescriptorPointer->ByteOffset = FileDescriptorPointer->FileSize;
+                ReturnCode = FileDescriptorPointer->ByteOffset;
             }
             else {
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = (BeginningOfFilePointer + ByteOffset);
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = ByteOffset;
-                ReturnCode = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+                FileDescriptorPointer->ByteOffset = ByteOffset;
+                ReturnCode = FileDescriptorPointer->ByteOffset;
             }
         }
         else if (Origin == SEEK_CUR) {
 
-            if ((int32)(ByteOffset + EEFS_FileDescriptorTable[FileDescriptor].ByteOffset) < 0) {
+            if ((int32)(ByteOffset + FileDescriptorPointer->ByteOffset) < 0) {
                 ReturnCode = EEFS_INVALID_ARGUMENT;
             }
-            else if ((int32)(ByteOffset + EEFS_FileDescriptorTable[FileDescriptor].ByteOffset) > (int32)EEFS_FileDescriptorTable[FileDescriptor].FileSize) {
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = EndOfFilePointer;
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = EEFS_FileDescriptorTable[FileDescriptor].FileSize;
-                ReturnCode = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+            else if ((int32)(ByteOffset + FileDescriptorPointer->ByteOffset) > (int32)FileDescriptorPointer->FileSize) {
+                FileDescriptorPointer->ByteOffset = FileDescriptorPointer->FileSize;
+                ReturnCode = FileDescriptorPointer->ByteOffset;
             }
             else {
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer += ByteOffset;
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset += ByteOffset;
-                ReturnCode = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+                FileDescriptorPointer->ByteOffset += ByteOffset;
+                ReturnCode = FileDescriptorPointer->ByteOffset;
             }
         }
         else if (Origin == SEEK_END) {
 
-            if ((int32)(ByteOffset + EEFS_FileDescriptorTable[FileDescriptor].FileSize) < 0) {
+            if ((int32)(ByteOffset + FileDescriptorPointer->FileSize) < 0) {
                 ReturnCode = EEFS_INVALID_ARGUMENT;
             }
             else if (ByteOffset > 0) {
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = EndOfFilePointer;
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = EEFS_FileDescriptorTable[FileDescriptor].FileSize;                
-                ReturnCode = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+                FileDescriptorPointer->ByteOffset = FileDescriptorPointer->FileSize;                
+                ReturnCode = FileDescriptorPointer->ByteOffset;
             }
             else {
-                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = (EndOfFilePointer + ByteOffset);
-                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = (EEFS_FileDescriptorTable[FileDescriptor].FileSize + ByteOffset);
-                ReturnCode = EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+                FileDescriptorPointer->ByteOffset = (FileDescriptorPointer->FileSize + ByteOffset);
+                ReturnCode = FileDescriptorPointer->ByteOffset;
             }
         }
         else { /* invalid Origin */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+
+        /* Point to the new file position, which may be in an extent of the file */
+        EEFS_LIB_INODE_RDLOCK(FileDescriptorPointer->InodeTable);
+        EEFS_LibSeekFileData(FileDescriptorPointer);
+        EEFS_LIB_INODE_UNLOCK(FileDescriptorPointer->InodeTable);
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
     }
     else { /* invalid file descriptor */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibLSeek() */
 
-/* Removes the specified file from the file system.  Note that this just marks the file as deleted and does not free the memory
- * in use by the file.  Once a file is deleted, the only way the slot can be reused is to manually write a new file into the
- * slot, i.e. there is no way to reuse the memory through a EEFS api function.  Returns a file descriptor on success,
+/* Removes the specified file from the file system.  Note that this just marks the file and its extents as deleted and does not
+ * free the memory in use by the file.  The memory is returned to free memory by EEFS_LibCompact().  Returns a file descriptor on success,
  * EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error. */
 int32 EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename)
 {
@@ -640,9 +1059,9 @@ int32 EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename)
     EEFS_FileHeader_t               FileHeader;
     int32                           ReturnCode;
     
-    EEFS_LIB_LOCK;
     if (InodeTable != NULL) {
 
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
         if (EEFS_LibIsValidFilename(Filename)) {
 
             /* If the file system is not write protected */
@@ -651,15 +1070,14 @@ int32 EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename)
                 if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
 
                     /* Can't delete a read only file */
-                    EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+                    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
                     if ((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) {
 
                         /* Does the file have any open file descriptors */
                         if (EEFS_LibFmode(InodeTable, InodeIndex) == 0) {
 
-                            memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t)); /* clears the InUse flag marking the file deleted */
-                            EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-                            EEFS_LIB_EEPROM_FLUSH;
+                            EEFS_LibAddToSpareHistory(InodeTable, InodeIndex);
+                            EEFS_LibDeleteFile(InodeTable, InodeIndex);
                             ReturnCode = EEFS_SUCCESS;
                         }
                         else { /* error file is open */
@@ -681,119 +1099,418 @@ int32 EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename)
         else { /* invalid filename size */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
     }
     else { /* invalid inode table */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibRemove() */
 
-/* Renames the specified file.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
- * or EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibRename(EEFS_InodeTable_t *InodeTable, char *OldFilename, char *NewFilename)
+/* Compacts the file system by moving files down over the slots of deleted files and returning the space to free memory.
+ * Each call stops once MaxBytesToCopy bytes have been written to EEPROM, except that at least one step is always taken, so
+ * the file system can be compacted incrementally by calling this function until it returns 0.  Files that are open, and
+ * their extents, are not moved.  Returns the number of bytes written to EEPROM, 0 if nothing more can be compacted, or EEFS_PERMISSION_DENIED,
+ * EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibCompact(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToCopy)
 {
-    int32                           InodeIndex;
-    EEFS_FileHeader_t               FileHeader;
+    int32                           BytesWritten;
+    int32                           StepBytesWritten;
     int32                           ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (InodeTable != NULL) {
-
-        if ((EEFS_LibIsValidFilename(OldFilename)) &&
-            (EEFS_LibIsValidFilename(NewFilename))) {
+    if ((InodeTable != NULL) && (MaxBytesToCopy > 0)) {
 
-            /* If the file system is not write protected */
-            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
 
-                if ((EEFS_LibFindFile(InodeTable, NewFilename)) == EEFS_FILE_NOT_FOUND) {
+        /* If the file system is not write protected */
+        if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
 
-                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, OldFilename)) != EEFS_FILE_NOT_FOUND) {
+            /* A file that is being created owns all of free memory, which is also where the compaction journal is kept */
+            if (EEFS_LibHasOpenCreat(InodeTable) == FALSE) {
 
-                        /* Can't rename a read only file */
-                        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-                        if ((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) {
+                BytesWritten = EEFS_LibTrimFreeMemory(InodeTable);
+                StepBytesWritten = 1;
+                while ((StepBytesWritten > 0) && ((uint32)BytesWritten < MaxBytesToCopy)) {
 
-                            strncpy(FileHeader.Filename, NewFilename, EEFS_MAX_FILENAME_SIZE);
-                            EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-                            EEFS_LIB_EEPROM_FLUSH;
-                            ReturnCode = EEFS_SUCCESS;
-                        }
-                        else { /* error read only file */
-                            ReturnCode = EEFS_PERMISSION_DENIED;
-                        }
+                    /* The first step is not limited so a file larger than MaxBytesToCopy can still be moved */
+                    if (BytesWritten == 0) {
+                        StepBytesWritten = EEFS_LibCompactStep(InodeTable, EEFS_COMPACT_NO_LIMIT);
                     }
-                    else { /* file not found */
-                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    else {
+                        StepBytesWritten = EEFS_LibCompactStep(InodeTable, (MaxBytesToCopy - BytesWritten));
                     }
+                    BytesWritten += StepBytesWritten;
                 }
-                else { /* new filename already exists */
-                    ReturnCode = EEFS_PERMISSION_DENIED;
-                }
+
+                /* Compaction moves and resizes the slots of deleted files */
+                EEFS_LibBuildFreeSlotList(InodeTable);
+                ReturnCode = BytesWritten;
+            }
+            else { /* a file creat is in progress */
+                ReturnCode = EEFS_PERMISSION_DENIED;
             }
-            else { /* file system is write protected */
-                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
-            }                
         }
-        else { /* invalid filename size */
-            ReturnCode = EEFS_INVALID_ARGUMENT;
+        else { /* file system is write protected */
+            ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
         }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
     }
-    else { /* invalid inode table */
+    else { /* invalid inode table or byte limit */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
-    
-} /* End of EEFS_LibRename() */
 
-/* Returns file information for the specified filename in StatBuffer.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND,
- * or EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char *Filename, EEFS_Stat_t *StatBuffer)
+} /* End of EEFS_LibCompact() */
+
+/* Grows the slot of the specified file so it can hold at least NewMaxFileSize bytes, moving the file to free memory if its
+ * slot cannot be extended in place.  A slot that is already large enough is not changed.  The file must not be open and
+ * must not have extents.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * EEFS_NO_SPACE_LEFT_ON_DEVICE, EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibResize(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 NewMaxFileSize)
 {
     int32                           InodeIndex;
     EEFS_FileHeader_t               FileHeader;
     int32                           ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (InodeTable != NULL)  {
+    if (InodeTable != NULL) {
 
-        if (StatBuffer != NULL) {
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        if (EEFS_LibIsValidFilename(Filename)) {
 
-            if (EEFS_LibIsValidFilename(Filename)) {
+            /* If the file system is not write protected */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
 
                 if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
 
-                    EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-                    StatBuffer->InodeIndex = InodeIndex;
-                    StatBuffer->Attributes = FileHeader.Attributes;
-                    StatBuffer->FileSize = FileHeader.FileSize;
-                    StatBuffer->ModificationDate = FileHeader.ModificationDate;
-                    StatBuffer->CreationDate = FileHeader.CreationDate;
-                    StatBuffer->Crc = FileHeader.Crc;
-                    strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
-                    ReturnCode = EEFS_SUCCESS;
+                    /* The File Descriptors of an open file point into its slot, and the extents of a file follow a full slot */
+                    if ((EEFS_LibFmode(InodeTable, InodeIndex) == 0) &&
+                        (EEFS_LibHasNextExtent(InodeTable, InodeIndex) == FALSE)) {
+
+                        if (NewMaxFileSize <= (InodeTable->FreeMemorySize + InodeTable->File[InodeIndex].MaxFileSize)) {
+                            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                            ReturnCode = EEFS_LibRelocateFile(InodeTable, InodeIndex, (uint32)EEFS_ROUND_UP(NewMaxFileSize, 4),
+                                                              FileHeader.FileSize);
+                        }
+                        else { /* not enough free space in eeprom */
+                            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+                        }
+                    }
+                    else { /* error file is open or has extents */
+                        ReturnCode = EEFS_PERMISSION_DENIED;
+                    }
                 }
                 else { /* file not found */
                     ReturnCode = EEFS_FILE_NOT_FOUND;
                 }
             }
-            else { /* invalid filename */
-                ReturnCode = EEFS_INVALID_ARGUMENT;
+            else { /* file system is write protected */
+                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+            }
+        }
+        else { /* invalid filename size */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibResize() */
+
+/* Truncates a file that is open for write to Length bytes without releasing any space, so the file can be rewritten up to
+ * its old size after it has been truncated.  Truncate cannot make a file longer since the file system does not support
+ * holes.  The file pointer is moved to the new end of the file if it was past it.  Returns EEFS_SUCCESS on success,
+ * EEFS_PERMISSION_DENIED or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFtruncate(int32 FileDescriptor, uint32 Length)
+{
+    return(EEFS_LibFtruncateFile(FileDescriptor, Length, FALSE));
+
+} /* End of EEFS_LibFtruncate() */
+
+/* Truncates a file that is open for write to Length bytes like EEFS_LibFtruncate(), then releases the space past Length as
+ * EEFS_LibTruncate() does if no other File Descriptor has the file open.  Returns EEFS_SUCCESS on success,
+ * EEFS_PERMISSION_DENIED or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFtruncateRelease(int32 FileDescriptor, uint32 Length)
+{
+    return(EEFS_LibFtruncateFile(FileDescriptor, Length, TRUE));
+
+} /* End of EEFS_LibFtruncateRelease() */
+
+/* Truncates a file that is open for write to Length bytes.  When ReleaseSpace is TRUE the space past Length is released
+ * unless another File Descriptor has the file open. */
+int32 EEFS_LibFtruncateFile(int32 FileDescriptor, uint32 Length, uint8 ReleaseSpace)
+{
+    EEFS_FileDescriptor_t              *FileDescriptorPointer;
+    EEFS_InodeTable_t                  *InodeTable;
+    uint32                              InodeIndex;
+    int32                               ReturnCode;
+
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
+
+        if (FileDescriptorPointer->Mode & EEFS_FWRITE) {
+
+            if (Length <= FileDescriptorPointer->FileSize) {
+
+                /* The File Header of a file that is being created is written when the file is closed */
+                if ((FileDescriptorPointer->Mode & EEFS_FCREAT) == 0) {
+
+                    InodeTable = FileDescriptorPointer->InodeTable;
+                    InodeIndex = FileDescriptorPointer->InodeIndex;
+                    EEFS_LIB_INODE_WRLOCK(InodeTable);
+
+                    /* The FileDataPointers of other File Descriptors may point into the space that would be released */
+                    if ((InodeTable->File[InodeIndex].WriteCount != 1) ||
+                        (InodeTable->File[InodeIndex].ReadCount != ((FileDescriptorPointer->Mode & EEFS_FREAD) ? 1 : 0))) {
+                        ReleaseSpace = FALSE;
+                    }
+                    EEFS_LibTruncateFile(InodeTable, InodeIndex, Length, ReleaseSpace);
+                    FileDescriptorPointer->FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+                    FileDescriptorPointer->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                    EEFS_LIB_INODE_UNLOCK(InodeTable);
+                }
+
+                FileDescriptorPointer->FileSize = Length;
+                FileDescriptorPointer->ByteOffset = EEFS_MIN(FileDescriptorPointer->ByteOffset, Length);
+                EEFS_LIB_INODE_RDLOCK(FileDescriptorPointer->InodeTable);
+                EEFS_LibSeekFileData(FileDescriptorPointer);
+                EEFS_LIB_INODE_UNLOCK(FileDescriptorPointer->InodeTable);
+                ReturnCode = EEFS_SUCCESS;
+            }
+            else { /* truncate can not extend a file */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
+            }
+        }
+        else { /* file not open for writing */
+            ReturnCode = EEFS_PERMISSION_DENIED;
+        }
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
+    }
+    else { /* invalid file descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibFtruncateFile() */
+
+/* Truncates the specified file to Length bytes.  The extents of the file that are past Length are deleted, and if the last
+ * slot of the file ends at free memory it is shrunk to Length plus the spare bytes given by the spare byte policy of the
+ * volume and the rest is returned to free memory.  The file must not be open.  Truncate cannot make a file longer since the
+ * file system does not support holes.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibTruncate(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Length)
+{
+    int32                           InodeIndex;
+    EEFS_FileHeader_t               FileHeader;
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL) {
+
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        if (EEFS_LibIsValidFilename(Filename)) {
+
+            /* If the file system is not write protected */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+
+                if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                    /* Can't truncate a read only file or a file that is open */
+                    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                    if (((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) &&
+                        (EEFS_LibFmode(InodeTable, InodeIndex) == 0)) {
+
+                        if (Length <= FileHeader.FileSize) {
+                            EEFS_LibTruncateFile(InodeTable, InodeIndex, Length, TRUE);
+                            ReturnCode = EEFS_SUCCESS;
+                        }
+                        else { /* truncate can not extend a file */
+                            ReturnCode = EEFS_INVALID_ARGUMENT;
+                        }
+                    }
+                    else { /* error read only file or file is open */
+                        ReturnCode = EEFS_PERMISSION_DENIED;
+                    }
+                }
+                else { /* file not found */
+                    ReturnCode = EEFS_FILE_NOT_FOUND;
+                }
+            }
+            else { /* file system is write protected */
+                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+            }
+        }
+        else { /* invalid filename size */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibTruncate() */
+
+/* Sets the spare byte policy of the volume, which chooses the spare bytes added to the slot of a file that is created by
+ * EEFS_LibCreat() when it is closed.  Parameter is the number of spare bytes for EEFS_SPARE_POLICY_FIXED, the percentage of
+ * the file size for EEFS_SPARE_POLICY_PERCENT, the smallest slot for EEFS_SPARE_POLICY_POWER_OF_TWO, the spare bytes of a
+ * file that is not in the spare history for EEFS_SPARE_POLICY_LEARNED, and is passed to Function for
+ * EEFS_SPARE_POLICY_CUSTOM.  Function is ignored by the other policies.  Returns EEFS_SUCCESS on success or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibSetSparePolicy(EEFS_InodeTable_t *InodeTable, uint32 Policy, uint32 Parameter, EEFS_SparePolicyFunction_t Function)
+{
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL) {
+
+        if ((Policy <= EEFS_SPARE_POLICY_LEARNED) ||
+            ((Policy == EEFS_SPARE_POLICY_CUSTOM) && (Function != NULL))) {
+
+            EEFS_LIB_INODE_WRLOCK(InodeTable);
+            InodeTable->SparePolicy.Policy = Policy;
+            InodeTable->SparePolicy.Parameter = Parameter;
+            InodeTable->SparePolicy.Function = (Policy == EEFS_SPARE_POLICY_CUSTOM) ? Function : NULL;
+            EEFS_LIB_INODE_UNLOCK(InodeTable);
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* invalid policy or policy function */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibSetSparePolicy() */
+
+/* Returns the spare byte statistics of the volume in SpareStats.  If Reset is TRUE the statistics are cleared after they are
+ * read.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibGetSpareStats(EEFS_InodeTable_t *InodeTable, EEFS_SpareStats_t *SpareStats, uint8 Reset)
+{
+    int32                           ReturnCode;
+
+    if ((InodeTable != NULL) && (SpareStats != NULL)) {
+
+        /* The statistics are updated under the write lock */
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        memcpy(SpareStats, &InodeTable->SpareStats, sizeof(EEFS_SpareStats_t));
+        if (Reset == TRUE) {
+            memset(&InodeTable->SpareStats, 0, sizeof(EEFS_SpareStats_t));
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid inode table or spare stats */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibGetSpareStats() */
+
+/* Renames the specified file.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibRename(EEFS_InodeTable_t *InodeTable, char *OldFilename, char *NewFilename)
+{
+    int32                           InodeIndex;
+    EEFS_FileHeader_t               FileHeader;
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL) {
+
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        if ((EEFS_LibIsValidFilename(OldFilename)) &&
+            (EEFS_LibIsValidFilename(NewFilename))) {
+
+            /* If the file system is not write protected */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+
+                if ((EEFS_LibFindFile(InodeTable, NewFilename)) == EEFS_FILE_NOT_FOUND) {
+
+                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, OldFilename)) != EEFS_FILE_NOT_FOUND) {
+
+                        /* Can't rename a read only file */
+                        EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                        if ((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) {
+
+                            strncpy(FileHeader.Filename, NewFilename, EEFS_MAX_FILENAME_SIZE);
+                            EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(Filename));
+                            ReturnCode = EEFS_SUCCESS;
+                        }
+                        else { /* error read only file */
+                            ReturnCode = EEFS_PERMISSION_DENIED;
+                        }
+                    }
+                    else { /* file not found */
+                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    }
+                }
+                else { /* new filename already exists */
+                    ReturnCode = EEFS_PERMISSION_DENIED;
+                }
+            }
+            else { /* file system is write protected */
+                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+            }                
+        }
+        else { /* invalid filename size */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+    
+} /* End of EEFS_LibRename() */
+
+/* Returns file information for the specified filename in StatBuffer.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND,
+ * or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char *Filename, EEFS_Stat_t *StatBuffer)
+{
+    int32                           InodeIndex;
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL)  {
+
+        EEFS_LIB_INODE_RDLOCK(InodeTable);
+        if (StatBuffer != NULL) {
+
+            if (EEFS_LibIsValidFilename(Filename)) {
+
+                if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                    EEFS_LibFillStat(InodeTable, InodeIndex, StatBuffer);
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* file not found */
+                    ReturnCode = EEFS_FILE_NOT_FOUND;
+                }
+            }
+            else { /* invalid filename */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
             }
         }
         else { /* invalid stat buffer */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
     }
     else { /* invalid inode table */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
     
 } /* End of EEFS_LibStat() */
@@ -802,284 +1519,1781 @@ int32 EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char *Filename, EEFS_Stat_t *S
  * EEFS_INVALID_ARGUMENT on error. */
 int32 EEFS_LibFstat(int32 FileDescriptor, EEFS_Stat_t *StatBuffer)
 {
-    EEFS_FileHeader_t               FileHeader;
+    EEFS_FileDescriptor_t          *FileDescriptorPointer;
     int32                           ReturnCode;
 
-    EEFS_LIB_LOCK;
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
+    if ((FileDescriptorPointer = EEFS_LibLockFileDescriptor(FileDescriptor)) != NULL) {
     
         if (StatBuffer != NULL) {
 
-            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-            StatBuffer->InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
-            StatBuffer->Attributes = FileHeader.Attributes;
-            StatBuffer->FileSize = FileHeader.FileSize;
-            StatBuffer->ModificationDate = FileHeader.ModificationDate;
-            StatBuffer->CreationDate = FileHeader.CreationDate;
-            StatBuffer->Crc = FileHeader.Crc;
-            strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
+            EEFS_LIB_INODE_RDLOCK(FileDescriptorPointer->InodeTable);
+            EEFS_LibFillStat(FileDescriptorPointer->InodeTable, FileDescriptorPointer->InodeIndex, StatBuffer);
+            EEFS_LIB_INODE_UNLOCK(FileDescriptorPointer->InodeTable);
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* invalid stat buffer */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
+    }
+    else { /* invalid file descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+    
+} /* End of EEFS_LibFstat() */
+
+/* Returns file information for every file in use in the caller supplied StatBuffers array in a single pass over the
+ * Inode Table.  At most MaxEntries entries are filled in, and Count is set to the number of files in use, which may be
+ * larger than MaxEntries.  If SpaceInfo is not NULL it is filled in with the space totals of the file system.  Returns
+ * EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibSnapshot(EEFS_InodeTable_t *InodeTable, EEFS_Stat_t *StatBuffers, uint32 MaxEntries, uint32 *Count, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    uint32                          FilesInUse;
+    uint32                          i;
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL) {
+
+        if (((StatBuffers != NULL) || (MaxEntries == 0)) && (Count != NULL)) {
+
+            FilesInUse = 0;
+            EEFS_LIB_INODE_RDLOCK(InodeTable);
+            for (i=0; (i < InodeTable->NumberOfFiles) && (FilesInUse < MaxEntries); i++) {
+
+                if (InodeTable->File[i].InUse == TRUE) {
+                    EEFS_LibFillStat(InodeTable, i, &StatBuffers[FilesInUse]);
+                    FilesInUse++;
+                }
+            }
+            if (SpaceInfo != NULL) {
+                EEFS_LibFillSpaceInfo(InodeTable, SpaceInfo);
+            }
+            *Count = InodeTable->SpaceInfo.FilesInUse;
+            EEFS_LIB_INODE_UNLOCK(InodeTable);
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* invalid stat buffers or count */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibSnapshot() */
+
+/* Returns the space totals of the file system in SpaceInfo, see Space Accounting.  The totals are kept up to date as files
+ * are changed, so this does not read EEPROM or scan the Inode Table.  Returns EEFS_SUCCESS on success or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibGetSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    int32                           ReturnCode;
+
+    if ((InodeTable != NULL) && (SpaceInfo != NULL)) {
+
+        EEFS_LIB_INODE_RDLOCK(InodeTable);
+        EEFS_LibFillSpaceInfo(InodeTable, SpaceInfo);
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid inode table or space info */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibGetSpaceInfo() */
+
+/* Waits until every change that has been made to the file system has been programmed into EEPROM, see EEPROM Access.  The
+ * volume lock is held so that a change that is in progress is finished first.  Returns EEFS_SUCCESS on success or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibSync(EEFS_InodeTable_t *InodeTable)
+{
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL) {
+
+        EEFS_LIB_INODE_RDLOCK(InodeTable);
+        EEFS_LIB_EEPROM_SYNC;
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibSync() */
+
+/* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
+ * attribute.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error.  To read file
+ * attributes use the stat function. */
+int32 EEFS_LibSetFileAttributes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
+{
+    int32                           InodeIndex;
+    EEFS_FileHeader_t               FileHeader;
+    int32                           ReturnCode;
+
+    if (InodeTable != NULL)  {
+
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        if (Attributes == EEFS_ATTRIBUTE_NONE || Attributes == EEFS_ATTRIBUTE_READONLY) {
+
+            if (EEFS_LibIsValidFilename(Filename)) {
+
+                /* If the file system is not write protected */
+                if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+
+                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                        EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                        FileHeader.Attributes = Attributes;
+                        EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(Attributes));
+                        ReturnCode = EEFS_SUCCESS;
+                    }
+                    else { /* file not found */
+                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    }
+                }
+                else { /* file system is write protected */
+                    ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+                }
+            }
+            else { /* invalid filename */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
+            }
+        }
+        else { /* invalid attributes */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode); 
+    
+} /* End of EEFS_LibSetFileAttributes() */
+
+/* Opens a file system for reading the file directory.  This should be followed by calls to EEFS_ReadDir() and EEFS_CloseDir().
+ * Up to EEFS_MAX_OPEN_DIRECTORIES directories can be read at the same time.  Returns a pointer to a directory descriptor
+ * on success and a NULL pointer on error. */
+EEFS_DirectoryDescriptor_t *EEFS_LibOpenDir(EEFS_InodeTable_t *InodeTable)
+{
+    EEFS_DirectoryDescriptor_t      *DirectoryDescriptor;
+    uint32                           i;
+
+    EEFS_LIB_LOCK;
+    if (InodeTable != NULL) {
+
+        DirectoryDescriptor = NULL;
+        for (i=0; i < EEFS_MAX_OPEN_DIRECTORIES; i++) {
+            if (EEFS_DirectoryDescriptorTable[i].InUse == FALSE) {
+
+                DirectoryDescriptor = &EEFS_DirectoryDescriptorTable[i];
+                DirectoryDescriptor->InUse = TRUE;
+                DirectoryDescriptor->InodeIndex = 0;
+                DirectoryDescriptor->InodeTable = InodeTable;
+                InodeTable->OpenDirCount++;
+                break;
+            }
+        }
+    }
+    else { /* invalid inode table */
+        DirectoryDescriptor = NULL;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(DirectoryDescriptor);
+    
+} /* End of EEFS_LibOpenDir() */
+
+/* Read the next file directory entry.  Returns a pointer to a EEFS_DirectoryEntry_t if successful or NULL if no more file
+ * directory entries exist or an error occurs.  Note that all entries are returned, even empty slots. (The InUse flag will be
+ * set to FALSE for empty slots and to EEFS_EXTENT_IN_USE for extents).  The entry belongs to the directory descriptor and is
+ * overwritten by the next call. */
+EEFS_DirectoryEntry_t *EEFS_LibReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+{
+    EEFS_DirectoryEntry_t          *DirectoryEntry;
+
+    if ((DirectoryDescriptor != NULL) &&
+        (EEFS_LibReadDir_r(DirectoryDescriptor, &DirectoryDescriptor->DirectoryEntry) == 1)) {
+        DirectoryEntry = &DirectoryDescriptor->DirectoryEntry;
+    }
+    else { /* no more directory entries or invalid directory descriptor */
+        DirectoryEntry = NULL;
+    }
+
+    return(DirectoryEntry);
+    
+} /* End of EEFS_LibReadDir() */
+
+/* Reentrant version of EEFS_LibReadDir() that copies the next file directory entry into the caller supplied DirectoryEntry.
+ * Returns 1 if an entry was read, 0 if no more file directory entries exist, or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibReadDir_r(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntry)
+{
+    EEFS_InodeTable_t              *InodeTable;
+    int32                           ReturnCode;
+
+    if ((DirectoryDescriptor != NULL) &&
+        (DirectoryDescriptor->InUse == TRUE) &&
+        (DirectoryEntry != NULL)) {
+
+        InodeTable = DirectoryDescriptor->InodeTable;
+        EEFS_LIB_INODE_RDLOCK(InodeTable);
+        if (DirectoryDescriptor->InodeIndex < InodeTable->NumberOfFiles) {
+            
+            EEFS_LibFillDirectoryEntry(InodeTable, DirectoryDescriptor->InodeIndex, DirectoryEntry);
+            DirectoryDescriptor->InodeIndex++;
+            ReturnCode = 1;
+        }
+        else { /* no more directory entries */
+            ReturnCode = 0;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid directory descriptor or directory entry */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibReadDir_r() */
+
+/* Reads up to MaxEntries file directory entries into the caller supplied DirectoryEntries array.  If Flags contains
+ * EEFS_READDIR_SKIP_DELETED then empty slots and extents are skipped.  Returns the number of entries read, 0 if no more file
+ * directory entries exist, or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibReadDirBatch(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntries, uint32 MaxEntries, uint32 Flags)
+{
+    EEFS_InodeTable_t              *InodeTable;
+    uint32                          EntriesRead;
+    int32                           ReturnCode;
+
+    if ((DirectoryDescriptor != NULL) &&
+        (DirectoryDescriptor->InUse == TRUE) &&
+        (DirectoryEntries != NULL) &&
+        ((Flags & ~EEFS_READDIR_SKIP_DELETED) == 0)) {
+
+        InodeTable = DirectoryDescriptor->InodeTable;
+        EntriesRead = 0;
+        EEFS_LIB_INODE_RDLOCK(InodeTable);
+        while ((EntriesRead < MaxEntries) &&
+               (DirectoryDescriptor->InodeIndex < InodeTable->NumberOfFiles)) {
+
+            if (((Flags & EEFS_READDIR_SKIP_DELETED) == 0) ||
+                (InodeTable->File[DirectoryDescriptor->InodeIndex].InUse == TRUE)) {
+
+                EEFS_LibFillDirectoryEntry(InodeTable, DirectoryDescriptor->InodeIndex, &DirectoryEntries[EntriesRead]);
+                EntriesRead++;
+            }
+            DirectoryDescriptor->InodeIndex++;
+        }
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+        ReturnCode = EntriesRead;
+    }
+    else { /* invalid directory descriptor, directory entries or flags */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibReadDirBatch() */
+
+/* Close file system for reading the file directory.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibCloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+{
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (DirectoryDescriptor != NULL) {
+
+        if (DirectoryDescriptor->InUse == TRUE) {
+
+            DirectoryDescriptor->InodeTable->OpenDirCount--;
+            memset(DirectoryDescriptor, 0, sizeof(EEFS_DirectoryDescriptor_t)); /* this sets InUse to FALSE */
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* directory descriptor not in use */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid directory descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+    
+} /* End of EEFS_LibCloseDir() */
+
+/* Returns TRUE if any files in the file system are open. */
+uint8 EEFS_LibHasOpenFiles(EEFS_InodeTable_t *InodeTable)
+{
+    if (InodeTable->OpenFileCount > 0) {
+        return(TRUE); /* a file is open */
+    }
+    return(FALSE);
+    
+} /* End of EEFS_LibHasOpenFiles() */
+
+/* Returns TRUE if a directory is open. */
+uint8 EEFS_LibHasOpenDir(EEFS_InodeTable_t *InodeTable)
+{
+    if (InodeTable->OpenDirCount > 0) {
+        return(TRUE); /* a directory is open */
+    }
+    return(FALSE);
+    
+} /* End of EEFS_LibHasOpenDir() */
+
+/* Returns TRUE if any files in the file system are open for create. */
+uint8 EEFS_LibHasOpenCreat(EEFS_InodeTable_t *InodeTable)
+{
+    if (InodeTable->OpenCreatCount > 0) {
+        return(TRUE); /* a file is open for creat */
+    }
+    return(FALSE);
+    
+} /* End of EEFS_LibHasOpenCreat() */
+
+/* Returns the combined file mode flags of all file descriptors that are open on the specified file.
+ * The return bit mask will be EEFS_FREAD if the file is open for read access, EEFS_WRITE if the file
+ * is open for write access, (EEFS_FREAD | EEFS_FWRITE) if the file is open for both read and write
+ * access, or EEFS_CREAT if a new file is being created. */
+uint32 EEFS_LibFmode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    uint32      Mode = 0;
+
+    if (InodeTable->File[InodeIndex].ReadCount > 0) {
+        Mode |= EEFS_FREAD;
+    }
+    if (InodeTable->File[InodeIndex].WriteCount > 0) {
+        Mode |= EEFS_FWRITE;
+    }
+    if (InodeTable->File[InodeIndex].CreatCount > 0) {
+        Mode |= EEFS_FCREAT;
+    }
+    return(Mode);
+    
+} /* End of EEFS_LibFmode() */
+
+/* Adds a newly opened file descriptor to the open file counts of the file and the volume. */
+void EEFS_LibAddOpenMode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Mode)
+{
+    if (Mode & EEFS_FREAD) {
+        InodeTable->File[InodeIndex].ReadCount++;
+    }
+    if (Mode & EEFS_FWRITE) {
+        InodeTable->File[InodeIndex].WriteCount++;
+    }
+    if (Mode & EEFS_FCREAT) {
+        InodeTable->File[InodeIndex].CreatCount++;
+        InodeTable->OpenCreatCount++;
+    }
+    InodeTable->OpenFileCount++;
+
+} /* End of EEFS_LibAddOpenMode() */
+
+/* Removes a closed file descriptor from the open file counts of the file and the volume. */
+void EEFS_LibRemoveOpenMode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Mode)
+{
+    if (Mode & EEFS_FREAD) {
+        InodeTable->File[InodeIndex].ReadCount--;
+    }
+    if (Mode & EEFS_FWRITE) {
+        InodeTable->File[InodeIndex].WriteCount--;
+    }
+    if (Mode & EEFS_FCREAT) {
+        InodeTable->File[InodeIndex].CreatCount--;
+        InodeTable->OpenCreatCount--;
+    }
+    InodeTable->OpenFileCount--;
+
+} /* End of EEFS_LibRemoveOpenMode() */
+
+/* Searches the filename hash index for a matching Filename.  Only files that are in use are included in the index so
+ * no EEPROM reads are required. */
+int32 EEFS_LibFindFile(EEFS_InodeTable_t *InodeTable, char *Filename)
+{
+    int32                           InodeIndex;
+
+    InodeIndex = InodeTable->FilenameHashTable[EEFS_LibHashFilename(Filename)];
+    while (InodeIndex != EEFS_END_OF_HASH_CHAIN) {
+        if (strncmp(Filename, InodeTable->File[InodeIndex].Filename, EEFS_MAX_FILENAME_SIZE) == 0)
+            return(InodeIndex);
+        InodeIndex = InodeTable->File[InodeIndex].NextHashEntry;
+    }
+    return(EEFS_FILE_NOT_FOUND);
+    
+} /* End of EEFS_LibFindFile() */
+
+/* Reads a File Header.  If the header cache is enabled the File Header is copied from the Inode Table, otherwise it is read
+ * from EEPROM. */
+void EEFS_LibReadFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader)
+{
+#if (EEFS_HEADER_CACHE == TRUE)
+    FileHeader->Crc = InodeTable->File[InodeIndex].Crc;
+    FileHeader->InUse = InodeTable->File[InodeIndex].InUse;
+    FileHeader->Attributes = InodeTable->File[InodeIndex].Attributes;
+    FileHeader->FileSize = InodeTable->File[InodeIndex].FileSize;
+    FileHeader->ModificationDate = InodeTable->File[InodeIndex].ModificationDate;
+    FileHeader->CreationDate = InodeTable->File[InodeIndex].CreationDate;
+    memcpy(FileHeader->Filename, InodeTable->File[InodeIndex].Filename, EEFS_MAX_FILENAME_SIZE);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    FileHeader->NextExtent = (uint32)(InodeTable->File[InodeIndex].NextExtent + 1);
+#endif
+#else
+    EEFS_LIB_EEPROM_READ(FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+#endif
+
+} /* End of EEFS_LibReadFileHeader() */
+
+/* Writes a File Header to EEPROM and updates the ram copy of the File Header. */
+void EEFS_LibWriteFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader)
+{
+    EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, FileHeader, 0, sizeof(EEFS_FileHeader_t));
+
+} /* End of EEFS_LibWriteFileHeader() */
+
+/* Writes FieldSize bytes of a File Header starting at FieldOffset to EEPROM and updates the ram copy of the File Header from
+ * all of FileHeader, so FileHeader must be the current File Header with only those fields changed.  Use the
+ * EEFS_FILE_HEADER_FIELD() and EEFS_FILE_HEADER_FIELDS() macros for FieldOffset and FieldSize.  All File Header writes must go
+ * through this function to keep the filename hash index, the header cache and the space totals consistent with EEPROM. */
+void EEFS_LibWriteFileHeaderFields(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader, uint32 FieldOffset, uint32 FieldSize)
+{
+    EEFS_LIB_EEPROM_WRITE((InodeTable->File[InodeIndex].FileHeaderPointer + FieldOffset), ((uint8 *)FileHeader + FieldOffset), FieldSize);
+    EEFS_LIB_EEPROM_FLUSH;
+
+    if (InodeTable->File[InodeIndex].InUse == TRUE) {
+        EEFS_LibRemoveFromFilenameIndex(InodeTable, InodeIndex);
+    }
+    else if (InodeTable->File[InodeIndex].InUse == FALSE) {
+        EEFS_LibRemoveFromFreeSlotList(InodeTable, InodeIndex);
+    }
+
+    EEFS_LibCacheFileHeader(InodeTable, InodeIndex, FileHeader);
+
+    if (InodeTable->File[InodeIndex].InUse == TRUE) {
+        EEFS_LibAddToFilenameIndex(InodeTable, InodeIndex);
+    }
+    else if (InodeTable->File[InodeIndex].InUse == FALSE) {
+        EEFS_LibAddToFreeSlotList(InodeTable, InodeIndex);
+    }
+    EEFS_LibAccountSlot(InodeTable, InodeIndex);
+
+} /* End of EEFS_LibWriteFileHeaderFields() */
+
+/* Fills in a directory entry from the ram copy of the File Header in the Inode Table, so no EEPROM reads are required. */
+void EEFS_LibFillDirectoryEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_DirectoryEntry_t *DirectoryEntry)
+{
+    DirectoryEntry->InodeIndex = InodeIndex;
+    DirectoryEntry->FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+    DirectoryEntry->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+    DirectoryEntry->InUse = InodeTable->File[InodeIndex].InUse;
+    memcpy(DirectoryEntry->Filename, InodeTable->File[InodeIndex].Filename, EEFS_MAX_FILENAME_SIZE);
+
+} /* End of EEFS_LibFillDirectoryEntry() */
+
+/* Fills in a stat buffer for the specified file.  The caller must hold the volume lock. */
+void EEFS_LibFillStat(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_Stat_t *StatBuffer)
+{
+    EEFS_FileHeader_t               FileHeader;
+
+    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+    StatBuffer->InodeIndex = InodeIndex;
+    StatBuffer->Attributes = FileHeader.Attributes;
+    StatBuffer->FileSize = FileHeader.FileSize;
+    StatBuffer->MaxFileSize = EEFS_LibFileCapacity(InodeTable, InodeIndex);
+    StatBuffer->ModificationDate = FileHeader.ModificationDate;
+    StatBuffer->CreationDate = FileHeader.CreationDate;
+    StatBuffer->Crc = FileHeader.Crc;
+    strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
+
+} /* End of EEFS_LibFillStat() */
+
+/* Fills in SpaceInfo from the space totals in the Inode Table.  The caller must hold the volume lock. */
+void EEFS_LibFillSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    memcpy(SpaceInfo, &InodeTable->SpaceInfo, sizeof(EEFS_SpaceInfo_t));
+    SpaceInfo->TotalSpace = (uint32)((InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize) - InodeTable->BaseAddress);
+
+    /* A file of unknown size that is being created owns all of free memory until it is closed */
+    if (EEFS_LibHasOpenCreat(InodeTable) == TRUE) {
+        SpaceInfo->FreeSpace = 0;
+    }
+    else {
+        SpaceInfo->FreeSpace = InodeTable->FreeMemorySize;
+    }
+
+    /* The FileSize of a file is never more than its slots hold unless its File Header was patched outside the api */
+    if (SpaceInfo->SlackSpace > SpaceInfo->AllocatedSpace) {
+        SpaceInfo->SlackSpace = 0;
+    }
+
+} /* End of EEFS_LibFillSpaceInfo() */
+
+/* Writes the free memory and number of files in the Inode Table to the File Allocation Table Header in EEPROM */
+void EEFS_LibWriteFileAllocationTableHeader(EEFS_InodeTable_t *InodeTable)
+{
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileAllocationTableHeader_t    FileAllocationTableHeader;
+
+    FileAllocationTable = (void *)InodeTable->BaseAddress;
+    EEFS_LIB_EEPROM_READ(&FileAllocationTableHeader, &FileAllocationTable->Header, sizeof(EEFS_FileAllocationTableHeader_t));
+    FileAllocationTableHeader.FreeMemoryOffset = (uint32)(InodeTable->FreeMemoryPointer - InodeTable->BaseAddress);
+    FileAllocationTableHeader.FreeMemorySize = InodeTable->FreeMemorySize;
+    FileAllocationTableHeader.NumberOfFiles = InodeTable->NumberOfFiles;
+    EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->Header, &FileAllocationTableHeader, sizeof(EEFS_FileAllocationTableHeader_t));
+    EEFS_LIB_EEPROM_FLUSH;
+
+} /* End of EEFS_LibWriteFileAllocationTableHeader() */
+
+/* Writes the location and size of a slot in the Inode Table to its File Allocation Table entry in EEPROM and updates the space
+ * totals */
+void EEFS_LibWriteFileAllocationTableEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
+
+    FileAllocationTable = (void *)InodeTable->BaseAddress;
+    FileAllocationTableEntry.FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+    FileAllocationTableEntry.MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+    EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->File[InodeIndex], &FileAllocationTableEntry, sizeof(EEFS_FileAllocationTableEntry_t));
+    EEFS_LIB_EEPROM_FLUSH;
+    EEFS_LibAccountSlot(InodeTable, InodeIndex);
+
+} /* End of EEFS_LibWriteFileAllocationTableEntry() */
+
+/* Returns the Inode of the slot with the lowest address above Address, or EEFS_FILE_NOT_FOUND if there are no more slots.
+ * Once a file system has been compacted the slots are not always in the same order in memory as in the Inode Table. */
+int32 EEFS_LibNextSlot(EEFS_InodeTable_t *InodeTable, void *Address)
+{
+    uint32      i;
+    int32       InodeIndex;
+
+    InodeIndex = EEFS_FILE_NOT_FOUND;
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if ((InodeTable->File[i].FileHeaderPointer > Address) &&
+            ((InodeIndex == EEFS_FILE_NOT_FOUND) ||
+             (InodeTable->File[i].FileHeaderPointer < InodeTable->File[InodeIndex].FileHeaderPointer))) {
+            InodeIndex = i;
+        }
+    }
+    return(InodeIndex);
+
+} /* End of EEFS_LibNextSlot() */
+
+/* Returns the Inode of the slot that starts at Address, or EEFS_FILE_NOT_FOUND if no slot starts at Address */
+int32 EEFS_LibFindSlot(EEFS_InodeTable_t *InodeTable, void *Address)
+{
+    uint32      i;
+
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if (InodeTable->File[i].FileHeaderPointer == Address) {
+            return(i);
+        }
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindSlot() */
+
+/* Moves the start of free memory to the end of the last slot.  This recovers the space of a deleted slot that was shrunk by a
+ * compaction step, or accounts for a deleted slot that was extended into free memory by a file creat, when a reset occurred
+ * before free memory was updated.  Returns the number of bytes written to EEPROM.  The caller must hold the volume write
+ * lock or be mounting the volume. */
+int32 EEFS_LibTrimFreeMemory(EEFS_InodeTable_t *InodeTable)
+{
+    void       *EndOfSlots;
+    void       *SlotEnd;
+    uint32      i;
+    int32       BytesWritten;
+
+    EndOfSlots = (void *)(InodeTable->BaseAddress + sizeof(EEFS_FileAllocationTable_t));
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        SlotEnd = InodeTable->File[i].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize;
+        if (SlotEnd > EndOfSlots) {
+            EndOfSlots = SlotEnd;
+        }
+    }
+
+    if (EndOfSlots < InodeTable->FreeMemoryPointer) {
+        InodeTable->FreeMemorySize += (uint32)(InodeTable->FreeMemoryPointer - EndOfSlots);
+        InodeTable->FreeMemoryPointer = EndOfSlots;
+        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+        BytesWritten = sizeof(EEFS_FileAllocationTableHeader_t);
+    }
+    else if ((EndOfSlots > InodeTable->FreeMemoryPointer) &&
+             (EndOfSlots <= (InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize))) {
+        InodeTable->FreeMemorySize -= (uint32)(EndOfSlots - InodeTable->FreeMemoryPointer);
+        InodeTable->FreeMemoryPointer = EndOfSlots;
+        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+        BytesWritten = sizeof(EEFS_FileAllocationTableHeader_t);
+    }
+    else {
+        BytesWritten = 0;
+    }
+    return(BytesWritten);
+
+} /* End of EEFS_LibTrimFreeMemory() */
+
+/* Takes the compaction step for the deleted slot with the lowest address that can be compacted.  A deleted slot that is
+ * followed by a file that is in use swaps places with the file, a deleted slot that is followed by another deleted slot is
+ * merged with it, and a deleted slot at the end of the file system is returned to free memory.  Slots that have already been
+ * reduced to a File Header are not moved since that would rewrite every file that follows them to save a few bytes.  No step
+ * is taken if it would write more than MaxBytesToWrite bytes.  Returns the number of bytes written to EEPROM, or 0 if no step
+ * was taken.  The caller must hold the volume write lock. */
+int32 EEFS_LibCompactStep(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToWrite)
+{
+    EEFS_CompactJournal_t           Journal;
+    void                           *SlotEnd;
+    int32                           InodeIndex;
+    int32                           NextInodeIndex;
+    uint32                          BytesToWrite;
+    uint8                           LimitReached;
+    int32                           BytesWritten;
+
+    BytesWritten = 0;
+    LimitReached = FALSE;
+
+    InodeIndex = EEFS_LibNextSlot(InodeTable, (void *)InodeTable->BaseAddress);
+    while ((InodeIndex != EEFS_FILE_NOT_FOUND) && (BytesWritten == 0) && (LimitReached == FALSE)) {
+
+        if (InodeTable->File[InodeIndex].InUse == FALSE) {
+
+            SlotEnd = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[InodeIndex].MaxFileSize;
+            NextInodeIndex = EEFS_LibFindSlot(InodeTable, SlotEnd);
+            memset(&Journal, 0, sizeof(EEFS_CompactJournal_t));
+
+            if (NextInodeIndex == EEFS_FILE_NOT_FOUND) {
+
+                if (SlotEnd == InodeTable->FreeMemoryPointer) {
+
+                    if ((uint32)InodeIndex == (InodeTable->NumberOfFiles - 1)) {
+
+                        /* Remove the last entry from the File Allocation Table */
+                        InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+                        InodeTable->FreeMemorySize += (sizeof(EEFS_FileHeader_t) + InodeTable->File[InodeIndex].MaxFileSize);
+                        InodeTable->NumberOfFiles--;
+                        EEFS_LibAccountSlot(InodeTable, InodeIndex);
+                        memset(&InodeTable->File[InodeIndex], 0, sizeof(EEFS_InodeTableEntry_t));
+                        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+                        BytesWritten = sizeof(EEFS_FileAllocationTableHeader_t);
+                    }
+                    else if (InodeTable->File[InodeIndex].MaxFileSize > 0) {
+
+                        /* Shrink the slot to just its File Header.  The slot is written first so an interrupted step
+                         * only leaves space that EEFS_LibTrimFreeMemory() recovers. */
+                        InodeTable->FreeMemorySize += InodeTable->File[InodeIndex].MaxFileSize;
+                        InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
+                        InodeTable->File[InodeIndex].MaxFileSize = 0;
+                        EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+                        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+                        BytesWritten = sizeof(EEFS_FileAllocationTableEntry_t) + sizeof(EEFS_FileAllocationTableHeader_t);
+                    }
+                }
+            }
+            else if ((InodeTable->File[InodeIndex].MaxFileSize > 0) &&
+                     (InodeTable->FreeMemorySize >= sizeof(EEFS_CompactJournal_t))) {
+
+                if (InodeTable->File[NextInodeIndex].InUse == FALSE) {
+
+                    /* Merge the two deleted slots.  The next slot is reduced to a File Header at the start of this slot
+                     * and this slot gets all of the space. */
+                    Journal.InodeIndex[0] = NextInodeIndex;
+                    Journal.File[0].FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+                    Journal.File[0].MaxFileSize = 0;
+                    Journal.InodeIndex[1] = InodeIndex;
+                    Journal.File[1].FileHeaderOffset = Journal.File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t);
+                    Journal.File[1].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize + InodeTable->File[NextInodeIndex].MaxFileSize;
+                    BytesWritten = EEFS_LibCommitCompactJournal(InodeTable, &Journal);
+                }
+                else if (EEFS_LibFmode(InodeTable, EEFS_LibFileOwner(InodeTable, NextInodeIndex)) == 0) {
+
+                    /* Move the next file down to the start of this slot, this slot then follows the file */
+                    Journal.InodeIndex[0] = NextInodeIndex;
+                    Journal.File[0].FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+                    Journal.File[0].MaxFileSize = InodeTable->File[NextInodeIndex].MaxFileSize;
+                    Journal.InodeIndex[1] = InodeIndex;
+                    Journal.File[1].FileHeaderOffset = Journal.File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t) + Journal.File[0].MaxFileSize;
+                    Journal.File[1].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                    Journal.SourceOffset = (uint32)(SlotEnd - InodeTable->BaseAddress);
+                    EEFS_LibReadFileHeader(InodeTable, NextInodeIndex, &Journal.FileHeader);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+                    /* All of an extent is copied since its slot may have grown after its File Header was written */
+                    if (Journal.FileHeader.InUse == EEFS_EXTENT_IN_USE) {
+                        Journal.FileHeader.FileSize = Journal.File[0].MaxFileSize;
+                    }
+#endif
+
+                    BytesToWrite = sizeof(EEFS_CompactJournal_t) + (2 * sizeof(EEFS_FileHeader_t)) +
+                                   EEFS_MIN(Journal.FileHeader.FileSize, Journal.File[0].MaxFileSize) +
+                                   (2 * sizeof(EEFS_FileAllocationTableEntry_t));
+                    if (BytesToWrite <= MaxBytesToWrite) {
+                        BytesWritten = EEFS_LibCommitCompactJournal(InodeTable, &Journal);
+                    }
+                    else { /* the move would exceed the limit for this call */
+                        LimitReached = TRUE;
+                    }
+                }
+            }
+        }
+        InodeIndex = EEFS_LibNextSlot(InodeTable, InodeTable->File[InodeIndex].FileHeaderPointer);
+    }
+
+    return(BytesWritten);
+
+} /* End of EEFS_LibCompactStep() */
+
+/* Writes a compaction journal to the start of free memory, applies it and updates the Inode Table.  Returns the number of
+ * bytes written to EEPROM.  The caller must hold the volume write lock. */
+int32 EEFS_LibCommitCompactJournal(EEFS_InodeTable_t *InodeTable, EEFS_CompactJournal_t *Journal)
+{
+    EEFS_CompactJournal_t          *JournalPointer;
+    uint32                          i;
+
+    /* The magic number is written last so a partly written journal is never applied */
+    JournalPointer = InodeTable->FreeMemoryPointer;
+    Journal->Magic = 0;
+    EEFS_LIB_EEPROM_WRITE(JournalPointer, Journal, sizeof(EEFS_CompactJournal_t));
+    EEFS_LIB_EEPROM_FLUSH;
+    Journal->Magic = EEFS_COMPACT_MAGIC;
+    EEFS_LIB_EEPROM_WRITE(&JournalPointer->Magic, &Journal->Magic, sizeof(uint32));
+    EEFS_LIB_EEPROM_FLUSH;
+
+    EEFS_LibApplyCompactJournal(InodeTable->BaseAddress, JournalPointer, Journal);
+
+    for (i=0; i < 2; i++) {
+        InodeTable->File[Journal->InodeIndex[i]].FileHeaderPointer = (void *)(InodeTable->BaseAddress + Journal->File[i].FileHeaderOffset);
+        InodeTable->File[Journal->InodeIndex[i]].MaxFileSize = Journal->File[i].MaxFileSize;
+        EEFS_LibAccountSlot(InodeTable, Journal->InodeIndex[i]);
+    }
+
+    return(sizeof(EEFS_CompactJournal_t) + (2 * sizeof(EEFS_FileHeader_t)) + Journal->BytesCopied +
+           (2 * sizeof(EEFS_FileAllocationTableEntry_t)));
+
+} /* End of EEFS_LibCommitCompactJournal() */
+
+/* Applies a compaction journal to EEPROM.  This only uses the journal and EEPROM, so it is used both by compaction and to
+ * complete a step that was interrupted by a reset, and every write can safely be repeated. */
+void EEFS_LibApplyCompactJournal(uint32 BaseAddress, EEFS_CompactJournal_t *JournalPointer, EEFS_CompactJournal_t *Journal)
+{
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileHeader_t                   DeletedFileHeader;
+    uint8                               Buffer[EEFS_COMPACT_PAGE_SIZE];
+    void                               *Source;
+    void                               *Destination;
+    uint32                              DataSize;
+    uint32                              Distance;
+    uint32                              BytesSaved;
+    uint32                              Length;
+    uint32                              i;
+
+    FileAllocationTable = (void *)BaseAddress;
+    memset(&DeletedFileHeader, 0, sizeof(EEFS_FileHeader_t));
+
+    if (Journal->SourceOffset != 0) {
+
+        /* Only the part of a file that is in the slot is copied, the rest of a file that has extents is in the extents */
+        DataSize = EEFS_MIN(Journal->FileHeader.FileSize, Journal->File[0].MaxFileSize);
+
+        /* Copy the file data starting from the lowest address.  The file moves down by Distance bytes, so copying at most
+         * Distance bytes at a time only overwrites source data that has already been copied.  BytesCopied is saved before
+         * any source data above the saved value can be overwritten, so an interrupted copy can be restarted from there. */
+        Source = (void *)(BaseAddress + Journal->SourceOffset + sizeof(EEFS_FileHeader_t));
+        Destination = (void *)(BaseAddress + Journal->File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t));
+        Distance = Journal->SourceOffset - Journal->File[0].FileHeaderOffset;
+        BytesSaved = Journal->BytesCopied;
+        while (Journal->BytesCopied < DataSize) {
+
+            /* Each chunk ends on a page boundary of the destination so each eeprom page is only written once */
+            Length = EEFS_COMPACT_PAGE_SIZE - (((uint32)Destination + Journal->BytesCopied) % EEFS_COMPACT_PAGE_SIZE);
+            Length = EEFS_MIN(Length, Distance);
+            Length = EEFS_MIN(Length, (DataSize - Journal->BytesCopied));
+            if ((Journal->BytesCopied + Length) > (BytesSaved + Distance)) {
+                EEFS_LIB_EEPROM_WRITE(&JournalPointer->BytesCopied, &Journal->BytesCopied, sizeof(uint32));
+                EEFS_LIB_EEPROM_FLUSH;
+                BytesSaved = Journal->BytesCopied;
+            }
+            EEFS_LIB_EEPROM_READ(Buffer, (Source + Journal->BytesCopied), Length);
+            EEFS_LIB_EEPROM_WRITE((Destination + Journal->BytesCopied), Buffer, Length);
+            Journal->BytesCopied += Length;
+        }
+
+        /* The File Header of the deleted slot is written over the old file data, so the copy must be recorded as complete */
+        EEFS_LIB_EEPROM_FLUSH;
+        EEFS_LIB_EEPROM_WRITE(&JournalPointer->BytesCopied, &Journal->BytesCopied, sizeof(uint32));
+        EEFS_LIB_EEPROM_FLUSH;
+        EEFS_LIB_EEPROM_WRITE((void *)(BaseAddress + Journal->File[0].FileHeaderOffset), &Journal->FileHeader, sizeof(EEFS_FileHeader_t));
+    }
+    else { /* two deleted slots are merged */
+        EEFS_LIB_EEPROM_WRITE((void *)(BaseAddress + Journal->File[0].FileHeaderOffset), &DeletedFileHeader, sizeof(EEFS_FileHeader_t));
+    }
+    EEFS_LIB_EEPROM_WRITE((void *)(BaseAddress + Journal->File[1].FileHeaderOffset), &DeletedFileHeader, sizeof(EEFS_FileHeader_t));
+    EEFS_LIB_EEPROM_FLUSH;
+
+    for (i=0; i < 2; i++) {
+        EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->File[Journal->InodeIndex[i]], &Journal->File[i], sizeof(EEFS_FileAllocationTableEntry_t));
+    }
+    EEFS_LIB_EEPROM_FLUSH;
+
+    /* The step is complete */
+    Journal->Magic = 0;
+    EEFS_LIB_EEPROM_WRITE(&JournalPointer->Magic, &Journal->Magic, sizeof(uint32));
+    EEFS_LIB_EEPROM_FLUSH;
+
+} /* End of EEFS_LibApplyCompactJournal() */
+
+/* Looks for a compaction journal at the start of free memory and completes the compaction step if one was interrupted by a
+ * reset.  This is called before the File Allocation Table is loaded into the Inode Table. */
+void EEFS_LibRecoverCompactJournal(uint32 BaseAddress, EEFS_FileAllocationTableHeader_t *FileAllocationTableHeader)
+{
+    EEFS_CompactJournal_t          *JournalPointer;
+    EEFS_CompactJournal_t           Journal;
+
+    if ((EEFS_LIB_IS_WRITE_PROTECTED == FALSE) &&
+        (FileAllocationTableHeader->FreeMemorySize >= sizeof(EEFS_CompactJournal_t))) {
+
+        JournalPointer = (void *)(BaseAddress + FileAllocationTableHeader->FreeMemoryOffset);
+        EEFS_LIB_EEPROM_READ(&Journal, JournalPointer, sizeof(EEFS_CompactJournal_t));
+
+        /* Free memory is not initialized, so the journal is only used if it describes two adjacent slots in the file system */
+        if ((Journal.Magic == EEFS_COMPACT_MAGIC) &&
+            (Journal.InodeIndex[0] < FileAllocationTableHeader->NumberOfFiles) &&
+            (Journal.InodeIndex[1] < FileAllocationTableHeader->NumberOfFiles) &&
+            (Journal.InodeIndex[0] != Journal.InodeIndex[1]) &&
+            (Journal.File[0].FileHeaderOffset >= sizeof(EEFS_FileAllocationTable_t)) &&
+            (Journal.File[1].FileHeaderOffset == (Journal.File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t) + Journal.File[0].MaxFileSize)) &&
+            ((Journal.File[1].FileHeaderOffset + sizeof(EEFS_FileHeader_t) + Journal.File[1].MaxFileSize) <= FileAllocationTableHeader->FreeMemoryOffset) &&
+            ((Journal.SourceOffset == 0) ||
+             ((Journal.SourceOffset > Journal.File[0].FileHeaderOffset) &&
+              ((Journal.SourceOffset + sizeof(EEFS_FileHeader_t) + Journal.File[0].MaxFileSize) <= FileAllocationTableHeader->FreeMemoryOffset)))) {
+
+            EEFS_LibApplyCompactJournal(BaseAddress, JournalPointer, &Journal);
+        }
+    }
+
+} /* End of EEFS_LibRecoverCompactJournal() */
+
+/* Updates the ram copy of a File Header in the Inode Table.  Note that this does not update the filename hash index. */
+void EEFS_LibCacheFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader)
+{
+    InodeTable->File[InodeIndex].InUse = FileHeader->InUse;
+    memcpy(InodeTable->File[InodeIndex].Filename, FileHeader->Filename, EEFS_MAX_FILENAME_SIZE);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    /* A deleted slot keeps the rest of its File Header in EEPROM, including the link to its next extent, which is ignored */
+    if (FileHeader->InUse == FALSE) {
+        InodeTable->File[InodeIndex].NextExtent = EEFS_END_OF_EXTENT_CHAIN;
+    }
+    else {
+        InodeTable->File[InodeIndex].NextExtent = (int32)FileHeader->NextExtent - 1;
+    }
+#endif
+    InodeTable->File[InodeIndex].FileSize = FileHeader->FileSize;
+#if (EEFS_HEADER_CACHE == TRUE)
+    InodeTable->File[InodeIndex].Crc = FileHeader->Crc;
+    InodeTable->File[InodeIndex].Attributes = FileHeader->Attributes;
+    InodeTable->File[InodeIndex].ModificationDate = FileHeader->ModificationDate;
+    InodeTable->File[InodeIndex].CreationDate = FileHeader->CreationDate;
+#endif
+
+} /* End of EEFS_LibCacheFileHeader() */
+
+/* Replaces what an Inode Table entry last added to the space totals of the volume with what it adds now, see Space Accounting.
+ * Entries past NumberOfFiles add nothing.  The totals are only ever changed by the difference, so the slack of a file may be
+ * counted before its extents are, and calling this more than once for the same change has no effect.  The caller must hold
+ * the volume write lock or be mounting the volume. */
+void EEFS_LibAccountSlot(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    EEFS_InodeTableEntry_t     *Entry;
+    EEFS_SpaceInfo_t           *SpaceInfo;
+
+    Entry = &InodeTable->File[InodeIndex];
+    SpaceInfo = &InodeTable->SpaceInfo;
+
+    if (Entry->CountedSlotSize > 0) {
+        if (Entry->CountedInUse == TRUE) {
+            SpaceInfo->FilesInUse--;
+            SpaceInfo->AllocatedSpace -= Entry->CountedSlotSize;
+            SpaceInfo->UsedSpace -= Entry->CountedFileSize;
+            SpaceInfo->SlackSpace -= ((Entry->CountedSlotSize - sizeof(EEFS_FileHeader_t)) - Entry->CountedFileSize);
+        }
+        else if (Entry->CountedInUse == EEFS_EXTENT_IN_USE) {
+            SpaceInfo->AllocatedSpace -= Entry->CountedSlotSize;
+            SpaceInfo->SlackSpace -= (Entry->CountedSlotSize - sizeof(EEFS_FileHeader_t));
+        }
+        else { /* deleted slot */
+            SpaceInfo->DeletedSpace -= Entry->CountedSlotSize;
+        }
+        Entry->CountedSlotSize = 0;
+    }
+
+    if (InodeIndex < InodeTable->NumberOfFiles) {
+
+        /* The FileSize of a file covers the data in its extents too, so extents only add their slot to the slack */
+        Entry->CountedInUse = Entry->InUse;
+        Entry->CountedSlotSize = sizeof(EEFS_FileHeader_t) + Entry->MaxFileSize;
+        Entry->CountedFileSize = (Entry->InUse == TRUE) ? Entry->FileSize : 0;
+        if (Entry->CountedInUse == TRUE) {
+            SpaceInfo->FilesInUse++;
+            SpaceInfo->AllocatedSpace += Entry->CountedSlotSize;
+            SpaceInfo->UsedSpace += Entry->CountedFileSize;
+            SpaceInfo->SlackSpace += (Entry->MaxFileSize - Entry->CountedFileSize);
+        }
+        else if (Entry->CountedInUse == EEFS_EXTENT_IN_USE) {
+            SpaceInfo->AllocatedSpace += Entry->CountedSlotSize;
+            SpaceInfo->SlackSpace += Entry->MaxFileSize;
+        }
+        else { /* deleted slot */
+            SpaceInfo->DeletedSpace += Entry->CountedSlotSize;
+        }
+    }
+
+} /* End of EEFS_LibAccountSlot() */
+
+/* Returns the filename hash index bucket for the specified Filename.  The hash covers the same characters that are
+ * compared by EEFS_LibFindFile, so matching filenames always hash to the same bucket. */
+uint32 EEFS_LibHashFilename(char *Filename)
+{
+    uint32      i;
+    uint32      Hash = 5381;
+
+    for (i=0; (i < EEFS_MAX_FILENAME_SIZE) && (Filename[i] != '\0'); i++) {
+        Hash = ((Hash << 5) + Hash) + (uint8)Filename[i];
+    }
+    return(Hash % EEFS_FILENAME_HASH_SIZE);
+
+} /* End of EEFS_LibHashFilename() */
+
+/* Adds an inode to the head of its filename hash index bucket. */
+void EEFS_LibAddToFilenameIndex(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    uint32      Bucket;
+
+    Bucket = EEFS_LibHashFilename(InodeTable->File[InodeIndex].Filename);
+    InodeTable->File[InodeIndex].NextHashEntry = InodeTable->FilenameHashTable[Bucket];
+    InodeTable->FilenameHashTable[Bucket] = InodeIndex;
+
+} /* End of EEFS_LibAddToFilenameIndex() */
+
+/* Unlinks an inode from its filename hash index bucket. */
+void EEFS_LibRemoveFromFilenameIndex(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    int32      *HashEntry;
+
+    HashEntry = &InodeTable->FilenameHashTable[EEFS_LibHashFilename(InodeTable->File[InodeIndex].Filename)];
+    while (*HashEntry != EEFS_END_OF_HASH_CHAIN) {
+        if (*HashEntry == (int32)InodeIndex) {
+            *HashEntry = InodeTable->File[InodeIndex].NextHashEntry;
+            return;
+        }
+        HashEntry = &InodeTable->File[*HashEntry].NextHashEntry;
+    }
+
+} /* End of EEFS_LibRemoveFromFilenameIndex() */
+
+/* Builds the free slot list from the InUse flags of the Inode Table. */
+void EEFS_LibBuildFreeSlotList(EEFS_InodeTable_t *InodeTable)
+{
+    uint32      i;
+
+    InodeTable->FreeSlotList = EEFS_END_OF_FREE_SLOT_LIST;
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if (InodeTable->File[i].InUse == FALSE) {
+            EEFS_LibAddToFreeSlotList(InodeTable, i);
+        }
+    }
+
+} /* End of EEFS_LibBuildFreeSlotList() */
+
+/* Inserts a deleted slot into the free slot list after any slots that are the same size or smaller. */
+void EEFS_LibAddToFreeSlotList(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    int32      *FreeSlot;
+
+    FreeSlot = &InodeTable->FreeSlotList;
+    while ((*FreeSlot != EEFS_END_OF_FREE_SLOT_LIST) &&
+           (InodeTable->File[*FreeSlot].MaxFileSize <= InodeTable->File[InodeIndex].MaxFileSize)) {
+        FreeSlot = &InodeTable->File[*FreeSlot].NextFreeSlot;
+    }
+    InodeTable->File[InodeIndex].NextFreeSlot = *FreeSlot;
+    *FreeSlot = InodeIndex;
+
+} /* End of EEFS_LibAddToFreeSlotList() */
+
+/* Unlinks a slot from the free slot list, if it is in the list. */
+void EEFS_LibRemoveFromFreeSlotList(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    int32      *FreeSlot;
+
+    FreeSlot = &InodeTable->FreeSlotList;
+    while (*FreeSlot != EEFS_END_OF_FREE_SLOT_LIST) {
+        if (*FreeSlot == (int32)InodeIndex) {
+            *FreeSlot = InodeTable->File[InodeIndex].NextFreeSlot;
+            return;
+        }
+        FreeSlot = &InodeTable->File[*FreeSlot].NextFreeSlot;
+    }
+
+} /* End of EEFS_LibRemoveFromFreeSlotList() */
+
+/* Returns the Inode of the smallest deleted slot that can hold ReservedBytes bytes, or EEFS_FILE_NOT_FOUND if there is no
+ * deleted slot that is large enough. */
+int32 EEFS_LibFindFreeSlot(EEFS_InodeTable_t *InodeTable, uint32 ReservedBytes)
+{
+    int32       InodeIndex;
+
+    InodeIndex = InodeTable->FreeSlotList;
+    while (InodeIndex != EEFS_END_OF_FREE_SLOT_LIST) {
+        if (InodeTable->File[InodeIndex].MaxFileSize >= ReservedBytes) {
+            return(InodeIndex);
+        }
+        InodeIndex = InodeTable->File[InodeIndex].NextFreeSlot;
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindFreeSlot() */
+
+/* Returns the Inode of the deleted slot that ends at the start of free memory, or EEFS_FILE_NOT_FOUND if the last slot is in
+ * use. */
+int32 EEFS_LibFindLastFreeSlot(EEFS_InodeTable_t *InodeTable)
+{
+    int32       InodeIndex;
+
+    InodeIndex = InodeTable->FreeSlotList;
+    while (InodeIndex != EEFS_END_OF_FREE_SLOT_LIST) {
+        if ((InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) +
+             InodeTable->File[InodeIndex].MaxFileSize) == InodeTable->FreeMemoryPointer) {
+            return(InodeIndex);
+        }
+        InodeIndex = InodeTable->File[InodeIndex].NextFreeSlot;
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindLastFreeSlot() */
+
+/* Returns the Inode of a deleted slot that has been reduced to a File Header and follows another slot that can be extended over
+ * it, or EEFS_FILE_NOT_FOUND if there are none.  The slots that are reduced to a File Header are at the start of the free slot list. */
+int32 EEFS_LibFindEmptySlot(EEFS_InodeTable_t *InodeTable)
+{
+    int32       InodeIndex;
+    int32       PrevInodeIndex;
+
+    InodeIndex = InodeTable->FreeSlotList;
+    while ((InodeIndex != EEFS_END_OF_FREE_SLOT_LIST) && (InodeTable->File[InodeIndex].MaxFileSize == 0)) {
+        PrevInodeIndex = EEFS_LibFindSlotEnd(InodeTable, InodeTable->File[InodeIndex].FileHeaderPointer);
+        if ((PrevInodeIndex != EEFS_FILE_NOT_FOUND) && (EEFS_LibHasNextExtent(InodeTable, PrevInodeIndex) == FALSE)) {
+            return(InodeIndex);
+        }
+        InodeIndex = InodeTable->File[InodeIndex].NextFreeSlot;
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindEmptySlot() */
+
+/* Returns the Inode of the slot that ends at Address, or EEFS_FILE_NOT_FOUND if no slot ends at Address */
+int32 EEFS_LibFindSlotEnd(EEFS_InodeTable_t *InodeTable, void *Address)
+{
+    uint32      i;
+
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if ((InodeTable->File[i].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize) == Address) {
+            return(i);
+        }
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindSlotEnd() */
+
+/* Moves a deleted slot that has been reduced to a File Header to FileHeaderPointer and writes FileHeader to it.  The slot that
+ * ends where the moved slot started is extended over its old File Header.  The moved slot is written first so a reset only
+ * leaves a gap between the two slots that EEFS_LibFillSlotGaps() recovers.  The caller must hold the volume write lock. */
+void EEFS_LibMoveEmptySlot(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, void *FileHeaderPointer, EEFS_FileHeader_t *FileHeader)
+{
+    void       *OldFileHeaderPointer;
+    int32       PrevInodeIndex;
+
+    OldFileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+    InodeTable->File[InodeIndex].FileHeaderPointer = FileHeaderPointer;
+    EEFS_LibWriteFileHeader(InodeTable, InodeIndex, FileHeader);
+    EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+
+    /* This is the moved slot itself if it was moved to the slot in front of its old File Header */
+    PrevInodeIndex = EEFS_LibFindSlotEnd(InodeTable, OldFileHeaderPointer);
+    if (PrevInodeIndex != EEFS_FILE_NOT_FOUND) {
+        if (InodeTable->File[PrevInodeIndex].InUse == FALSE) {
+            EEFS_LibRemoveFromFreeSlotList(InodeTable, PrevInodeIndex);
+            InodeTable->File[PrevInodeIndex].MaxFileSize += sizeof(EEFS_FileHeader_t);
+            EEFS_LibAddToFreeSlotList(InodeTable, PrevInodeIndex);
+        }
+        else {
+            InodeTable->File[PrevInodeIndex].MaxFileSize += sizeof(EEFS_FileHeader_t);
+        }
+        EEFS_LibWriteFileAllocationTableEntry(InodeTable, PrevInodeIndex);
+    }
+
+} /* End of EEFS_LibMoveEmptySlot() */
+
+/* Extends each slot that is followed by unused memory up to the start of the next slot.  This recovers the File Header of a
+ * slot that was moved by a file creat that was interrupted by a reset before the previous slot was extended.  Returns the
+ * number of bytes written to EEPROM.  The caller must hold the volume write lock or be mounting the volume. */
+int32 EEFS_LibFillSlotGaps(EEFS_InodeTable_t *InodeTable)
+{
+    void       *SlotEnd;
+    uint32      i;
+    int32       NextInodeIndex;
+    int32       BytesWritten;
+
+    BytesWritten = 0;
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        SlotEnd = InodeTable->File[i].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize;
+        NextInodeIndex = EEFS_LibNextSlot(InodeTable, InodeTable->File[i].FileHeaderPointer);
+        if ((NextInodeIndex != EEFS_FILE_NOT_FOUND) &&
+            (InodeTable->File[NextInodeIndex].FileHeaderPointer > SlotEnd) &&
+            (EEFS_LibHasNextExtent(InodeTable, i) == FALSE)) {
+            InodeTable->File[i].MaxFileSize += (uint32)(InodeTable->File[NextInodeIndex].FileHeaderPointer - SlotEnd);
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, i);
+            BytesWritten += sizeof(EEFS_FileAllocationTableEntry_t);
+        }
+    }
+    return(BytesWritten);
+
+} /* End of EEFS_LibFillSlotGaps() */
+
+/* Grows the slot of a file to NewMaxFileSize bytes, a slot that is already large enough is not changed.  A slot that ends at
+ * free memory is extended in place.  Otherwise the File Header and the first BytesToCopy bytes of the file are copied to
+ * free memory one EEFS_COMPACT_PAGE_SIZE page at a time, and writing the File Allocation Table entry of the file commits the
+ * move.  The old slot is then given a File Allocation Table entry as a deleted slot, either the entry of a deleted slot that
+ * has been reduced to a File Header or a new entry.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED or
+ * EEFS_NO_SPACE_LEFT_ON_DEVICE on error.  The caller must hold the volume write lock and make sure that no other File
+ * Descriptor has the file open. */
+int32 EEFS_LibRelocateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 NewMaxFileSize, uint32 BytesToCopy)
+{
+    EEFS_FileHeader_t                   FileHeader;
+    uint8                               Buffer[EEFS_COMPACT_PAGE_SIZE];
+    void                               *EndOfFreeMemory;
+    void                               *OldFileHeaderPointer;
+    uint32                              OldMaxFileSize;
+    void                               *Source;
+    void                               *Destination;
+    uint32                              BytesCopied;
+    uint32                              Length;
+    int32                               DeletedInodeIndex;
+    int32                               ReturnCode;
+
+    EndOfFreeMemory = InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize;
+    OldFileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+    OldMaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+
+    if (NewMaxFileSize <= OldMaxFileSize) {
+        ReturnCode = EEFS_SUCCESS;
+    }
+
+    /* A file that is being created owns all of free memory */
+    else if (EEFS_LibHasOpenCreat(InodeTable) == TRUE) {
+        ReturnCode = EEFS_PERMISSION_DENIED;
+    }
+
+    /* A slot that ends at free memory is extended in place.  The File Allocation Table entry is written first so a reset
+     * only leaves a slot that extends into free memory, which EEFS_LibTrimFreeMemory() accounts for. */
+    else if ((OldFileHeaderPointer + sizeof(EEFS_FileHeader_t) + OldMaxFileSize) == InodeTable->FreeMemoryPointer) {
+
+        if ((NewMaxFileSize - OldMaxFileSize) <= InodeTable->FreeMemorySize) {
+            InodeTable->File[InodeIndex].MaxFileSize = NewMaxFileSize;
+            InodeTable->FreeMemoryPointer = OldFileHeaderPointer + sizeof(EEFS_FileHeader_t) + NewMaxFileSize;
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* not enough free space in eeprom */
+            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+        }
+    }
+
+    /* Otherwise the file is copied to free memory, which needs a File Allocation Table entry for the old slot */
+    else if ((NewMaxFileSize <= InodeTable->FreeMemorySize) &&
+             ((InodeTable->FreeMemorySize - NewMaxFileSize) >= sizeof(EEFS_FileHeader_t))) {
+
+        if ((DeletedInodeIndex = EEFS_LibFindEmptySlot(InodeTable)) == EEFS_FILE_NOT_FOUND) {
+            DeletedInodeIndex = InodeTable->NumberOfFiles;
+        }
+
+        if (DeletedInodeIndex < EEFS_MAX_FILES) {
+
+            /* Nothing refers to free memory so a reset during the copy leaves the file system unchanged */
+            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+            BytesToCopy = EEFS_MIN(EEFS_MAX(BytesToCopy, FileHeader.FileSize), OldMaxFileSize);
+            Source = OldFileHeaderPointer + sizeof(EEFS_FileHeader_t);
+            Destination = InodeTable->FreeMemoryPointer + sizeof(EEFS_FileHeader_t);
+            EEFS_LIB_EEPROM_WRITE(InodeTable->FreeMemoryPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
+            BytesCopied = 0;
+            while (BytesCopied < BytesToCopy) {
+
+                /* Each chunk ends on a page boundary of the destination so each eeprom page is only written once */
+                Length = EEFS_COMPACT_PAGE_SIZE - (((uint32)Destination + BytesCopied) % EEFS_COMPACT_PAGE_SIZE);
+                Length = EEFS_MIN(Length, (BytesToCopy - BytesCopied));
+                EEFS_LIB_EEPROM_READ(Buffer, (Source + BytesCopied), Length);
+                EEFS_LIB_EEPROM_WRITE((Destination + BytesCopied), Buffer, Length);
+                BytesCopied += Length;
+            }
+            EEFS_LIB_EEPROM_FLUSH;
+
+            /* Point the file at the copy.  Free memory now starts after the new slot, until the File Allocation Table Header
+             * is written a reset leaves the new slot in free memory, which EEFS_LibTrimFreeMemory() accounts for. */
+            InodeTable->File[InodeIndex].FileHeaderPointer = InodeTable->FreeMemoryPointer;
+            InodeTable->File[InodeIndex].MaxFileSize = NewMaxFileSize;
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+            InodeTable->FreeMemoryPointer += (sizeof(EEFS_FileHeader_t) + NewMaxFileSize);
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+
+            /* Nothing refers to the old slot now, so a reset only leaves a gap that EEFS_LibFillSlotGaps() recovers until the
+             * old slot is given its File Allocation Table entry as a deleted slot */
+            memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
+            if ((uint32)DeletedInodeIndex == InodeTable->NumberOfFiles) {
+                InodeTable->NumberOfFiles++;
+                InodeTable->File[DeletedInodeIndex].FileHeaderPointer = OldFileHeaderPointer;
+                InodeTable->File[DeletedInodeIndex].MaxFileSize = OldMaxFileSize;
+                EEFS_LibWriteFileHeader(InodeTable, DeletedInodeIndex, &FileHeader);
+                EEFS_LibWriteFileAllocationTableEntry(InodeTable, DeletedInodeIndex);
+            }
+            else {
+                InodeTable->File[DeletedInodeIndex].MaxFileSize = OldMaxFileSize;
+                EEFS_LibMoveEmptySlot(InodeTable, DeletedInodeIndex, OldFileHeaderPointer, &FileHeader);
+            }
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
             ReturnCode = EEFS_SUCCESS;
         }
-        else { /* invalid stat buffer */
-            ReturnCode = EEFS_INVALID_ARGUMENT;
+        else { /* no available slots in the File Allocation Table */
+            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
         }
     }
-    else { /* invalid file descriptor */
-        ReturnCode = EEFS_INVALID_ARGUMENT;
+    else { /* not enough free space in eeprom */
+        ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
     }
 
-    EEFS_LIB_UNLOCK;
     return(ReturnCode);
-    
-} /* End of EEFS_LibFstat() */
 
-/* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
- * attribute.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error.  To read file
- * attributes use the stat function. */
-int32 EEFS_LibSetFileAttributes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
+} /* End of EEFS_LibRelocateFile() */
+
+/* Sets the FileSize of a file to Length bytes, which must not be more than its current FileSize.  When ReleaseSpace is TRUE
+ * the extents of the file that are past Length are deleted, and the last slot of the file is shrunk to Length plus the spare
+ * bytes given by the spare byte policy of the volume if it ends at free memory.  The File Header of the file is written
+ * first, and the chain is cut before its extents are deleted, so a reset only leaves extents that are not linked to a file,
+ * which EEFS_LibInitFS() deletes, or space at the end of the last slot, which EEFS_LibTrimFreeMemory() recovers.  The caller
+ * must hold the volume write lock and, when ReleaseSpace is TRUE, make sure that no other File Descriptor has the file open. */
+void EEFS_LibTruncateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Length, uint8 ReleaseSpace)
 {
-    int32                           InodeIndex;
-    EEFS_FileHeader_t               FileHeader;
-    int32                           ReturnCode;
+    EEFS_FileHeader_t                   FileHeader;
+    void                               *EndOfFreeMemory;
+    uint32                              LastInodeIndex;
+    uint32                              SlotOffset;
+    uint32                              MaxFileSize;
+    uint32                              SpareBytes;
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    int32                               NextExtent;
+#endif
+
+    /* Find the last slot of the file that is needed to hold Length bytes */
+    LastInodeIndex = InodeIndex;
+    SlotOffset = 0;
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    while ((Length > (SlotOffset + InodeTable->File[LastInodeIndex].MaxFileSize)) &&
+           (EEFS_LibHasNextExtent(InodeTable, LastInodeIndex) == TRUE)) {
+        SlotOffset += InodeTable->File[LastInodeIndex].MaxFileSize;
+        LastInodeIndex = InodeTable->File[LastInodeIndex].NextExtent;
+    }
+#endif
+
+    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+    FileHeader.FileSize = Length;
+    FileHeader.ModificationDate = EEFS_LIB_TIME;
+    FileHeader.Crc = 0;   /* Automatically updating the CRC is not supported at this time */
+    EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELDS(Crc, ModificationDate));
+    SpareBytes = EEFS_LibSpareBytes(InodeTable, FileHeader.Filename, Length, 0);
+
+    if (ReleaseSpace == TRUE) {
+
+#if (EEFS_EXTENT_CHAINING == TRUE)
+        if ((NextExtent = InodeTable->File[LastInodeIndex].NextExtent) != EEFS_END_OF_EXTENT_CHAIN) {
+
+            EEFS_LibReadFileHeader(InodeTable, LastInodeIndex, &FileHeader);
+            FileHeader.NextExtent = 0;
+            EEFS_LibWriteFileHeaderFields(InodeTable, LastInodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(NextExtent));
+
+            while (NextExtent != EEFS_END_OF_EXTENT_CHAIN) {
+                InodeIndex = NextExtent;
+                NextExtent = InodeTable->File[InodeIndex].NextExtent;
+                InodeTable->File[InodeIndex].Owner = EEFS_END_OF_EXTENT_CHAIN;
+                EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                FileHeader.InUse = FALSE;
+                EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(InUse));
+            }
+        }
+#endif
+
+        SpareBytes = EEFS_MIN(SpareBytes, InodeTable->File[LastInodeIndex].MaxFileSize);
+        MaxFileSize = EEFS_ROUND_UP(((Length - SlotOffset) + SpareBytes), 4);
+
+        /* A file that is being created owns all of free memory */
+        if ((MaxFileSize < InodeTable->File[LastInodeIndex].MaxFileSize) &&
+            ((InodeTable->File[LastInodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) +
+              InodeTable->File[LastInodeIndex].MaxFileSize) == InodeTable->FreeMemoryPointer) &&
+            (EEFS_LibHasOpenCreat(InodeTable) == FALSE)) {
+
+            EndOfFreeMemory = InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize;
+            InodeTable->File[LastInodeIndex].MaxFileSize = MaxFileSize;
+            InodeTable->FreeMemoryPointer = InodeTable->File[LastInodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + MaxFileSize;
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, LastInodeIndex);
+
+            /* The FileSize of an extent is the size of its slot */
+            if (InodeTable->File[LastInodeIndex].InUse == EEFS_EXTENT_IN_USE) {
+                EEFS_LibReadFileHeader(InodeTable, LastInodeIndex, &FileHeader);
+                FileHeader.FileSize = MaxFileSize;
+                EEFS_LibWriteFileHeaderFields(InodeTable, LastInodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(FileSize));
+            }
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+        }
+    }
 
-    EEFS_LIB_LOCK;
-    if (InodeTable != NULL)  {
+} /* End of EEFS_LibTruncateFile() */
 
-        if (Attributes == EEFS_ATTRIBUTE_NONE || Attributes == EEFS_ATTRIBUTE_READONLY) {
+/* Marks a file and all of its extents deleted by clearing only the InUse flag of each File Header.  The file is deleted before
+ * its extents so a reset only leaves extents that are not linked to a file, which EEFS_LibInitFS() deletes.  The caller must
+ * hold the volume write lock. */
+void EEFS_LibDeleteFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    EEFS_FileHeader_t   FileHeader;
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    int32               NextExtent;
+
+    NextExtent = InodeTable->File[InodeIndex].NextExtent;
+#endif
+
+    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+    FileHeader.InUse = FALSE;
+    EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(InUse));
+
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    while (NextExtent != EEFS_END_OF_EXTENT_CHAIN) {
+        InodeIndex = NextExtent;
+        NextExtent = InodeTable->File[InodeIndex].NextExtent;
+        InodeTable->File[InodeIndex].Owner = EEFS_END_OF_EXTENT_CHAIN;
+        EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+        FileHeader.InUse = FALSE;
+        EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(InUse));
+    }
+#endif
 
-            if (EEFS_LibIsValidFilename(Filename)) {
+} /* End of EEFS_LibDeleteFile() */
 
-                /* If the file system is not write protected */
-                if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+/* Points the FileDataPointer of a File Descriptor at its ByteOffset, following the extents of the file if needed.  The caller
+ * must hold the volume lock. */
+void EEFS_LibSeekFileData(EEFS_FileDescriptor_t *FileDescriptorPointer)
+{
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    EEFS_InodeTable_t  *InodeTable;
+
+    InodeTable = FileDescriptorPointer->InodeTable;
+    FileDescriptorPointer->ExtentIndex = FileDescriptorPointer->InodeIndex;
+    FileDescriptorPointer->ExtentOffset = 0;
+    while ((FileDescriptorPointer->ByteOffset > (FileDescriptorPointer->ExtentOffset + InodeTable->File[FileDescriptorPointer->ExtentIndex].MaxFileSize)) &&
+           (EEFS_LibHasNextExtent(InodeTable, FileDescriptorPointer->ExtentIndex) == TRUE)) {
+        FileDescriptorPointer->ExtentOffset += InodeTable->File[FileDescriptorPointer->ExtentIndex].MaxFileSize;
+        FileDescriptorPointer->ExtentIndex = InodeTable->File[FileDescriptorPointer->ExtentIndex].NextExtent;
+    }
+    FileDescriptorPointer->FileDataPointer = InodeTable->File[FileDescriptorPointer->ExtentIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) +
+                                             (FileDescriptorPointer->ByteOffset - FileDescriptorPointer->ExtentOffset);
+#else
+    FileDescriptorPointer->FileDataPointer = FileDescriptorPointer->FileHeaderPointer + sizeof(EEFS_FileHeader_t) + FileDescriptorPointer->ByteOffset;
+#endif
+
+} /* End of EEFS_LibSeekFileData() */
+
+/* Returns the number of bytes that can be transferred at the FileDataPointer of a File Descriptor before the end of the slot
+ * it points into.  A File Descriptor at the end of a slot that is followed by an extent is moved to the start of the extent
+ * first.  The slot sizes and links of a file can be changed by other tasks, EEFS_LibMoveEmptySlot() grows the slot in front
+ * of a slot that it moves, so they are read with the volume read lock held.  Without extent chaining only the MaxFileSize
+ * copied into the File Descriptor is used, which can only be smaller than the slot.  The caller must not hold the volume
+ * lock. */
+uint32 EEFS_LibContiguousBytes(EEFS_FileDescriptor_t *FileDescriptorPointer)
+{
+    uint32              SlotEnd;
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    EEFS_InodeTable_t  *InodeTable;
+
+    InodeTable = FileDescriptorPointer->InodeTable;
+    EEFS_LIB_INODE_RDLOCK(InodeTable);
+    SlotEnd = FileDescriptorPointer->ExtentOffset + InodeTable->File[FileDescriptorPointer->ExtentIndex].MaxFileSize;
+    if ((FileDescriptorPointer->ByteOffset == SlotEnd) &&
+        (EEFS_LibHasNextExtent(InodeTable, FileDescriptorPointer->ExtentIndex) == TRUE)) {
+        FileDescriptorPointer->ExtentIndex = InodeTable->File[FileDescriptorPointer->ExtentIndex].NextExtent;
+        FileDescriptorPointer->ExtentOffset = SlotEnd;
+        FileDescriptorPointer->FileDataPointer = InodeTable->File[FileDescriptorPointer->ExtentIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
+        SlotEnd += InodeTable->File[FileDescriptorPointer->ExtentIndex].MaxFileSize;
+    }
+    EEFS_LIB_INODE_UNLOCK(InodeTable);
+#else
+    SlotEnd = FileDescriptorPointer->MaxFileSize;
+#endif
 
-                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+    if (SlotEnd > FileDescriptorPointer->ByteOffset) {
+        return(SlotEnd - FileDescriptorPointer->ByteOffset);
+    }
+    return(0);
 
-                        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-                        FileHeader.Attributes = Attributes;
-                        EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-                        EEFS_LIB_EEPROM_FLUSH;
-                        ReturnCode = EEFS_SUCCESS;
-                    }
-                    else { /* file not found */
-                        ReturnCode = EEFS_FILE_NOT_FOUND;
-                    }
-                }
-                else { /* file system is write protected */
-                    ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
-                }
-            }
-            else { /* invalid filename */
-                ReturnCode = EEFS_INVALID_ARGUMENT;
-            }
-        }
-        else { /* invalid attributes */
-            ReturnCode = EEFS_INVALID_ARGUMENT;
-        }
+} /* End of EEFS_LibContiguousBytes() */
+
+/* Returns the number of bytes a file can hold in its slot and all of its extents */
+uint32 EEFS_LibFileCapacity(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    uint32      Capacity;
+
+    Capacity = InodeTable->File[InodeIndex].MaxFileSize;
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    while (EEFS_LibHasNextExtent(InodeTable, InodeIndex) == TRUE) {
+        InodeIndex = InodeTable->File[InodeIndex].NextExtent;
+        Capacity += InodeTable->File[InodeIndex].MaxFileSize;
     }
-    else { /* invalid inode table */
-        ReturnCode = EEFS_INVALID_ARGUMENT;
+#endif
+    return(Capacity);
+
+} /* End of EEFS_LibFileCapacity() */
+
+/* Returns the Inode of the file a slot belongs to, which is the slot itself unless it is an extent of a file */
+uint32 EEFS_LibFileOwner(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    if ((InodeTable->File[InodeIndex].InUse == EEFS_EXTENT_IN_USE) &&
+        (InodeTable->File[InodeIndex].Owner != EEFS_END_OF_EXTENT_CHAIN)) {
+        return(InodeTable->File[InodeIndex].Owner);
     }
+#else
+    (void)InodeTable;
+#endif
+    return(InodeIndex);
 
-    EEFS_LIB_UNLOCK;
-    return(ReturnCode); 
-    
-} /* End of EEFS_LibSetFileAttributes() */
+} /* End of EEFS_LibFileOwner() */
 
-/* Opens a file system for reading the file directory.  This should be followed by calls to EEFS_ReadDir() and EEFS_CloseDir().
- * Note that currently only one process can read the file directory at a time.  Returns a pointer to a directory descriptor
- * on success and a NULL pointer on error. */
-EEFS_DirectoryDescriptor_t *EEFS_LibOpenDir(EEFS_InodeTable_t *InodeTable)
+/* Returns TRUE if a slot is followed by an extent of its file */
+uint8 EEFS_LibHasNextExtent(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
 {
-    EEFS_DirectoryDescriptor_t      *DirectoryDescriptor;
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    if (InodeTable->File[InodeIndex].NextExtent != EEFS_END_OF_EXTENT_CHAIN) {
+        return(TRUE);
+    }
+#else
+    (void)InodeTable;
+    (void)InodeIndex;
+#endif
+    return(FALSE);
 
-    EEFS_LIB_LOCK;
-    if (InodeTable != NULL) {
+} /* End of EEFS_LibHasNextExtent() */
 
-        if (EEFS_DirectoryDescriptor.InUse == FALSE) {
+/* Returns the number of spare bytes the spare byte policy of the volume adds to the slot of a file of FileSize bytes.
+ * PreviousMaxFileSize is the capacity of the removed file of the same name, or 0 if it is not known.  The caller must hold
+ * the volume lock. */
+uint32 EEFS_LibSpareBytes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 FileSize, uint32 PreviousMaxFileSize)
+{
+    uint32              Parameter;
+    uint32              SlotSize;
+    uint32              SpareBytes;
 
-            EEFS_DirectoryDescriptor.InUse = TRUE;
-            EEFS_DirectoryDescriptor.InodeIndex = 0;
-            EEFS_DirectoryDescriptor.InodeTable = InodeTable;
-            DirectoryDescriptor = &EEFS_DirectoryDescriptor;
-        }
-        else { /* no available directory descriptors */
-            DirectoryDescriptor = NULL;
+    Parameter = InodeTable->SparePolicy.Parameter;
+    if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_PERCENT) {
+        SpareBytes = ((FileSize / 100) * Parameter) + (((FileSize % 100) * Parameter) / 100);
+    }
+    else if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_POWER_OF_TWO) {
+        SlotSize = 4;
+        while ((SlotSize < EEFS_MAX(FileSize, Parameter)) && (SlotSize < 0x80000000)) {
+            SlotSize <<= 1;
         }
+        SpareBytes = (SlotSize > FileSize) ? (SlotSize - FileSize) : 0;
     }
-    else { /* invalid inode table */
-        DirectoryDescriptor = NULL;
+    else if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_LEARNED) {
+        /* A file that has outgrown its old slot is given the default spare bytes again */
+        SpareBytes = (PreviousMaxFileSize >= FileSize) ? (PreviousMaxFileSize - FileSize) : Parameter;
+    }
+    else if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_CUSTOM) {
+        SpareBytes = InodeTable->SparePolicy.Function(Filename, FileSize, PreviousMaxFileSize, Parameter);
+    }
+    else { /* EEFS_SPARE_POLICY_FIXED */
+        SpareBytes = Parameter;
     }
+    return(SpareBytes);
 
-    EEFS_LIB_UNLOCK;
-    return(DirectoryDescriptor);
-    
-} /* End of EEFS_LibOpenDir() */
+} /* End of EEFS_LibSpareBytes() */
 
-/* Read the next file directory entry.  Returns a pointer to a EEFS_DirectoryEntry_t if successful or NULL if no more file
- * directory entries exist or an error occurs.  Note that all entries are returned, even empty slots. (The InUse flag will be
- * set to FALSE for empty slots) */
-EEFS_DirectoryEntry_t *EEFS_LibReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+/* Remembers the name and capacity of a file that is about to be removed for the learned spare byte policy.  An older entry
+ * for the same name is replaced, otherwise the oldest entry is.  The caller must hold the volume write lock. */
+void EEFS_LibAddToSpareHistory(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
 {
-    EEFS_FileHeader_t               FileHeader;
-    EEFS_DirectoryEntry_t          *DirectoryEntry;
-
-    EEFS_LIB_LOCK;
-    if (DirectoryDescriptor != NULL) {
+    uint32      i;
 
-        if (DirectoryDescriptor->InodeIndex < DirectoryDescriptor->InodeTable->NumberOfFiles) {
-            
-            EEFS_LIB_EEPROM_READ(&FileHeader, DirectoryDescriptor->InodeTable->File[DirectoryDescriptor->InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-            EEFS_DirectoryEntry.InodeIndex = DirectoryDescriptor->InodeIndex;
-            EEFS_DirectoryEntry.FileHeaderPointer = DirectoryDescriptor->InodeTable->File[DirectoryDescriptor->InodeIndex].FileHeaderPointer;
-            EEFS_DirectoryEntry.MaxFileSize = DirectoryDescriptor->InodeTable->File[DirectoryDescriptor->InodeIndex].MaxFileSize;
-            EEFS_DirectoryEntry.InUse = FileHeader.InUse;
-            strncpy(EEFS_DirectoryEntry.Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
-            DirectoryDescriptor->InodeIndex++;
-            DirectoryEntry = &EEFS_DirectoryEntry;
-        }
-        else { /* no more directory entries */
-            DirectoryEntry = NULL;
+    for (i=0; i < EEFS_SPARE_HISTORY_SIZE; i++) {
+        if (strncmp(InodeTable->SpareHistory[i].Filename, InodeTable->File[InodeIndex].Filename, EEFS_MAX_FILENAME_SIZE) == 0) {
+            break;
         }
     }
-    else { /* invalid directory descriptor */
-        DirectoryEntry = NULL;
+    if (i == EEFS_SPARE_HISTORY_SIZE) {
+        i = InodeTable->SpareHistoryNext;
+        InodeTable->SpareHistoryNext = (InodeTable->SpareHistoryNext + 1) % EEFS_SPARE_HISTORY_SIZE;
     }
+    memcpy(InodeTable->SpareHistory[i].Filename, InodeTable->File[InodeIndex].Filename, EEFS_MAX_FILENAME_SIZE);
+    InodeTable->SpareHistory[i].MaxFileSize = EEFS_LibFileCapacity(InodeTable, InodeIndex);
 
-    EEFS_LIB_UNLOCK;
-    return(DirectoryEntry);
-    
-} /* End of EEFS_LibReadDir() */
+} /* End of EEFS_LibAddToSpareHistory() */
 
-/* Close file system for reading the file directory.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibCloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+/* Returns the capacity of the removed file with the specified Filename and forgets it, or returns 0 if the file is not in the
+ * spare history.  The caller must hold the volume write lock. */
+uint32 EEFS_LibTakeFromSpareHistory(EEFS_InodeTable_t *InodeTable, char *Filename)
 {
-    int32                           ReturnCode;
-
-    EEFS_LIB_LOCK;
-    if (DirectoryDescriptor != NULL) {
+    uint32      i;
+    uint32      MaxFileSize;
+
+    for (i=0; i < EEFS_SPARE_HISTORY_SIZE; i++) {
+        if ((InodeTable->SpareHistory[i].Filename[0] != '\0') &&
+            (strncmp(InodeTable->SpareHistory[i].Filename, Filename, EEFS_MAX_FILENAME_SIZE) == 0)) {
+            MaxFileSize = InodeTable->SpareHistory[i].MaxFileSize;
+            memset(&InodeTable->SpareHistory[i], 0, sizeof(EEFS_SpareHistoryEntry_t));
+            return(MaxFileSize);
+        }
+    }
+    return(0);
 
-        if (DirectoryDescriptor->InUse == TRUE) {
+} /* End of EEFS_LibTakeFromSpareHistory() */
 
-            memset(DirectoryDescriptor, 0, sizeof(EEFS_DirectoryDescriptor_t)); /* this sets InUse to FALSE */
-            memset(&EEFS_DirectoryEntry, 0, sizeof(EEFS_DirectoryEntry_t));
-            ReturnCode = EEFS_SUCCESS;
-        }
-        else { /* directory descriptor not in use */
-            ReturnCode = EEFS_INVALID_ARGUMENT;
+/* Counts a write that reached the end of the last slot of a file in the spare byte statistics of the volume.  BytesToWrite is
+ * the number of bytes that could be written after the file was given room to grow, 0 if the write was cut short.  A file that
+ * is being created already owns all of free memory, so reaching its end means the volume is full and is not counted.  The
+ * caller must hold the File Descriptor lock. */
+void EEFS_LibCountRegrow(EEFS_FileDescriptor_t *FileDescriptorPointer, uint32 BytesToWrite)
+{
+    EEFS_InodeTable_t  *InodeTable;
+
+    if ((FileDescriptorPointer->Mode & EEFS_FCREAT) == 0) {
+        InodeTable = FileDescriptorPointer->InodeTable;
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        InodeTable->SpareStats.RegrowEvents++;
+        if (BytesToWrite == 0) {
+            InodeTable->SpareStats.FailedRegrows++;
         }
-    }
-    else { /* invalid directory descriptor */
-        ReturnCode = EEFS_INVALID_ARGUMENT;
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
     }
 
-    EEFS_LIB_UNLOCK;
-    return(ReturnCode);
-    
-} /* End of EEFS_LibCloseDir() */
+} /* End of EEFS_LibCountRegrow() */
 
-/* Returns TRUE if any files in the file system are open. */
-uint8 EEFS_LibHasOpenFiles(EEFS_InodeTable_t *InodeTable)
+#if (EEFS_RELOCATE_ON_GROW == TRUE)
+/* Moves a file that is open for write to a slot that can hold at least Length more bytes, plus the spare bytes given by the
+ * spare byte policy of the volume if there is room, then returns the number of bytes that can be written at the
+ * FileDataPointer of the File Descriptor, or 0 if the file could not be moved.  Only a file that is not open by any other
+ * File Descriptor is moved since their FileDataPointers would be left in the old slot.  The caller must hold the File
+ * Descriptor lock. */
+uint32 EEFS_LibGrowFile(EEFS_FileDescriptor_t *FileDescriptorPointer, uint32 Length)
 {
-    uint32  i;
-
-    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
-        if ((EEFS_FileDescriptorTable[i].InUse == TRUE) &&
-            (EEFS_FileDescriptorTable[i].InodeTable == InodeTable)) {
-            return(TRUE); /* a file is open */
+    EEFS_InodeTable_t                  *InodeTable;
+    uint32                              InodeIndex;
+    uint32                              NewMaxFileSize;
+    uint32                              SpareBytes;
+
+    InodeTable = FileDescriptorPointer->InodeTable;
+    InodeIndex = FileDescriptorPointer->InodeIndex;
+    EEFS_LIB_INODE_WRLOCK(InodeTable);
+
+    /* A file that is being created already owns all of free memory */
+    if ((EEFS_LIB_IS_WRITE_PROTECTED == FALSE) &&
+        ((FileDescriptorPointer->Mode & EEFS_FCREAT) == 0) &&
+        (EEFS_LibHasNextExtent(InodeTable, InodeIndex) == FALSE) &&
+        (InodeTable->File[InodeIndex].WriteCount == 1) &&
+        (InodeTable->File[InodeIndex].ReadCount == ((FileDescriptorPointer->Mode & EEFS_FREAD) ? 1 : 0))) {
+
+        /* Nothing is moved if the slot has been extended over the File Header of a deleted slot since the file was opened */
+        if (InodeTable->File[InodeIndex].MaxFileSize <= FileDescriptorPointer->ByteOffset) {
+            Length = EEFS_MIN(Length, InodeTable->FreeMemorySize);
+            SpareBytes = EEFS_LibSpareBytes(InodeTable, InodeTable->File[InodeIndex].Filename, (FileDescriptorPointer->ByteOffset + Length), 0);
+            SpareBytes = EEFS_MIN(SpareBytes, InodeTable->FreeMemorySize);
+            NewMaxFileSize = EEFS_ROUND_UP((FileDescriptorPointer->ByteOffset + Length + SpareBytes), 4);
+            if (EEFS_LibRelocateFile(InodeTable, InodeIndex, NewMaxFileSize, FileDescriptorPointer->FileSize) != EEFS_SUCCESS) {
+                NewMaxFileSize = EEFS_ROUND_UP((FileDescriptorPointer->ByteOffset + Length), 4);
+                EEFS_LibRelocateFile(InodeTable, InodeIndex, NewMaxFileSize, FileDescriptorPointer->FileSize);
+            }
         }
+        FileDescriptorPointer->FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+        FileDescriptorPointer->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+        EEFS_LibSeekFileData(FileDescriptorPointer);
     }
-    return(FALSE);
-    
-} /* End of EEFS_LibHasOpenFiles() */
+    EEFS_LIB_INODE_UNLOCK(InodeTable);
 
-/* Returns TRUE if a directory is open. */
-uint8 EEFS_LibHasOpenDir(EEFS_InodeTable_t *InodeTable)
+    return(EEFS_LibContiguousBytes(FileDescriptorPointer));
+
+} /* End of EEFS_LibGrowFile() */
+#endif
+
+#if (EEFS_EXTENT_CHAINING == TRUE)
+/* Adds an extent that can hold at least Length bytes to the end of a file that is open for write, then returns the number of
+ * bytes that can be written at the FileDataPointer of the File Descriptor, or 0 if no extent could be added.  The extent is
+ * written before it is linked to the file so a reset never leaves a file with a link to a slot that is not its extent.  The
+ * caller must hold the File Descriptor lock. */
+uint32 EEFS_LibAddExtent(EEFS_FileDescriptor_t *FileDescriptorPointer, uint32 Length)
 {
-    if ((EEFS_DirectoryDescriptor.InUse == TRUE) &&
-        (EEFS_DirectoryDescriptor.InodeTable == InodeTable)) {
-        return(TRUE); /* a directory is open */
+    EEFS_InodeTable_t                  *InodeTable;
+    EEFS_FileHeader_t                   FileHeader;
+    int32                               InodeIndex;
+    int32                               LastInodeIndex;
+    void                               *FileHeaderPointer;
+    uint32                              MaxFileSize;
+    uint32                              Mode;
+    uint8                               ReserveSlot;
+
+    InodeTable = FileDescriptorPointer->InodeTable;
+    LastInodeIndex = FileDescriptorPointer->ExtentIndex;
+    EEFS_LIB_INODE_WRLOCK(InodeTable);
+
+    /* A file that is being created already owns all of free memory */
+    if ((EEFS_LIB_IS_WRITE_PROTECTED == FALSE) &&
+        ((FileDescriptorPointer->Mode & EEFS_FCREAT) == 0) &&
+        (EEFS_LibHasNextExtent(InodeTable, LastInodeIndex) == FALSE) &&
+        (FileDescriptorPointer->ByteOffset == (FileDescriptorPointer->ExtentOffset + InodeTable->File[LastInodeIndex].MaxFileSize))) {
+
+        if ((InodeIndex = EEFS_LibFindNewSlot(InodeTable, (uint32)EEFS_ROUND_UP(EEFS_MAX(Length, EEFS_MIN_EXTENT_SIZE), 4),
+                                              &FileHeaderPointer, &MaxFileSize, &Mode, &ReserveSlot)) >= 0) {
+
+            /* The FileSize of an extent is the size of its slot, an extent is full unless it is the last slot of its file */
+            memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
+            FileHeader.Crc = 0;    /* Automatically updating the CRC is not supported at this time */
+            FileHeader.InUse = EEFS_EXTENT_IN_USE;
+            FileHeader.Attributes = EEFS_ATTRIBUTE_NONE;
+            FileHeader.FileSize = MaxFileSize;
+            FileHeader.ModificationDate = EEFS_LIB_TIME;
+            FileHeader.CreationDate = FileHeader.ModificationDate;
+            EEFS_LibWriteNewSlot(InodeTable, InodeIndex, FileHeaderPointer, MaxFileSize, ReserveSlot, &FileHeader);
+            InodeTable->File[InodeIndex].Owner = FileDescriptorPointer->InodeIndex;
+
+            /* Link the extent to the end of the file.  The last slot of the file may have been extended over the old File
+             * Header of the extent, which only leaves a few more bytes to write before the extent. */
+            EEFS_LibReadFileHeader(InodeTable, LastInodeIndex, &FileHeader);
+            FileHeader.NextExtent = InodeIndex + 1;
+            EEFS_LibWriteFileHeaderFields(InodeTable, LastInodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(NextExtent));
+        }
     }
-    return(FALSE);
-    
-} /* End of EEFS_LibHasOpenDir() */
+    EEFS_LIB_INODE_UNLOCK(InodeTable);
 
-/* Returns TRUE if any files in the file system are open for create. */
-uint8 EEFS_LibHasOpenCreat(EEFS_InodeTable_t *InodeTable)
+    return(EEFS_LibContiguousBytes(FileDescriptorPointer));
+
+} /* End of EEFS_LibAddExtent() */
+
+/* Links each extent to the file it belongs to by following the NextExtent links from every file.  A link that does not lead
+ * to an extent that belongs to no other file, which can only be left by corruption, ends the chain.  Extents that do not
+ * belong to a file, which are left by a reset during EEFS_LibWrite() or EEFS_LibRemove(), are deleted if the file system is
+ * not write protected.  Called by EEFS_LibInitFS() after the filename hash index is built. */
+void EEFS_LibBuildExtentChains(EEFS_InodeTable_t *InodeTable)
 {
-    uint32  i;
+    EEFS_FileHeader_t   FileHeader;
+    uint32              i;
+    uint32              InodeIndex;
+    int32               NextExtent;
 
-    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
-        if ((EEFS_FileDescriptorTable[i].InUse == TRUE) &&
-            (EEFS_FileDescriptorTable[i].InodeTable == InodeTable) &&
-            (EEFS_FileDescriptorTable[i].Mode & EEFS_FCREAT)) {
-            return(TRUE); /* a file is open for creat */
-        }
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        InodeTable->File[i].Owner = EEFS_END_OF_EXTENT_CHAIN;
     }
-    return(FALSE);
-    
-} /* End of EEFS_LibHasOpenCreat() */
 
-/* Searches the file descriptor table for entries that match the specified file and 
- * or's together all of the file mode flags.  The return bit mask will be EEFS_FREAD if
- * the file is open for read access, EEFS_WRITE if the file is open for write access, 
- * (EEFS_FREAD | EEFS_FWRITE) if the file is open for both read and write access, or
- * EEFS_CREAT if a new file is being created. */
-uint32 EEFS_LibFmode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
-{
-    uint32      i;
-    uint32      Mode = 0;
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if (InodeTable->File[i].InUse == TRUE) {
+            InodeIndex = i;
+            while ((NextExtent = InodeTable->File[InodeIndex].NextExtent) != EEFS_END_OF_EXTENT_CHAIN) {
+                if ((NextExtent >= 0) &&
+                    ((uint32)NextExtent < InodeTable->NumberOfFiles) &&
+                    (InodeTable->File[NextExtent].InUse == EEFS_EXTENT_IN_USE) &&
+                    (InodeTable->File[NextExtent].Owner == EEFS_END_OF_EXTENT_CHAIN)) {
+                    InodeTable->File[NextExtent].Owner = i;
+                    InodeIndex = NextExtent;
+                }
+                else if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) { /* invalid link */
+                    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                    FileHeader.NextExtent = 0;
+                    EEFS_LibWriteFileHeaderFields(InodeTable, InodeIndex, &FileHeader, EEFS_FILE_HEADER_FIELD(NextExtent));
+                }
+                else { /* invalid link on a write protected file system */
+                    InodeTable->File[InodeIndex].NextExtent = EEFS_END_OF_EXTENT_CHAIN;
+                }
+            }
+        }
+    }
 
-    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
-        if ((EEFS_FileDescriptorTable[i].InUse == TRUE) &&
-            (EEFS_FileDescriptorTable[i].InodeTable == InodeTable) &&
-            (EEFS_FileDescriptorTable[i].InodeIndex == InodeIndex)) {
-            Mode |= EEFS_FileDescriptorTable[i].Mode;
+    if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+        for (i=0; i < InodeTable->NumberOfFiles; i++) {
+            if ((InodeTable->File[i].InUse == EEFS_EXTENT_IN_USE) &&
+                (InodeTable->File[i].Owner == EEFS_END_OF_EXTENT_CHAIN)) {
+                EEFS_LibReadFileHeader(InodeTable, i, &FileHeader);
+                FileHeader.InUse = FALSE;
+                EEFS_LibWriteFileHeaderFields(InodeTable, i, &FileHeader, EEFS_FILE_HEADER_FIELD(InUse));
+            }
         }
     }
-    return(Mode);
-    
-} /* End of EEFS_LibFmode() */
 
-/* Performs a sequential search of the InodeTable looking for a matching Filename. */
-int32 EEFS_LibFindFile(EEFS_InodeTable_t *InodeTable, char *Filename)
+} /* End of EEFS_LibBuildExtentChains() */
+#endif
+
+/* Allocates a free File Descriptor from the private File Descriptor Pool of the volume, or from the shared pool if the
+ * volume does not have its own pool.  The free entries of each pool are kept in a linked list so this takes constant time.
+ * The caller must hold the global lock. */
+int32 EEFS_LibGetFileDescriptor(EEFS_InodeTable_t *InodeTable)
 {
-    uint32                          i;
-    EEFS_FileHeader_t               FileHeader;
+    EEFS_FileDescriptorPool_t  *FileDescriptorPool;
+    int32                       Entry;
+    int32                       FileDescriptor;
 
-    for (i=0; i < InodeTable->NumberOfFiles; i++) {
-        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[i].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-        if ((FileHeader.InUse == TRUE) &&
-            (strncmp(Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE) == 0))
-            return(i);
+    if (InodeTable->FileDescriptorPool.FileDescriptorTable != NULL) {
+        FileDescriptorPool = &InodeTable->FileDescriptorPool;
+    }
+    else {
+        FileDescriptorPool = &EEFS_SharedFileDescriptorPool;
     }
-    return(EEFS_FILE_NOT_FOUND);
-    
-} /* End of EEFS_LibFindFile() */
 
-/* Allocates a free entry in the FileDescriptorTable. */
-int32 EEFS_LibGetFileDescriptor(void)
-{
-    uint32      i;
-    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
-        if (EEFS_FileDescriptorTable[i].InUse == FALSE) {
-            EEFS_FileDescriptorTable[i].InUse = TRUE;
-            EEFS_FileDescriptorsInUse++;
-            if (EEFS_FileDescriptorsInUse > EEFS_FileDescriptorsHighWaterMark) {
-                EEFS_FileDescriptorsHighWaterMark = EEFS_FileDescriptorsInUse;
-            }
-            return(i);
+    if ((Entry = FileDescriptorPool->FreeList) != EEFS_END_OF_FREE_LIST) {
+        FileDescriptorPool->FreeList = FileDescriptorPool->FileDescriptorTable[Entry].NextFree;
+        FileDescriptorPool->FileDescriptorTable[Entry].InUse = TRUE;
+        FileDescriptorPool->FileDescriptorsInUse++;
+        if (FileDescriptorPool->FileDescriptorsInUse > FileDescriptorPool->FileDescriptorsHighWaterMark) {
+            FileDescriptorPool->FileDescriptorsHighWaterMark = FileDescriptorPool->FileDescriptorsInUse;
         }
+        FileDescriptor = ((FileDescriptorPool->PoolIndex << EEFS_FILE_DESCRIPTOR_POOL_SHIFT) | Entry);
     }
-    return(EEFS_NO_FREE_FILE_DESCRIPTOR);
+    else { /* no available file descriptor */
+        FileDescriptor = EEFS_NO_FREE_FILE_DESCRIPTOR;
+    }
+
+    return(FileDescriptor);
     
 } /* End of EEFS_LibGetFileDescriptor() */
 
-/* Returns a entry to the FileDescriptorTable. */
+/* Returns a File Descriptor to the free list of its File Descriptor Pool.  The caller must hold the File Descriptor lock, the
+ * volume lock and the global lock.  The File Descriptor lock itself is preserved so the caller can release it afterwards. */
 int32 EEFS_LibFreeFileDescriptor(int32 FileDescriptor)
 {
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
-        memset(&EEFS_FileDescriptorTable[FileDescriptor], 0, sizeof(EEFS_FileDescriptor_t)); /* This sets InUse to FALSE */
-        EEFS_FileDescriptorsInUse--;
+    EEFS_FileDescriptorPool_t  *FileDescriptorPool;
+    EEFS_FileDescriptor_t      *FileDescriptorPointer;
+    uint32                      LockId;
+
+    if ((FileDescriptorPointer = EEFS_LibFileDescriptor2Pointer(FileDescriptor)) != NULL) {
+        if (FileDescriptorPointer->InodeTable != NULL) {
+            EEFS_LibRemoveOpenMode(FileDescriptorPointer->InodeTable,
+                                   FileDescriptorPointer->InodeIndex,
+                                   FileDescriptorPointer->Mode);
+        }
+        FileDescriptorPool = EEFS_FileDescriptorPools[(uint32)FileDescriptor >> EEFS_FILE_DESCRIPTOR_POOL_SHIFT];
+        LockId = FileDescriptorPointer->LockId;
+        memset(FileDescriptorPointer, 0, sizeof(EEFS_FileDescriptor_t)); /* This sets InUse to FALSE */
+        FileDescriptorPointer->LockId = LockId;
+        FileDescriptorPointer->NextFree = FileDescriptorPool->FreeList;
+        FileDescriptorPool->FreeList = (FileDescriptor & EEFS_FILE_DESCRIPTOR_ENTRY_MASK);
+        FileDescriptorPool->FileDescriptorsInUse--;
         return(EEFS_SUCCESS);
     }
     return(EEFS_INVALID_ARGUMENT);
@@ -1089,9 +3303,7 @@ int32 EEFS_LibFreeFileDescriptor(int32 FileDescriptor)
 /* Returns TRUE is the specified File Descriptor is valid */
 uint8 EEFS_LibIsValidFileDescriptor(int32 FileDescriptor)
 {
-    if ((FileDescriptor >= 0) &&
-        (FileDescriptor < EEFS_MAX_OPEN_FILES) &&
-        (EEFS_FileDescriptorTable[FileDescriptor].InUse == TRUE)) {
+    if (EEFS_LibFileDescriptor2Pointer(FileDescriptor) != NULL) {
         return(TRUE);
     }
     else {
@@ -1104,15 +3316,130 @@ uint8 EEFS_LibIsValidFileDescriptor(int32 FileDescriptor)
  * File Descriptor is not valid */
 EEFS_FileDescriptor_t *EEFS_LibFileDescriptor2Pointer(int32 FileDescriptor)
 {
-    if (EEFS_LibIsValidFileDescriptor(FileDescriptor)) {
-        return(&EEFS_FileDescriptorTable[FileDescriptor]);
-    }
-    else {
-        return(NULL);
+    EEFS_FileDescriptor_t      *FileDescriptorPointer;
+
+    if (((FileDescriptorPointer = EEFS_LibFileDescriptorEntry(FileDescriptor)) != NULL) &&
+        (FileDescriptorPointer->InUse == TRUE)) {
+        return(FileDescriptorPointer);
     }
+    return(NULL);
     
 } /* End of EEFS_LibFileDescriptor2Pointer() */
 
+/* Returns a pointer to the File Descriptor Pool entry addressed by the specified File Descriptor whether or not the entry is
+ * in use, or NULL if the File Descriptor is out of range. */
+EEFS_FileDescriptor_t *EEFS_LibFileDescriptorEntry(int32 FileDescriptor)
+{
+    EEFS_FileDescriptorPool_t  *FileDescriptorPool;
+    uint32                      PoolIndex;
+    uint32                      Entry;
+
+    if (FileDescriptor >= 0) {
+
+        PoolIndex = (uint32)FileDescriptor >> EEFS_FILE_DESCRIPTOR_POOL_SHIFT;
+        Entry = (uint32)FileDescriptor & EEFS_FILE_DESCRIPTOR_ENTRY_MASK;
+        if ((PoolIndex < EEFS_MAX_FILE_DESCRIPTOR_POOLS) &&
+            ((FileDescriptorPool = EEFS_FileDescriptorPools[PoolIndex]) != NULL) &&
+            (Entry < FileDescriptorPool->NumberOfFileDescriptors)) {
+            return(&FileDescriptorPool->FileDescriptorTable[Entry]);
+        }
+    }
+    return(NULL);
+
+} /* End of EEFS_LibFileDescriptorEntry() */
+
+/* Takes the lock of the specified File Descriptor and returns a pointer to it, or returns NULL without holding the lock if
+ * the File Descriptor is not valid.  The InUse flag is checked after the lock is taken so a File Descriptor that is closed
+ * by another task while we wait for the lock is rejected. */
+EEFS_FileDescriptor_t *EEFS_LibLockFileDescriptor(int32 FileDescriptor)
+{
+    EEFS_FileDescriptor_t      *FileDescriptorPointer;
+
+    if ((FileDescriptorPointer = EEFS_LibFileDescriptorEntry(FileDescriptor)) != NULL) {
+        EEFS_LIB_FD_LOCK(FileDescriptorPointer);
+        if (FileDescriptorPointer->InUse == TRUE) {
+            return(FileDescriptorPointer);
+        }
+        EEFS_LIB_FD_UNLOCK(FileDescriptorPointer);
+    }
+    return(NULL);
+
+} /* End of EEFS_LibLockFileDescriptor() */
+
+/* Gives a volume its own pool of File Descriptors using the caller supplied FileDescriptorTable.  This must be called after
+ * EEFS_LibInitFS() and before any files are opened on the volume, and the FileDescriptorTable must remain valid until
+ * EEFS_LibFreeFS() is called.  Returns EEFS_SUCCESS on success, EEFS_DEVICE_IS_BUSY, EEFS_NO_FREE_FILE_DESCRIPTOR or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibInitFileDescriptorPool(EEFS_InodeTable_t *InodeTable, EEFS_FileDescriptor_t *FileDescriptorTable, uint32 NumberOfFileDescriptors)
+{
+    uint32                      PoolIndex;
+    uint32                      i;
+    int32                       ReturnCode;
+
+    if ((InodeTable != NULL) &&
+        (FileDescriptorTable != NULL) &&
+        (NumberOfFileDescriptors > 0) &&
+        (NumberOfFileDescriptors <= (EEFS_FILE_DESCRIPTOR_ENTRY_MASK + 1))) {
+
+        EEFS_LIB_INODE_WRLOCK(InodeTable);
+        EEFS_LIB_LOCK;
+
+        /* The pool can only be replaced while no files are open on the volume */
+        if ((EEFS_LibHasOpenFiles(InodeTable) == FALSE) &&
+            (InodeTable->FileDescriptorPool.FileDescriptorTable == NULL)) {
+
+            for (PoolIndex=1; PoolIndex < EEFS_MAX_FILE_DESCRIPTOR_POOLS; PoolIndex++) {
+                if (EEFS_FileDescriptorPools[PoolIndex] == NULL) {
+                    break;
+                }
+            }
+
+            if (PoolIndex < EEFS_MAX_FILE_DESCRIPTOR_POOLS) {
+
+                memset(FileDescriptorTable, 0, (NumberOfFileDescriptors * sizeof(EEFS_FileDescriptor_t)));
+                memset(&InodeTable->FileDescriptorPool, 0, sizeof(EEFS_FileDescriptorPool_t));
+                InodeTable->FileDescriptorPool.FileDescriptorTable = FileDescriptorTable;
+                InodeTable->FileDescriptorPool.NumberOfFileDescriptors = NumberOfFileDescriptors;
+                InodeTable->FileDescriptorPool.PoolIndex = PoolIndex;
+                EEFS_LibInitFreeList(&InodeTable->FileDescriptorPool);
+                for (i=0; i < NumberOfFileDescriptors; i++) {
+                    EEFS_LIB_FD_LOCK_CREATE(&FileDescriptorTable[i]);
+                }
+                EEFS_FileDescriptorPools[PoolIndex] = &InodeTable->FileDescriptorPool;
+                ReturnCode = EEFS_SUCCESS;
+            }
+            else { /* no available file descriptor pools */
+                ReturnCode = EEFS_NO_FREE_FILE_DESCRIPTOR;
+            }
+        }
+        else { /* files are open or the volume already has a pool */
+            ReturnCode = EEFS_DEVICE_IS_BUSY;
+        }
+
+        EEFS_LIB_UNLOCK;
+        EEFS_LIB_INODE_UNLOCK(InodeTable);
+    }
+    else { /* invalid argument */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibInitFileDescriptorPool() */
+
+/* Links all entries of a File Descriptor Pool into its free list. */
+void EEFS_LibInitFreeList(EEFS_FileDescriptorPool_t *FileDescriptorPool)
+{
+    uint32      i;
+
+    for (i=0; i < FileDescriptorPool->NumberOfFileDescriptors; i++) {
+        FileDescriptorPool->FileDescriptorTable[i].NextFree = i + 1;
+    }
+    FileDescriptorPool->FileDescriptorTable[FileDescriptorPool->NumberOfFileDescriptors - 1].NextFree = EEFS_END_OF_FREE_LIST;
+    FileDescriptorPool->FreeList = 0;
+
+} /* End of EEFS_LibInitFreeList() */
+
 /* Validates the specified Filename. Probably need to be more strict on what I allow. */
 uint8 EEFS_LibIsValidFilename(char *Filename)
 {
@@ -1129,6 +3456,7 @@ uint8 EEFS_LibIsValidFilename(char *Filename)
 int32 EEFS_LibChkDsk(EEFS_InodeTable_t *InodeTable, uint32 Flags)
 {
     EEFS_FileHeader_t               FileHeader;
+    EEFS_FileHeader_t               CachedFileHeader;
     uint32                          i;
 
 /* validate fat */
@@ -1158,23 +3486,35 @@ int32 EEFS_LibChkDsk(EEFS_InodeTable_t *InodeTable, uint32 Flags)
         printf("[%ld] Modification Date    %ld\n", i, FileHeader.ModificationDate);
         printf("[%ld] Creation Date        %ld\n", i, FileHeader.CreationDate);
         printf("[%ld] Filename             %-40s\n", i, FileHeader.Filename);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+        printf("[%ld] Next Extent          %ld\n", i, FileHeader.NextExtent);
+#endif
+
+        /* Verify that the ram copy of the File Header matches EEPROM */
+        EEFS_LibReadFileHeader(InodeTable, i, &CachedFileHeader);
+        if ((CachedFileHeader.InUse != FileHeader.InUse) ||
+            (CachedFileHeader.Attributes != FileHeader.Attributes) ||
+            (CachedFileHeader.FileSize != FileHeader.FileSize) ||
+            (memcmp(CachedFileHeader.Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE) != 0)) {
+            printf("[%ld] *** Ram copy of the File Header does not match EEPROM, remount the file system ***\n", i);
+        }
     }
     
     return(EEFS_SUCCESS);
     
 } /* End of EEFS_LibChkDsk() */
 
-/* Returns the number of file descriptors currently in use */
+/* Returns the number of file descriptors currently in use in the shared file descriptor table */
 uint32 EEFS_LibGetFileDescriptorsInUse(void)
 {
-    return(EEFS_FileDescriptorsInUse);
+    return(EEFS_SharedFileDescriptorPool.FileDescriptorsInUse);
 } /* End of EEFS_LibGetFileDescriptorsInUse() */
 
-/* Returns the file descriptors high water mark - useful for determining if the file descriptor table
+/* Returns the shared file descriptor table high water mark - useful for determining if the file descriptor table
  * is large enough */
 uint32 EEFS_LibGetFileDescriptorsHighWaterMark(void)
 {
-    return(EEFS_FileDescriptorsHighWaterMark);
+    return(EEFS_SharedFileDescriptorPool.FileDescriptorsHighWaterMark);
 } /* End of EEFS_LibGetFileDescriptorsHighWaterMark() */
 
 /* Returns the max number of files the file system can support */
@@ -1192,13 +3532,19 @@ uint32 EEFS_LibGetMaxOpenFiles(void)
 /* Prints the filenames of all open files for debugging */
 void EEFS_LibPrintOpenFiles(void)
 {
+    EEFS_FileDescriptorPool_t  *FileDescriptorPool;
     EEFS_FileHeader_t           FileHeader;
     uint32                      i;
-
-    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
-        if (EEFS_FileDescriptorTable[i].InUse == TRUE) {
-           EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[i].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-           printf("%s\n", FileHeader.Filename);
+    uint32                      j;
+
+    for (j=0; j < EEFS_MAX_FILE_DESCRIPTOR_POOLS; j++) {
+        if ((FileDescriptorPool = EEFS_FileDescriptorPools[j]) != NULL) {
+            for (i=0; i < FileDescriptorPool->NumberOfFileDescriptors; i++) {
+                if (FileDescriptorPool->FileDescriptorTable[i].InUse == TRUE) {
+                   EEFS_LibReadFileHeader(FileDescriptorPool->FileDescriptorTable[i].InodeTable, FileDescriptorPool->FileDescriptorTable[i].InodeIndex, &FileHeader);
+                   printf("%s\n", FileHeader.Filename);
+                }
+            }
         }
     }
     
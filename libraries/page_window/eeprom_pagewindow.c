@@ -22,6 +22,7 @@
 #include "eeprom_pagewindow.h"
 #include "common_types.h"
 #include "semLib.h"
+#include "taskLib.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -29,8 +30,26 @@
  * Local Data
  */
 
-SEM_ID                  EEPROM_semId;
-EEPROM_PageWindow_t     EEPROM_PageWindow;
+SEM_ID                      EEPROM_semId;
+EEPROM_PageWindow_t         EEPROM_PageWindow[EEPROM_PAGE_WINDOW_COUNT];
+uint32                      EEPROM_PageWindowUseCount;
+uint32                      EEPROM_PageWindowOptions;
+uint32                      EEPROM_DirtySequence;       /* DirtySequence of the next window to be changed, see Write Ordering */
+EEPROM_PageWindowStats_t    EEPROM_PageWindowStats;
+
+/* The flush queue holds the index of each page window that is waiting to be programmed by the flush task.  A page window is
+ * only queued once, so the queue never holds more than EEPROM_PAGE_WINDOW_COUNT entries. */
+SEM_ID                      EEPROM_FlushSemId;          /* given once for each page window that is queued */
+int                         EEPROM_FlushTaskId;         /* 0 if flushes are synchronous */
+uint32                      EEPROM_FlushQueue[EEPROM_PAGE_WINDOW_COUNT];
+uint32                      EEPROM_FlushQueueHead;
+uint32                      EEPROM_FlushQueueCount;
+uint32                      EEPROM_FlushRequests;       /* number of flushes requested */
+uint32                      EEPROM_FlushesCompleted;    /* number of flushes whose data has been programmed */
+EEPROM_FlushCallback_t      EEPROM_FlushCallback;
+
+/* Table for the reflected CRC-32 polynomial 0xEDB88320, built by EEPROM_PageWindowInit(), see Read Back Verify */
+uint32                      EEPROM_CrcTable[256];
 
 /*
  * Global Data
@@ -42,8 +61,19 @@ extern uint32           GSFC_EepromWriteEnableFlags;
  * Local Function Prototypes
  */
 
-void  EEPROM_PageWindowWriteByte(uint32 MemoryAddress, uint8 ByteValue);
-void  EEPROM_PageWindowLoad(uint32 MemoryAddress);
+EEPROM_PageWindow_t *EEPROM_PageWindowLookup(uint32 MemoryAddress);
+EEPROM_PageWindow_t *EEPROM_PageWindowFind(uint32 MemoryAddress);
+uint32               EEPROM_PageWindowSpan(uint32 MemoryAddress, uint32 Size);
+void                 EEPROM_PageWindowLoad(EEPROM_PageWindow_t *PageWindow, uint32 MemoryAddress);
+void                 EEPROM_PageWindowSetValid(EEPROM_PageWindow_t *PageWindow, uint32 Offset, uint32 Length);
+void                 EEPROM_PageWindowFill(EEPROM_PageWindow_t *PageWindow, uint32 Offset, uint32 Length);
+void                 EEPROM_PageWindowModify(EEPROM_PageWindow_t *PageWindow, uint32 Offset, void *Src, uint32 Length);
+void                 EEPROM_PageWindowProgramInOrder(EEPROM_PageWindow_t *PageWindow);
+void                 EEPROM_PageWindowProgram(EEPROM_PageWindow_t *PageWindow);
+void                 EEPROM_PageWindowFlushTask(void);
+void                 EEPROM_PageWindowFlushComplete(void);
+uint32               EEPROM_PageWindowVerify(EEPROM_PageWindow_t *PageWindow, uint32 Crc);
+uint32               EEPROM_Crc(uint32 Crc, uint8 *Buffer, uint32 Size);
 
 /*
  * External Function Prototypes
@@ -62,9 +92,30 @@ int     LRO_Read_EEPROM(void *to_addr, unsigned long int eeprom_offset, unsigned
 /* Initialize the data structures. */
 int32 EEPROM_PageWindowInit(void)
 {
+    uint32 i;
+    uint32 j;
+    uint32 Crc;
     int32  ReturnStatus = EEPROM_SUCCESS;
 
-    memset(&EEPROM_PageWindow, 0, sizeof(EEPROM_PageWindow_t));
+    memset(EEPROM_PageWindow, 0, sizeof(EEPROM_PageWindow));
+    memset(&EEPROM_PageWindowStats, 0, sizeof(EEPROM_PageWindowStats_t));
+    EEPROM_PageWindowUseCount = 0;
+    EEPROM_PageWindowOptions = 0;
+    EEPROM_DirtySequence = 0;
+    EEPROM_FlushTaskId = 0;
+    EEPROM_FlushQueueHead = 0;
+    EEPROM_FlushQueueCount = 0;
+    EEPROM_FlushRequests = 0;
+    EEPROM_FlushesCompleted = 0;
+    EEPROM_FlushCallback = NULL;
+
+    for (i=0; i < 256; i++) {
+        Crc = i;
+        for (j=0; j < 8; j++) {
+            Crc = (Crc & 1) ? ((Crc >> 1) ^ 0xEDB88320) : (Crc >> 1);
+        }
+        EEPROM_CrcTable[i] = Crc;
+    }
 
     if ((EEPROM_semId = semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE)) == NULL) {
         ReturnStatus = EEPROM_SEM_ERROR;
@@ -74,11 +125,16 @@ int32 EEPROM_PageWindowInit(void)
     
 } /* End of EEPROM_PageWindowInit() */
 
-/* High level api function to write data to the page window. */
+/* High level api function to write data to the page window.  The data is split into spans that end on a page boundary and
+ * each span is copied into its page window in one go. */
 int32 EEPROM_PageWindowWrite(void *Dest, void *Src, uint32 Size)
 {
-    uint32      i;
-    int32       ReturnStatus;
+    EEPROM_PageWindow_t    *PageWindow;
+    uint32                  MemoryAddress;
+    uint32                  Offset;
+    uint32                  BytesCopied;
+    uint32                  Length;
+    int32                   ReturnStatus;
 
     if ((Src != NULL) && (Dest != NULL)) {
         
@@ -87,8 +143,26 @@ int32 EEPROM_PageWindowWrite(void *Dest, void *Src, uint32 Size)
             if (EEPROM_IsWriteProtected((uint32)Dest) == FALSE) {
 
                 semTake(EEPROM_semId, WAIT_FOREVER);
-                for (i=0; i < Size; i++) {
-                    EEPROM_PageWindowWriteByte((uint32)(Dest + i), *((uint8 *)(Src + i)));
+                BytesCopied = 0;
+                while (BytesCopied < Size) {
+                    MemoryAddress = (uint32)(Dest + BytesCopied);
+                    Length = EEPROM_PageWindowSpan(MemoryAddress, (Size - BytesCopied));
+                    PageWindow = EEPROM_PageWindowFind(MemoryAddress);
+                    Offset = MemoryAddress - PageWindow->LowerAddress;
+                    PageWindow->Written = TRUE;
+
+                    /* A differential write only changes the window if the span is not already in eeprom */
+                    if (EEPROM_PageWindowOptions & EEPROM_OPTION_DIFFERENTIAL) {
+                        EEPROM_PageWindowFill(PageWindow, Offset, Length);
+                        if (memcmp(&PageWindow->Buffer[Offset], (Src + BytesCopied), Length) != 0) {
+                            EEPROM_PageWindowModify(PageWindow, Offset, (Src + BytesCopied), Length);
+                        }
+                    }
+                    else {
+                        EEPROM_PageWindowModify(PageWindow, Offset, (Src + BytesCopied), Length);
+                        EEPROM_PageWindowSetValid(PageWindow, Offset, Length);
+                    }
+                    BytesCopied += Length;
                 }
                 semGive(EEPROM_semId);
 
@@ -110,69 +184,516 @@ int32 EEPROM_PageWindowWrite(void *Dest, void *Src, uint32 Size)
     
 } /* End of EEPROM_PageWindowWrite() */
 
-/* Write a byte into the page window buffer */
-void EEPROM_PageWindowWriteByte(uint32 MemoryAddress, uint8 ByteValue)
-{   
-    if (EEPROM_PageWindow.Loaded == FALSE) {
-        EEPROM_PageWindowLoad(MemoryAddress);
+/* High level api function to read data through the page window.  Pages that are in a page window are copied from the window,
+ * so data that has not been flushed yet is returned, and each run of pages that are not is read from eeprom with a single
+ * read.  Reads do not load pages into the page windows, but the bytes being read that have not been written to the window
+ * are read into it first. */
+int32 EEPROM_PageWindowRead(void *Dest, void *Src, uint32 Size)
+{
+    EEPROM_PageWindow_t    *PageWindow;
+    uint32                  MemoryAddress;
+    uint32                  BytesCopied;
+    uint32                  BytesToRead;
+    uint32                  Length;
+    int32                   ReturnStatus;
+
+    if ((Src != NULL) && (Dest != NULL)) {
+
+        if (EEPROM_IsValidAddressRange((uint32)Src, Size) == TRUE) {
+
+            semTake(EEPROM_semId, WAIT_FOREVER);
+            BytesCopied = 0;
+            BytesToRead = 0;
+            while (BytesCopied < Size) {
+                MemoryAddress = (uint32)(Src + BytesCopied);
+                Length = EEPROM_PageWindowSpan(MemoryAddress, (Size - BytesCopied));
+                if ((PageWindow = EEPROM_PageWindowLookup(MemoryAddress)) != NULL) {
+                    if (BytesToRead > 0) {
+                        LRO_Read_EEPROM((Dest + BytesCopied - BytesToRead), (MemoryAddress - BytesToRead - EEPROM_START_ADDR), BytesToRead);
+                        BytesToRead = 0;
+                    }
+                    EEPROM_PageWindowFill(PageWindow, (MemoryAddress - PageWindow->LowerAddress), Length);
+                    memcpy((Dest + BytesCopied), &PageWindow->Buffer[MemoryAddress - PageWindow->LowerAddress], Length);
+                }
+                else {
+                    BytesToRead += Length;
+                }
+                BytesCopied += Length;
+            }
+            if (BytesToRead > 0) {
+                LRO_Read_EEPROM((Dest + Size - BytesToRead), ((uint32)(Src + Size) - BytesToRead - EEPROM_START_ADDR), BytesToRead);
+            }
+            semGive(EEPROM_semId);
+
+            ReturnStatus = EEPROM_SUCCESS;
+        }
+        else {
+            ReturnStatus = EEPROM_INVALID_ADDRESS;
+        }
     }
-    else if ((MemoryAddress < EEPROM_PageWindow.LowerAddress) || 
-             (MemoryAddress > EEPROM_PageWindow.UpperAddress)) {
-        EEPROM_PageWindowFlush();
-        EEPROM_PageWindowLoad(MemoryAddress);
+    else {
+        ReturnStatus = EEPROM_INVALID_ADDRESS;
     }
 
-    EEPROM_PageWindow.Buffer[MemoryAddress - EEPROM_PageWindow.LowerAddress] = ByteValue;
-    
-} /* End of EEPROM_PageWindowWriteByte() */
+    return(ReturnStatus);
+
+} /* End of EEPROM_PageWindowRead() */
+
+/* Returns the number of bytes from MemoryAddress to the end of its page, or Size if that is less */
+uint32 EEPROM_PageWindowSpan(uint32 MemoryAddress, uint32 Size)
+{
+    uint32      Length;
+
+    Length = EEPROM_PAGE_WINDOW_SIZE - (MemoryAddress & (EEPROM_PAGE_WINDOW_SIZE - 1));
+    if (Length > Size) {
+        Length = Size;
+    }
+    return(Length);
+
+} /* End of EEPROM_PageWindowSpan() */
+
+/* Returns the page window that holds MemoryAddress, or NULL if the page is not in a page window */
+EEPROM_PageWindow_t *EEPROM_PageWindowLookup(uint32 MemoryAddress)
+{
+    uint32      i;
+
+    for (i=0; i < EEPROM_PAGE_WINDOW_COUNT; i++) {
+        if ((EEPROM_PageWindow[i].Loaded == TRUE) &&
+            (MemoryAddress >= EEPROM_PageWindow[i].LowerAddress) &&
+            (MemoryAddress <= EEPROM_PageWindow[i].UpperAddress)) {
+            return(&EEPROM_PageWindow[i]);
+        }
+    }
+    return(NULL);
+
+} /* End of EEPROM_PageWindowLookup() */
+
+/* Returns the page window that holds MemoryAddress.  If the page is not in a window it is loaded into a free window, or into
+ * the least recently used window, which is programmed first if it is dirty. */
+EEPROM_PageWindow_t *EEPROM_PageWindowFind(uint32 MemoryAddress)
+{
+    EEPROM_PageWindow_t    *PageWindow;
+    uint32                  i;
+
+    EEPROM_PageWindowUseCount++;
+
+    if ((PageWindow = EEPROM_PageWindowLookup(MemoryAddress)) != NULL) {
+        PageWindow->LastUsed = EEPROM_PageWindowUseCount;
+        EEPROM_PageWindowStats.Hits++;
+        return(PageWindow);
+    }
+
+    PageWindow = &EEPROM_PageWindow[0];
+    for (i=0; (i < EEPROM_PAGE_WINDOW_COUNT) && (PageWindow->Loaded == TRUE); i++) {
+        if ((EEPROM_PageWindow[i].Loaded == FALSE) ||
+            (EEPROM_PageWindow[i].LastUsed < PageWindow->LastUsed)) {
+            PageWindow = &EEPROM_PageWindow[i];
+        }
+    }
+
+    if ((PageWindow->Loaded == TRUE) && (PageWindow->Dirty == TRUE)) {
+        EEPROM_PageWindowProgramInOrder(PageWindow);
+        EEPROM_PageWindowStats.Evictions++;
+    }
+    else if ((PageWindow->Loaded == TRUE) && (PageWindow->Written == TRUE)) {
+        EEPROM_PageWindowStats.ProgramsAvoided++;
+    }
+
+    EEPROM_PageWindowLoad(PageWindow, MemoryAddress);
+    PageWindow->LastUsed = EEPROM_PageWindowUseCount;
+    EEPROM_PageWindowStats.Misses++;
+    return(PageWindow);
+
+} /* End of EEPROM_PageWindowFind() */
 
-/* Write data from the page window buffer into eeprom */
+/* Write data from every dirty page window buffer into eeprom.  The windows stay loaded so later writes to the same pages do
+ * not have to read them from eeprom again.  If the flush task has been started the dirty windows are queued for the flush task
+ * instead, and this returns without waiting for them to be programmed, see Asynchronous Flushes. */
 void EEPROM_PageWindowFlush(void)
 {
-/*    uint32      i; */
-/*    uint8       ReadBackBuffer[EEPROM_PAGE_WINDOW_SIZE]; */
+    uint32      i;
+
+    semTake(EEPROM_semId, WAIT_FOREVER);
+    EEPROM_FlushRequests++;
+    for (i=0; i < EEPROM_PAGE_WINDOW_COUNT; i++) {
+        if ((EEPROM_PageWindow[i].Loaded == TRUE) && (EEPROM_PageWindow[i].Dirty == TRUE)) {
+            if (EEPROM_FlushTaskId == 0) {
+                EEPROM_PageWindowProgramInOrder(&EEPROM_PageWindow[i]);
+            }
+            else if (EEPROM_PageWindow[i].Queued == FALSE) {
+                EEPROM_PageWindow[i].Queued = TRUE;
+                EEPROM_FlushQueue[(EEPROM_FlushQueueHead + EEPROM_FlushQueueCount) % EEPROM_PAGE_WINDOW_COUNT] = i;
+                EEPROM_FlushQueueCount++;
+                semGive(EEPROM_FlushSemId);
+            }
+        }
+        else if ((EEPROM_PageWindow[i].Loaded == TRUE) && (EEPROM_PageWindow[i].Written == TRUE)) {
+            EEPROM_PageWindow[i].Written = FALSE;
+            EEPROM_PageWindowStats.ProgramsAvoided++;
+        }
+    }
+    if (EEPROM_FlushQueueCount == 0) {
+        EEPROM_PageWindowFlushComplete();
+    }
+    semGive(EEPROM_semId);
+
+} /* End of EEPROM_PageWindowFlush() */
+
+/* Write data from every dirty page window buffer into eeprom and wait until it has been programmed, including the page
+ * windows that are queued for the flush task.  This is the barrier for callers that need their data in eeprom. */
+void EEPROM_PageWindowSync(void)
+{
+    uint32      i;
+
+    semTake(EEPROM_semId, WAIT_FOREVER);
+    EEPROM_FlushRequests++;
+    for (i=0; i < EEPROM_PAGE_WINDOW_COUNT; i++) {
+        if ((EEPROM_PageWindow[i].Loaded == TRUE) && (EEPROM_PageWindow[i].Dirty == TRUE)) {
+            EEPROM_PageWindowProgramInOrder(&EEPROM_PageWindow[i]);
+        }
+        else if ((EEPROM_PageWindow[i].Loaded == TRUE) && (EEPROM_PageWindow[i].Written == TRUE)) {
+            EEPROM_PageWindow[i].Written = FALSE;
+            EEPROM_PageWindowStats.ProgramsAvoided++;
+        }
+        EEPROM_PageWindow[i].Queued = FALSE;
+    }
+
+    /* The flush task skips the semaphore counts of the entries that are dropped here */
+    EEPROM_FlushQueueHead = 0;
+    EEPROM_FlushQueueCount = 0;
+    EEPROM_PageWindowFlushComplete();
+    semGive(EEPROM_semId);
+
+} /* End of EEPROM_PageWindowSync() */
+
+/* Starts the flush task that programs the page windows queued by EEPROM_PageWindowFlush().  Returns EEPROM_SUCCESS on success,
+ * EEPROM_SEM_ERROR or EEPROM_ERROR on error. */
+int32 EEPROM_PageWindowStartFlushTask(int Priority)
+{
+    int     TaskId;
+    int32   ReturnStatus;
+
+    if (EEPROM_FlushTaskId == 0) {
+
+        if ((EEPROM_FlushSemId = semCCreate(SEM_Q_PRIORITY, 0)) != NULL) {
+
+            if ((TaskId = taskSpawn("tEepromFlush", Priority, 0, EEPROM_FLUSH_TASK_STACK_SIZE, (FUNCPTR)EEPROM_PageWindowFlushTask,
+                                    0, 0, 0, 0, 0, 0, 0, 0, 0, 0)) != ERROR) {
+                semTake(EEPROM_semId, WAIT_FOREVER);
+                EEPROM_FlushTaskId = TaskId;
+                semGive(EEPROM_semId);
+                ReturnStatus = EEPROM_SUCCESS;
+            }
+            else {
+                semDelete(EEPROM_FlushSemId);
+                ReturnStatus = EEPROM_ERROR;
+            }
+        }
+        else {
+            ReturnStatus = EEPROM_SEM_ERROR;
+        }
+    }
+    else {
+        ReturnStatus = EEPROM_ERROR;
+    }
+
+    return(ReturnStatus);
+
+} /* End of EEPROM_PageWindowStartFlushTask() */
+
+/* Sets the function that is called each time all of the flushes that have been requested are programmed, or NULL for none */
+void EEPROM_PageWindowSetFlushCallback(EEPROM_FlushCallback_t Callback)
+{
+    semTake(EEPROM_semId, WAIT_FOREVER);
+    EEPROM_FlushCallback = Callback;
+    semGive(EEPROM_semId);
+
+} /* End of EEPROM_PageWindowSetFlushCallback() */
+
+/* Returns the number of flushes that have been requested, so the last flush requested is complete once the flush callback has
+ * been passed this count or more */
+uint32 EEPROM_PageWindowGetFlushCount(void)
+{
+    uint32      FlushCount;
+
+    semTake(EEPROM_semId, WAIT_FOREVER);
+    FlushCount = EEPROM_FlushRequests;
+    semGive(EEPROM_semId);
+
+    return(FlushCount);
+
+} /* End of EEPROM_PageWindowGetFlushCount() */
+
+/* Programs the page windows in the flush queue one at a time, holding the page window lock only while each is programmed */
+void EEPROM_PageWindowFlushTask(void)
+{
+    uint32      i;
 
-    if (EEPROM_PageWindow.Loaded == TRUE) {
+    for (;;) {
 
+        semTake(EEPROM_FlushSemId, WAIT_FOREVER);
         semTake(EEPROM_semId, WAIT_FOREVER);
-        LRO_Write_EEPROM(&EEPROM_PageWindow.Buffer, (EEPROM_PageWindow.LowerAddress - EEPROM_START_ADDR), EEPROM_PageWindow.BufferSize);
-
-        /* read back verify - used for debugging */
-/*        LRO_Read_EEPROM(&ReadBackBuffer, (EEPROM_PageWindow.LowerAddress - EEPROM_START_ADDR), EEPROM_PageWindow.BufferSize); */
-/*        for (i=0; i < EEPROM_PageWindow.BufferSize; i++) { */
-/*            if (EEPROM_PageWindow.Buffer[i] != ReadBackBuffer[i]) { */
-/*                printf("EEPROM VERIFY ERROR: Addr = 0x%lx\n", (uint32)(EEPROM_PageWindow.LowerAddress + i)); */
-/*                break; */
-/*            } */
-/*        } */
-
-        EEPROM_PageWindow.Loaded = FALSE;
+        if (EEPROM_FlushQueueCount > 0) {
+
+            i = EEPROM_FlushQueue[EEPROM_FlushQueueHead];
+            EEPROM_FlushQueueHead = (EEPROM_FlushQueueHead + 1) % EEPROM_PAGE_WINDOW_COUNT;
+            EEPROM_FlushQueueCount--;
+            EEPROM_PageWindow[i].Queued = FALSE;
+
+            /* The window may have been programmed when it or a later window was evicted or written */
+            if ((EEPROM_PageWindow[i].Loaded == TRUE) && (EEPROM_PageWindow[i].Dirty == TRUE)) {
+                EEPROM_PageWindowProgramInOrder(&EEPROM_PageWindow[i]);
+                EEPROM_PageWindowStats.BackgroundFlushes++;
+            }
+            if (EEPROM_FlushQueueCount == 0) {
+                EEPROM_PageWindowFlushComplete();
+            }
+        }
         semGive(EEPROM_semId);
     }
-    
-} /* End of EEPROM_PageWindowFlush() */
 
-/* Copy data from eeprom into the page window buffer */
-void EEPROM_PageWindowLoad(uint32 MemoryAddress)
+} /* End of EEPROM_PageWindowFlushTask() */
+
+/* Called with the page window lock held when no page windows are queued, so every flush that has been requested has been
+ * programmed.  Calls the flush callback once for each time this happens. */
+void EEPROM_PageWindowFlushComplete(void)
 {
-    EEPROM_PageWindow.Loaded = TRUE;
-   
-    EEPROM_PageWindow.LowerAddress = (MemoryAddress & EEPROM_PAGE_WINDOW_MASK);
-    if (EEPROM_PageWindow.LowerAddress < EEPROM_START_ADDR) {
-        EEPROM_PageWindow.LowerAddress = EEPROM_START_ADDR;
+    if (EEPROM_FlushesCompleted != EEPROM_FlushRequests) {
+        EEPROM_FlushesCompleted = EEPROM_FlushRequests;
+        if (EEPROM_FlushCallback != NULL) {
+            (*EEPROM_FlushCallback)(EEPROM_FlushesCompleted);
+        }
     }
-    
-    EEPROM_PageWindow.UpperAddress = (EEPROM_PageWindow.LowerAddress + EEPROM_PAGE_WINDOW_SIZE - 1);
-    if (EEPROM_PageWindow.UpperAddress > EEPROM_END_ADDR) {
-        EEPROM_PageWindow.UpperAddress = EEPROM_END_ADDR;
+
+} /* End of EEPROM_PageWindowFlushComplete() */
+
+/* Copies Length bytes from Src into a page window buffer at Offset and marks the window dirty.  If another window has been
+ * changed since this one was first changed, this window is programmed first so the write reaches eeprom after the writes
+ * to that window, see Write Ordering. */
+void EEPROM_PageWindowModify(EEPROM_PageWindow_t *PageWindow, uint32 Offset, void *Src, uint32 Length)
+{
+    if ((PageWindow->Dirty == TRUE) && (PageWindow->DirtySequence != (EEPROM_DirtySequence - 1))) {
+        EEPROM_PageWindowProgramInOrder(PageWindow);
+        EEPROM_PageWindowStats.OrderedPrograms++;
     }
 
-    EEPROM_PageWindow.BufferSize = (EEPROM_PageWindow.UpperAddress - EEPROM_PageWindow.LowerAddress + 1);
+    memcpy(&PageWindow->Buffer[Offset], Src, Length);
+    if (PageWindow->Dirty == FALSE) {
+        PageWindow->DirtySequence = EEPROM_DirtySequence++;
+        PageWindow->Dirty = TRUE;
+    }
+
+} /* End of EEPROM_PageWindowModify() */
+
+/* Programs a dirty page window after every window that was changed before it, oldest first, see Write Ordering */
+void EEPROM_PageWindowProgramInOrder(EEPROM_PageWindow_t *PageWindow)
+{
+    EEPROM_PageWindow_t    *Oldest;
+    uint32                  i;
+
+    while (PageWindow->Dirty == TRUE) {
+
+        /* The sequence numbers are compared as a difference so they can wrap */
+        Oldest = PageWindow;
+        for (i=0; i < EEPROM_PAGE_WINDOW_COUNT; i++) {
+            if ((EEPROM_PageWindow[i].Loaded == TRUE) && (EEPROM_PageWindow[i].Dirty == TRUE) &&
+                ((int32)(EEPROM_PageWindow[i].DirtySequence - Oldest->DirtySequence) < 0)) {
+                Oldest = &EEPROM_PageWindow[i];
+            }
+        }
+        EEPROM_PageWindowProgram(Oldest);
+    }
+
+} /* End of EEPROM_PageWindowProgramInOrder() */
+
+/* Write data from a page window buffer into eeprom, reading the bytes of the page that have not been written first */
+void EEPROM_PageWindowProgram(EEPROM_PageWindow_t *PageWindow)
+{
+    uint32      Crc;
+    uint32      Retries;
+    uint32      Verified;
+
+    EEPROM_PageWindowFill(PageWindow, 0, PageWindow->BufferSize);
+    LRO_Write_EEPROM(&PageWindow->Buffer, (PageWindow->LowerAddress - EEPROM_START_ADDR), PageWindow->BufferSize);
+
+    /* read back verify, see Read Back Verify */
+    if (EEPROM_PageWindowOptions & EEPROM_OPTION_VERIFY) {
+
+        Crc = EEPROM_Crc(0xFFFFFFFF, PageWindow->Buffer, PageWindow->BufferSize);
+        Verified = EEPROM_PageWindowVerify(PageWindow, Crc);
+        for (Retries=0; (Verified == FALSE) && (Retries < EEPROM_VERIFY_RETRIES); Retries++) {
+            LRO_Write_EEPROM(&PageWindow->Buffer, (PageWindow->LowerAddress - EEPROM_START_ADDR), PageWindow->BufferSize);
+            EEPROM_PageWindowStats.VerifyRetries++;
+            Verified = EEPROM_PageWindowVerify(PageWindow, Crc);
+        }
+
+        if (Verified == TRUE) {
+            EEPROM_PageWindowStats.PagesVerified++;
+        }
+        else {
+            EEPROM_PageWindowStats.VerifyFailures++;
+        }
+    }
+
+    PageWindow->Dirty = FALSE;
+    PageWindow->Written = FALSE;
+    EEPROM_PageWindowStats.Flushes++;
+
+} /* End of EEPROM_PageWindowProgram() */
+
+/* Reads the page of a page window back from eeprom a chunk at a time and returns TRUE if the CRC of what was read matches
+ * Crc, the CRC of the window buffer */
+uint32 EEPROM_PageWindowVerify(EEPROM_PageWindow_t *PageWindow, uint32 Crc)
+{
+    uint8       ReadBackBuffer[EEPROM_VERIFY_CHUNK_SIZE];
+    uint32      ReadBackCrc = 0xFFFFFFFF;
+    uint32      Offset;
+    uint32      Length;
+
+    for (Offset=0; Offset < PageWindow->BufferSize; Offset += Length) {
+        Length = PageWindow->BufferSize - Offset;
+        if (Length > EEPROM_VERIFY_CHUNK_SIZE) {
+            Length = EEPROM_VERIFY_CHUNK_SIZE;
+        }
+        LRO_Read_EEPROM(ReadBackBuffer, (PageWindow->LowerAddress + Offset - EEPROM_START_ADDR), Length);
+        ReadBackCrc = EEPROM_Crc(ReadBackCrc, ReadBackBuffer, Length);
+    }
+
+    return((ReadBackCrc == Crc) ? TRUE : FALSE);
+
+} /* End of EEPROM_PageWindowVerify() */
+
+/* Continues a CRC-32 over Size bytes of Buffer.  Start with Crc equal to 0xFFFFFFFF. */
+uint32 EEPROM_Crc(uint32 Crc, uint8 *Buffer, uint32 Size)
+{
+    uint32      i;
+
+    for (i=0; i < Size; i++) {
+        Crc = EEPROM_CrcTable[(Crc ^ Buffer[i]) & 0xFF] ^ (Crc >> 8);
+    }
+
+    return(Crc);
+
+} /* End of EEPROM_Crc() */
+
+/* Assigns a page window to the page that contains MemoryAddress.  Nothing is read from eeprom here, the bytes that are not
+ * written are read by EEPROM_PageWindowFill() when they are needed, so a page that is completely overwritten is never read. */
+void EEPROM_PageWindowLoad(EEPROM_PageWindow_t *PageWindow, uint32 MemoryAddress)
+{
+    PageWindow->Loaded = TRUE;
+    PageWindow->Dirty = FALSE;
+    PageWindow->Written = FALSE;
+    PageWindow->ValidBytes = 0;
+    memset(PageWindow->Valid, 0, sizeof(PageWindow->Valid));
+
+    PageWindow->LowerAddress = (MemoryAddress & EEPROM_PAGE_WINDOW_MASK);
+    if (PageWindow->LowerAddress < EEPROM_START_ADDR) {
+        PageWindow->LowerAddress = EEPROM_START_ADDR;
+    }
+
+    PageWindow->UpperAddress = (PageWindow->LowerAddress + EEPROM_PAGE_WINDOW_SIZE - 1);
+    if (PageWindow->UpperAddress > EEPROM_END_ADDR) {
+        PageWindow->UpperAddress = EEPROM_END_ADDR;
+    }
+
+    PageWindow->BufferSize = (PageWindow->UpperAddress - PageWindow->LowerAddress + 1);
 
-    LRO_Read_EEPROM(&EEPROM_PageWindow.Buffer, (EEPROM_PageWindow.LowerAddress - EEPROM_START_ADDR), EEPROM_PageWindow.BufferSize);
-    
 } /* End of EEPROM_PageWindowLoad() */
 
+/* Marks Length bytes of a page window buffer starting at Offset as valid.  Whole words of the mask are set at once. */
+void EEPROM_PageWindowSetValid(EEPROM_PageWindow_t *PageWindow, uint32 Offset, uint32 Length)
+{
+    uint32      Word;
+    uint32      Bits;
+    uint32      NewBits;
+    uint32      Count;
+
+    while ((Length > 0) && (PageWindow->ValidBytes < PageWindow->BufferSize)) {
+
+        Word = Offset / 32;
+        Count = 32 - (Offset % 32);
+        if (Count > Length) {
+            Count = Length;
+        }
+        Bits = (Count == 32) ? 0xFFFFFFFF : (((uint32)1 << Count) - 1) << (Offset % 32);
+
+        /* Count the bits that were not already set */
+        NewBits = Bits & ~PageWindow->Valid[Word];
+        if (NewBits == Bits) {
+            PageWindow->ValidBytes += Count;
+        }
+        else {
+            while (NewBits != 0) {
+                NewBits &= (NewBits - 1);
+                PageWindow->ValidBytes++;
+            }
+        }
+        PageWindow->Valid[Word] |= Bits;
+
+        Offset += Count;
+        Length -= Count;
+    }
+
+} /* End of EEPROM_PageWindowSetValid() */
+
+/* Reads the bytes from Offset to Offset + Length of a page window buffer that have not been written from eeprom, one read for
+ * each run of those bytes, and marks them valid */
+void EEPROM_PageWindowFill(EEPROM_PageWindow_t *PageWindow, uint32 Offset, uint32 Length)
+{
+    uint32      EndOffset;
+    uint32      RunStart;
+
+    if (PageWindow->ValidBytes < PageWindow->BufferSize) {
+
+        EndOffset = Offset + Length;
+        while (Offset < EndOffset) {
+
+            /* Skip the valid bytes, a whole word of the mask at a time when possible */
+            if (((Offset % 32) == 0) && ((EndOffset - Offset) >= 32) && (PageWindow->Valid[Offset / 32] == 0xFFFFFFFF)) {
+                Offset += 32;
+            }
+            else if (PageWindow->Valid[Offset / 32] & ((uint32)1 << (Offset % 32))) {
+                Offset++;
+            }
+            else {
+                RunStart = Offset;
+                while ((Offset < EndOffset) &&
+                       ((PageWindow->Valid[Offset / 32] & ((uint32)1 << (Offset % 32))) == 0)) {
+                    Offset++;
+                }
+                LRO_Read_EEPROM(&PageWindow->Buffer[RunStart], (PageWindow->LowerAddress + RunStart - EEPROM_START_ADDR), (Offset - RunStart));
+                EEPROM_PageWindowStats.BytesFilled += (Offset - RunStart);
+            }
+        }
+
+        EEPROM_PageWindowSetValid(PageWindow, (EndOffset - Length), Length);
+    }
+
+} /* End of EEPROM_PageWindowFill() */
+
+/* Returns the page window counters in Stats, and clears them if Reset is TRUE */
+void EEPROM_PageWindowGetStats(EEPROM_PageWindowStats_t *Stats, uint8 Reset)
+{
+    semTake(EEPROM_semId, WAIT_FOREVER);
+    if (Stats != NULL) {
+        memcpy(Stats, &EEPROM_PageWindowStats, sizeof(EEPROM_PageWindowStats_t));
+    }
+    if (Reset == TRUE) {
+        memset(&EEPROM_PageWindowStats, 0, sizeof(EEPROM_PageWindowStats_t));
+    }
+    semGive(EEPROM_semId);
+
+} /* End of EEPROM_PageWindowGetStats() */
+
+/* Sets the page window options, see Differential Writes */
+void EEPROM_PageWindowSetOptions(uint32 Options)
+{
+    semTake(EEPROM_semId, WAIT_FOREVER);
+    EEPROM_PageWindowOptions = Options;
+    semGive(EEPROM_semId);
+
+} /* End of EEPROM_PageWindowSetOptions() */
+
 /* Make sure the address range is in eeprom and does not span banks */
 uint8 EEPROM_IsValidAddressRange(uint32 Address, uint32 Size)
 {
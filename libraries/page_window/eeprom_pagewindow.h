@@ -15,6 +15,65 @@
  *
  * Design Notes:
  *
+ * Page Window Cache:
+ *   Writes to EEPROM are collected in a set of EEPROM_PAGE_WINDOW_COUNT page windows, each a ram copy of one
+ *   EEPROM_PAGE_WINDOW_SIZE page.  A write to a page that is already in a window only changes the window.  A write to any
+ *   other page loads it into a free window, or into the least recently used window, which is programmed first if it is
+ *   dirty.  EEPROM_PageWindowFlush() programs every dirty window, so writes that keep going to the page that was changed
+ *   last, such as a sequential write of file data, program that page only once.  Write Ordering limits this for EEFS: it
+ *   writes a File Allocation Table entry, then a File Header, then the File Allocation Table header, so the File Allocation
+ *   Table page is changed again after the File Header page and has to be programmed early.  An EEFS operation that updates a
+ *   File Header and a File Allocation Table entry in page 0 therefore still costs 3 programs (page 0, the File Header page,
+ *   page 0 again), the same as with a single window.  Windows stay loaded after they are programmed, so EEPROM must only be
+ *   written through this library.  EEPROM_PageWindowGetStats() returns the number of writes that found their page in a
+ *   window (hits), the number that had to load it (misses), the number of pages programmed (flushes) and the number of those
+ *   that were programmed to make room for another page (evictions).  Writes are split into spans that end on a page boundary
+ *   and each span is copied into its window with a single memcpy.  A page is not read from EEPROM when it is loaded into a
+ *   window.  Instead each window has a mask of the bytes that have been written, and only the bytes that have not are read,
+ *   in runs, just before the page is programmed, and a read through the window only reads the bytes it asked for.  A page
+ *   that is completely overwritten, as by a large sequential write, is never read.  EEPROM_PageWindowRead() copies pages
+ *   that are in a window from the window and reads the rest from EEPROM, so defining EEFS_LIB_EEPROM_READ as
+ *   EEPROM_PageWindowRead() also returns data that has not been flushed yet.
+ *
+ * Differential Writes:
+ *   When EEPROM_OPTION_DIFFERENTIAL is set with EEPROM_PageWindowSetOptions() each write span is compared with the contents of
+ *   its page, which are read from EEPROM first if they are not already in the window.  A span that matches does not change
+ *   the window, and a page whose spans all matched is not programmed at all.  This trades a read of the written bytes for
+ *   the program of a page, which pays off when tables are rewritten with mostly the same contents.  The ProgramsAvoided
+ *   counter is the number of pages that were written but did not have to be programmed.
+ *
+ * Asynchronous Flushes:
+ *   Programming a page takes milliseconds, so by default EEPROM_PageWindowFlush() blocks its caller for as long as it takes
+ *   to program every dirty window.  Once EEPROM_PageWindowStartFlushTask() has been called EEPROM_PageWindowFlush() only
+ *   queues the dirty windows and returns, and a flush task programs them in the background.  The queue is bounded since each
+ *   window is queued at most once.  Writes to a queued window are still allowed and are programmed with it unless that would
+ *   change the order of the writes, and a queued window that is evicted is programmed right away as before.  The flush task
+ *   programs the queued windows in the order they were changed, see Write Ordering.  EEPROM_PageWindowSync() programs
+ *   everything that is dirty or queued before it returns, so it is the barrier for callers that need their data in EEPROM,
+ *   and it is what EEFS_LIB_EEPROM_SYNC should be defined as.  A function set with EEPROM_PageWindowSetFlushCallback() is
+ *   called, with the page window lock held, each time everything that has been flushed is in EEPROM.  It is passed the
+ *   number of flushes requested so far, so a caller can tell whether its own flush, numbered by
+ *   EEPROM_PageWindowGetFlushCount(), is done.
+ *
+ * Write Ordering:
+ *   EEFS depends on the order of its writes reaching EEPROM for crash safety, for example a File Allocation Table entry is
+ *   written before its File Header, the File Allocation Table header last and a compaction journal before its magic word, so
+ *   the page windows keep the order of the writes across pages.  Pages are therefore programmed in the order their windows
+ *   were first changed after they were loaded or last programmed, which is kept in the DirtySequence of each window.  Every
+ *   page that is programmed, when it is evicted, flushed, synced or by the flush task, is programmed after every window that
+ *   was changed before it.  A write to a dirty window that is not the last window changed would put a write after a write to
+ *   a later window, so that window is programmed first, along with every window changed before it, and the OrderedPrograms
+ *   counter is incremented.  A reset can then only lose the most recent writes.  Writes that keep going to the same page,
+ *   such as a sequential write, never program early.
+ *
+ * Read Back Verify:
+ *   When EEPROM_OPTION_VERIFY is set with EEPROM_PageWindowSetOptions() each page is read back after it is programmed.  A
+ *   CRC-32 of the window buffer is compared with a CRC-32 of the read back, which is read EEPROM_VERIFY_CHUNK_SIZE bytes at a
+ *   time so no second page sized buffer is needed.  A page that does not match is programmed again up to
+ *   EEPROM_VERIFY_RETRIES times.  The PagesVerified, VerifyRetries and VerifyFailures counters report the results, so a
+ *   caller that needs to know whether its data was programmed correctly checks VerifyFailures with
+ *   EEPROM_PageWindowGetStats() after EEPROM_PageWindowSync().
+ *
  * References:
  *
  */
@@ -35,8 +94,9 @@
 #define EEPROM_BANK1                1
 #define EEPROM_BANK2                2
 
-#define EEPROM_PAGE_WINDOW_SIZE     1024 /* should divide evenly with eeprom size and matches the hardware page window size */
+#define EEPROM_PAGE_WINDOW_SIZE     1024 /* should divide evenly with eeprom size, be a multiple of 32 and match the hardware page window size */
 #define EEPROM_PAGE_WINDOW_MASK     (~((uint32)(EEPROM_PAGE_WINDOW_SIZE - 1)))
+#define EEPROM_PAGE_WINDOW_COUNT    4    /* number of pages that can be held in ram before the least recently used is programmed */
 
 #define EEPROM_SIZE                 0x400000
 #define EEPROM_START_ADDR           0x03400000
@@ -50,6 +110,15 @@
 #define EEPROM_BANK2_START_ADDR     0x03600000
 #define EEPROM_BANK2_END_ADDR       EEPROM_BANK2_START_ADDR + EEPROM_BANK2_SIZE - 1
 
+#define EEPROM_FLUSH_TASK_STACK_SIZE 4096
+
+#define EEPROM_VERIFY_CHUNK_SIZE    128     /* bytes read back from eeprom at a time, see Read Back Verify */
+#define EEPROM_VERIFY_RETRIES       2       /* times a page is programmed again if it does not verify */
+
+/* Page Window Options */
+#define EEPROM_OPTION_DIFFERENTIAL  0x00000001 /* only program pages whose contents change, see Differential Writes */
+#define EEPROM_OPTION_VERIFY        0x00000002 /* read back and check each page that is programmed, see Read Back Verify */
+
 /* Error Codes */
 #define EEPROM_SUCCESS              0
 #define EEPROM_ERROR               -1
@@ -63,19 +132,50 @@
 
 typedef struct {
     uint32          Loaded;
+    uint32          Dirty;          /* TRUE if the buffer has been changed since the page was loaded or programmed */
+    uint32          Written;        /* TRUE if the page has been written since it was loaded or programmed, changed or not */
+    uint32          Queued;         /* TRUE if the window is in the flush queue, see Asynchronous Flushes */
+    uint32          DirtySequence;  /* when the window was first changed, see Write Ordering */
+    uint32          LastUsed;       /* value of the use counter when the window was last written, see Page Window Cache */
     uint32          LowerAddress;
     uint32          UpperAddress;
     uint32          BufferSize;
+    uint32          ValidBytes;     /* number of bytes of the buffer that have been written or read from eeprom */
+    uint32          Valid[EEPROM_PAGE_WINDOW_SIZE / 32]; /* one bit for each byte of the buffer that is valid */
     uint8           Buffer[EEPROM_PAGE_WINDOW_SIZE];
 } EEPROM_PageWindow_t;
 
+typedef struct {
+    uint32          Hits;           /* writes to a page that was already in a window */
+    uint32          Misses;         /* writes that loaded their page into a window */
+    uint32          Flushes;        /* pages programmed */
+    uint32          Evictions;      /* pages programmed to make room for another page */
+    uint32          BytesFilled;    /* bytes read from eeprom to complete partly written pages */
+    uint32          ProgramsAvoided; /* pages that were written but not programmed since their contents did not change */
+    uint32          BackgroundFlushes; /* pages programmed by the flush task */
+    uint32          OrderedPrograms; /* pages programmed before a write so the writes reach eeprom in order, see Write Ordering */
+    uint32          PagesVerified;  /* pages whose read back matched, see Read Back Verify */
+    uint32          VerifyRetries;  /* pages programmed again because their read back did not match */
+    uint32          VerifyFailures; /* pages that did not match after EEPROM_VERIFY_RETRIES retries */
+} EEPROM_PageWindowStats_t;
+
+/* Called each time all of the flushes that have been requested are programmed, see Asynchronous Flushes */
+typedef void (*EEPROM_FlushCallback_t)(uint32 FlushCount);
+
 /*
  * Exported Functions
  */
 
 int32 EEPROM_PageWindowInit(void);
 int32 EEPROM_PageWindowWrite(void *Dest, void *Src, uint32 Size);
+int32 EEPROM_PageWindowRead(void *Dest, void *Src, uint32 Size);
 void  EEPROM_PageWindowFlush(void);
+void  EEPROM_PageWindowSync(void);
+int32 EEPROM_PageWindowStartFlushTask(int Priority);
+void  EEPROM_PageWindowSetFlushCallback(EEPROM_FlushCallback_t Callback);
+uint32 EEPROM_PageWindowGetFlushCount(void);
+void  EEPROM_PageWindowGetStats(EEPROM_PageWindowStats_t *Stats, uint8 Reset);
+void  EEPROM_PageWindowSetOptions(uint32 Options);
 uint8 EEPROM_IsValidAddressRange(uint32 Address, uint32 Size);
 uint8 EEPROM_IsWriteProtected(uint32 Address);
 
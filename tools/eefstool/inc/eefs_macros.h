@@ -27,9 +27,22 @@ extern void *eefstool_copy_to_device(void *dest, const void *src, size_t n);
 #define EEFS_LIB_EEPROM_WRITE(Dest, Src, Length) eefstool_copy_to_device(Dest, Src, Length) 
 #define EEFS_LIB_EEPROM_READ(Dest, Src, Length)  eefstool_copy_from_device(Dest, Src, Length) 
 #define EEFS_LIB_EEPROM_FLUSH                    eefstool_flush_device()
+#define EEFS_LIB_EEPROM_SYNC                     eefstool_flush_device()
 #define EEFS_LIB_LOCK                            eefstool_lock()
 #define EEFS_LIB_UNLOCK eefstool_unlock()
 
+/*
+**  The tool is single threaded, so the per volume and per file descriptor locks are not used
+*/
+#define EEFS_LIB_INODE_LOCK_CREATE(InodeTable)
+#define EEFS_LIB_INODE_LOCK_DELETE(InodeTable)
+#define EEFS_LIB_INODE_LOCK(InodeTable)
+#define EEFS_LIB_INODE_UNLOCK(InodeTable)
+#define EEFS_LIB_FD_LOCK_CREATE(FileDescriptor)
+#define EEFS_LIB_FD_LOCK_DELETE(FileDescriptor)
+#define EEFS_LIB_FD_LOCK(FileDescriptor)
+#define EEFS_LIB_FD_UNLOCK(FileDescriptor)
+
 /*
 **  This macro defines the time interface function.  Defaults to time(NULL) 
 */
@@ -26,5 +26,6 @@ void    EEFS_SwapFileHeader(EEFS_FileHeader_t *FileHeader);
 void    EEFS_SwapFileAllocationTable(EEFS_FileAllocationTable_t *FileAllocationTable);
 void    EEFS_SwapFileAllocationTableEntry(EEFS_FileAllocationTableEntry_t *FileAllocationTableEntry); 
 void    EEFS_SwapFileAllocationTableHeader(EEFS_FileAllocationTableHeader_t *FileAllocationTableHeader); 
+void    EEFS_SwapCompactJournal(EEFS_CompactJournal_t *Journal);
 
 #endif
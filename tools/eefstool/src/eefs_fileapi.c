@@ -25,6 +25,7 @@
 #include "eefs_fileapi.h"
 #include "eefs_macros.h"
 #include <string.h>
+#include <stddef.h>
 #include <math.h>
 #include "eefs_swap.h"
 
@@ -36,6 +37,9 @@
 #define EEFS_MIN(x,y) (((x) < (y)) ? (x) : (y))
 #define EEFS_ROUND_UP(x, align)	(((int) (x) + (align - 1)) & ~(align - 1))
 
+/* The ReservedBytes of a file creat when the size of the new file is not known */
+#define EEFS_UNKNOWN_FILE_SIZE  0xFFFFFFFF
+
 /*
  * Local Data
  */
@@ -54,7 +58,7 @@ EEFS_DirectoryEntry_t           EEFS_DirectoryEntry;
  */
 
 int32                           EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 Flags, uint32 Attributes);
-int32                           EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes);
+int32                           EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes);
 uint32                          EEFS_LibFmode(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
 int32                           EEFS_LibFindFile(EEFS_InodeTable_t *InodeTable, char *Filename);
 int32                           EEFS_LibGetFileDescriptor(void);
@@ -62,6 +66,31 @@ int32                           EEFS_LibFreeFileDescriptor(int32 FileDescriptor)
 uint8                           EEFS_LibIsValidFileDescriptor(int32 FileDescriptor);
 uint8                           EEFS_LibHasOpenCreat(EEFS_InodeTable_t *InodeTable);
 uint8                           EEFS_LibIsValidFilename(char *Filename);
+void                            EEFS_LibFillDirectoryEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_DirectoryEntry_t *DirectoryEntry);
+void                            EEFS_LibReadFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader);
+void                            EEFS_LibWriteFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader);
+void                            EEFS_LibWriteFileAllocationTableHeader(EEFS_InodeTable_t *InodeTable);
+void                            EEFS_LibWriteFileAllocationTableEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+uint8                           EEFS_LibHasNextExtent(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex);
+int32                           EEFS_LibNextSlot(EEFS_InodeTable_t *InodeTable, void *Address);
+int32                           EEFS_LibFindSlot(EEFS_InodeTable_t *InodeTable, void *Address);
+int32                           EEFS_LibFindSlotEnd(EEFS_InodeTable_t *InodeTable, void *Address);
+int32                           EEFS_LibFindEmptySlot(EEFS_InodeTable_t *InodeTable);
+void                            EEFS_LibMoveEmptySlot(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, void *FileHeaderPointer, EEFS_FileHeader_t *FileHeader);
+int32                           EEFS_LibRelocateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 NewMaxFileSize, uint32 BytesToCopy);
+int32                           EEFS_LibFtruncateFile(int32 FileDescriptor, uint32 Length, uint8 ReleaseSpace);
+void                            EEFS_LibTruncateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Length, uint8 ReleaseSpace);
+uint32                          EEFS_LibSpareBytes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 FileSize, uint32 PreviousMaxFileSize);
+void                            EEFS_LibAddToSpareHistory(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, char *Filename);
+uint32                          EEFS_LibTakeFromSpareHistory(EEFS_InodeTable_t *InodeTable, char *Filename);
+void                            EEFS_LibFillSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo);
+int32                           EEFS_LibFillSlotGaps(EEFS_InodeTable_t *InodeTable);
+int32                           EEFS_LibTrimFreeMemory(EEFS_InodeTable_t *InodeTable);
+int32                           EEFS_LibCompactStep(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToWrite);
+int32                           EEFS_LibCommitCompactJournal(EEFS_InodeTable_t *InodeTable, EEFS_CompactJournal_t *Journal);
+void                            EEFS_LibApplyCompactJournal(uint32 BaseAddress, EEFS_CompactJournal_t *JournalPointer, EEFS_CompactJournal_t *Journal);
+void                            EEFS_LibWriteCompactJournalField(EEFS_CompactJournal_t *JournalPointer, EEFS_CompactJournal_t *Journal, uint32 FieldOffset, uint32 FieldSize);
+void                            EEFS_LibRecoverCompactJournal(uint32 BaseAddress, EEFS_FileAllocationTableHeader_t *FileAllocationTableHeader);
 
 /*
  * Function Definitions
@@ -98,18 +127,29 @@ int32 EEFS_LibInitFS(EEFS_InodeTable_t *InodeTable, uint32 BaseAddress)
             (FileAllocationTableHeader.Version == 1) &&
             (FileAllocationTableHeader.NumberOfFiles <= EEFS_MAX_FILES)) {
 
+            /* Complete a compaction step that was interrupted by a reset before the File Allocation Table is loaded */
+            EEFS_LibRecoverCompactJournal(BaseAddress, &FileAllocationTableHeader);
+
             /* Initialize the Inode Table */
             memset(InodeTable, 0, sizeof(EEFS_InodeTable_t));
             InodeTable->BaseAddress = BaseAddress;
             InodeTable->FreeMemoryPointer = (void *)(InodeTable->BaseAddress + FileAllocationTableHeader.FreeMemoryOffset);
             InodeTable->FreeMemorySize = FileAllocationTableHeader.FreeMemorySize;
             InodeTable->NumberOfFiles = FileAllocationTableHeader.NumberOfFiles;
+            InodeTable->SparePolicy.Policy = EEFS_SPARE_POLICY_FIXED;
+            InodeTable->SparePolicy.Parameter = EEFS_DEFAULT_CREAT_SPARE_BYTES;
             for (i=0; i < InodeTable->NumberOfFiles; i++) {
                 EEFS_LIB_EEPROM_READ(&FileAllocationTableEntry, &FileAllocationTable->File[i], sizeof(EEFS_FileAllocationTableEntry_t));
                 EEFS_SwapFileAllocationTableEntry(&FileAllocationTableEntry); /* APC */
                 InodeTable->File[i].FileHeaderPointer = (void *)(BaseAddress + FileAllocationTableEntry.FileHeaderOffset);
                 InodeTable->File[i].MaxFileSize = FileAllocationTableEntry.MaxFileSize;
             }
+
+            /* Recover any space left behind by a compaction step or a file creat that was interrupted by a reset */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+                EEFS_LibFillSlotGaps(InodeTable);
+                EEFS_LibTrimFreeMemory(InodeTable);
+            }
             ReturnCode = EEFS_SUCCESS;
         }
         else { /* invalid file allocation table */
@@ -172,7 +212,7 @@ int32 EEFS_LibOpen(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Flags,
             }
             else if (Flags & O_CREAT) {
             
-                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, EEFS_ATTRIBUTE_NONE);
+                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, EEFS_UNKNOWN_FILE_SIZE, EEFS_ATTRIBUTE_NONE);
             }           
             else { /* file not found */
             
@@ -216,7 +256,7 @@ int32 EEFS_LibCreat(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attrib
             }
             else {
 
-                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, Attributes);
+                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, EEFS_UNKNOWN_FILE_SIZE, Attributes);
             }
         }
         else { /* filename too long */
@@ -232,6 +272,43 @@ int32 EEFS_LibCreat(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attrib
     
 } /* End of EEFS_LibCreat() */
 
+/* Creates a new file of an expected size and opens it for writing.  A slot of exactly ReservedBytes bytes is reserved in free
+ * memory, so other files can be created while the new file is open.  Deleted slots are not reused by this implementation.
+ * Returns a file descriptor on success, EEFS_NO_FREE_FILE_DESCRIPTOR, EEFS_PERMISSION_DENIED, EEFS_INVALID_ARGUMENT, or
+ * EEFS_NO_SPACE_LEFT_ON_DEVICE on error.*/
+int32 EEFS_LibCreatSized(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes)
+{
+    int32                               InodeIndex;
+    int32                               ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (InodeTable != NULL) {
+
+        if (EEFS_LibIsValidFilename(Filename)) {
+
+            /* If the file already exists then open it for write access otherwise create a new file */
+            if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                ReturnCode = EEFS_LibOpenFile(InodeTable, InodeIndex, (O_WRONLY | O_TRUNC), Attributes);
+            }
+            else {
+
+                ReturnCode = EEFS_LibCreatFile(InodeTable, Filename, ReservedBytes, Attributes);
+            }
+        }
+        else { /* filename too long */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibCreatSized() */
+
 /* Internal function to open a file. */
 int32 EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 Flags, uint32 Attributes)
 {
@@ -310,10 +387,14 @@ int32 EEFS_LibOpenFile(EEFS_InodeTable_t *InodeTable, int32 InodeIndex, uint32 F
     
 } /* End of EEFS_LibOpenFile() */
 
-/* Internal function to create a new file */
-int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
+/* Internal function to create a new file.  A file of unknown size is given all of free memory until it is closed, otherwise
+ * a slot of ReservedBytes bytes is reserved in free memory. */
+int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 ReservedBytes, uint32 Attributes)
 {
 
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileAllocationTableHeader_t    FileAllocationTableHeader;
+    EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
     EEFS_FileHeader_t                   FileHeader;
     int32                               InodeIndex;
     int32                               FileDescriptor;
@@ -325,28 +406,37 @@ int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 At
         /* Make sure there is a free slot in the File Allocation Table */
         if (InodeTable->NumberOfFiles < EEFS_MAX_FILES) {
 
-            /* Since we use all available free memory when creating a new file we can only create one new file at
-             * a time */
+            /* Since we use all available free memory when creating a new file of unknown size we can only create one
+             * new file at a time */
             if (EEFS_LibHasOpenCreat(InodeTable) == FALSE) {
 
-                /* Make sure there is enough room in eeprom for at least a file header */
-                if (InodeTable->FreeMemorySize > sizeof(EEFS_FileHeader_t)) {
+                /* Make sure there is enough room in eeprom for at least a file header and the reserved bytes */
+                if ((InodeTable->FreeMemorySize > sizeof(EEFS_FileHeader_t)) &&
+                    ((ReservedBytes == EEFS_UNKNOWN_FILE_SIZE) ||
+                     (ReservedBytes <= (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t))))) {
 
                     if ((Attributes == EEFS_ATTRIBUTE_NONE) || (Attributes == EEFS_ATTRIBUTE_READONLY)) {
 
                         if ((FileDescriptor = EEFS_LibGetFileDescriptor()) != EEFS_NO_FREE_FILE_DESCRIPTOR) {
 
-                            /* Add the new entry to the InodeTable.  Temporarily set the MaxFileSize equal to all free eeprom.
-                             * The FreeMemoryPointer and the FreeMemorySize variables are NOT updated until the file is
-                             * closed and the actual file size is known.  Setting EEFS_FCREAT in the Mode variable
-                             * will prevent any other file creations until the current one is complete and the FreeMemoryPointer 
-                             * and the FreeMemorySize variables are updated. */
+                            /* Add the new entry to the InodeTable.  If the size of the file is not known temporarily set
+                             * the MaxFileSize equal to all free eeprom.  The FreeMemoryPointer and the FreeMemorySize variables
+                             * are NOT updated until the file is closed and the actual file size is known.  Setting EEFS_FCREAT
+                             * in the Mode variable will prevent any other file creations until the current one is complete and
+                             * the FreeMemoryPointer and the FreeMemorySize variables are updated. */
                             InodeIndex = InodeTable->NumberOfFiles;
                             InodeTable->NumberOfFiles++;
                             InodeTable->File[InodeIndex].FileHeaderPointer = InodeTable->FreeMemoryPointer;
-                            InodeTable->File[InodeIndex].MaxFileSize = (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t));
+                            if (ReservedBytes == EEFS_UNKNOWN_FILE_SIZE) {
+                                InodeTable->File[InodeIndex].MaxFileSize = (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t));
+                            }
+                            else {
+                                InodeTable->File[InodeIndex].MaxFileSize = EEFS_MIN((uint32)EEFS_ROUND_UP(ReservedBytes, 4),
+                                                                                    (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t)));
+                            }
 
                             /* Initialize a new File Header and write it to EEPROM*/
+                            memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
                             FileHeader.Crc = 0;    /* Automatically updating the CRC is not supported at this time */
                             FileHeader.InUse = TRUE;
                             FileHeader.Attributes = Attributes;
@@ -354,11 +444,41 @@ int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 At
                             FileHeader.ModificationDate = EEFS_LIB_TIME;
                             FileHeader.CreationDate = FileHeader.ModificationDate;
                             strncpy(FileHeader.Filename, Filename, EEFS_MAX_FILENAME_SIZE);
+                            EEFS_SwapFileHeader(&FileHeader); /* APC */
                             EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
                             EEFS_LIB_EEPROM_FLUSH;
 
+                            /* A reserved slot is added to the File Allocation Table now, so the file is opened for write
+                             * the same as an existing file and does not block other file creations */
+                            if (ReservedBytes != EEFS_UNKNOWN_FILE_SIZE) {
+
+                                InodeTable->FreeMemoryPointer += (sizeof(EEFS_FileHeader_t) + InodeTable->File[InodeIndex].MaxFileSize);
+                                InodeTable->FreeMemorySize -= (sizeof(EEFS_FileHeader_t) + InodeTable->File[InodeIndex].MaxFileSize);
+
+                                FileAllocationTable = (void *)InodeTable->BaseAddress;
+
+                                FileAllocationTableEntry.FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+                                FileAllocationTableEntry.MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                                EEFS_SwapFileAllocationTableEntry(&FileAllocationTableEntry); /* APC */
+                                EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->File[InodeIndex], &FileAllocationTableEntry, sizeof(EEFS_FileAllocationTableEntry_t));
+                                EEFS_LIB_EEPROM_FLUSH;
+
+                                EEFS_LIB_EEPROM_READ(&FileAllocationTableHeader, &FileAllocationTable->Header, sizeof(EEFS_FileAllocationTableHeader_t));
+                                EEFS_SwapFileAllocationTableHeader(&FileAllocationTableHeader);/*APC */
+                                FileAllocationTableHeader.FreeMemoryOffset = (uint32)(InodeTable->FreeMemoryPointer - InodeTable->BaseAddress);
+                                FileAllocationTableHeader.FreeMemorySize = InodeTable->FreeMemorySize;
+                                FileAllocationTableHeader.NumberOfFiles = InodeTable->NumberOfFiles;
+                                EEFS_SwapFileAllocationTableHeader(&FileAllocationTableHeader);/*APC */
+                                EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->Header, &FileAllocationTableHeader, sizeof(EEFS_FileAllocationTableHeader_t));
+                                EEFS_LIB_EEPROM_FLUSH;
+
+                                EEFS_FileDescriptorTable[FileDescriptor].Mode = EEFS_FWRITE;
+                            }
+                            else {
+                                EEFS_FileDescriptorTable[FileDescriptor].Mode = (EEFS_FCREAT | EEFS_FWRITE);
+                            }
+
                             /* Initialize the File Descriptor */
-                            EEFS_FileDescriptorTable[FileDescriptor].Mode = (EEFS_FCREAT | EEFS_FWRITE);
                             EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
                             EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
                             EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = 0;
@@ -399,7 +519,7 @@ int32 EEFS_LibCreatFile(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 At
 } /* End of EEFS_LibCreatFile() */
 
 /* Closes a file.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error.  If a new file is being created then the
- * MaxFileSize is updated to be the actual size of the file + EEFS_DEFAULT_CREAT_SPARE_BYTES. Note that the File Allocation
+ * MaxFileSize is updated to be the actual size of the file + the spare bytes given by the spare byte policy of the volume. Note that the File Allocation
  * Table is not updated until the file is closed to reduce the number of EEPROM Writes. */
 int32 EEFS_LibClose(int32 FileDescriptor)
 {
@@ -408,6 +528,8 @@ int32 EEFS_LibClose(int32 FileDescriptor)
     EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
     EEFS_FileHeader_t                   FileHeader;
     uint32                              MaxFileSize;
+    uint32                              PreviousMaxFileSize;
+    uint32                              SpareBytes;
     EEFS_InodeTable_t                  *InodeTable;
     uint32                              InodeIndex;
     int32                               ReturnCode;
@@ -422,20 +544,29 @@ int32 EEFS_LibClose(int32 FileDescriptor)
             InodeTable = EEFS_FileDescriptorTable[FileDescriptor].InodeTable;
             InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
 
-            /* Calculate the New MaxFileSize and round it up to a 4 byte boundary */
-            MaxFileSize = EEFS_ROUND_UP((EEFS_FileDescriptorTable[FileDescriptor].FileSize + EEFS_DEFAULT_CREAT_SPARE_BYTES), 4);
+            /* Calculate the New MaxFileSize from the spare byte policy and round it up to a 4 byte boundary */
+            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+            EEFS_SwapFileHeader(&FileHeader); /* APC */
+            PreviousMaxFileSize = EEFS_LibTakeFromSpareHistory(InodeTable, FileHeader.Filename);
+            SpareBytes = EEFS_LibSpareBytes(InodeTable, FileHeader.Filename, EEFS_FileDescriptorTable[FileDescriptor].FileSize, PreviousMaxFileSize);
+            SpareBytes = EEFS_MIN(SpareBytes, (EEFS_FileDescriptorTable[FileDescriptor].MaxFileSize - EEFS_FileDescriptorTable[FileDescriptor].FileSize));
+            MaxFileSize = EEFS_ROUND_UP((EEFS_FileDescriptorTable[FileDescriptor].FileSize + SpareBytes), 4);
 
             /* Make sure since we added some spare bytes to the end of the file we do not exceed the free memory size */
             MaxFileSize = EEFS_MIN(MaxFileSize, (InodeTable->FreeMemorySize - sizeof(EEFS_FileHeader_t)));
 
+            InodeTable->SpareStats.SizedFiles++;
+            InodeTable->SpareStats.SpareBytes += (MaxFileSize - EEFS_FileDescriptorTable[FileDescriptor].FileSize);
+            if ((InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_LEARNED) && (PreviousMaxFileSize > 0)) {
+                InodeTable->SpareStats.LearnedFiles++;
+            }
+
             /* Update the Inode Table with the new MaxFileSize */
             InodeTable->FreeMemoryPointer += (sizeof(EEFS_FileHeader_t) + MaxFileSize);
             InodeTable->FreeMemorySize -= (sizeof(EEFS_FileHeader_t) + MaxFileSize);
             InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
             
             /* Update the File Header */
-            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-            EEFS_SwapFileHeader(&FileHeader); /* APC */
             FileHeader.FileSize = EEFS_FileDescriptorTable[FileDescriptor].FileSize;
             FileHeader.Crc = 0;      /* Automatically updating the CRC is not supported at this time */
             EEFS_SwapFileHeader(&FileHeader); /* APC */
@@ -487,6 +618,75 @@ int32 EEFS_LibClose(int32 FileDescriptor)
     
 } /* End of EEFS_LibClose() */
 
+/* Makes the data written to an open file so far survive a reset without closing the file.  The FileSize, ModificationDate
+ * and Crc of the File Header are updated and everything written is programmed into EEPROM.  If a new file is being created
+ * its File Allocation Table entry is also committed with a provisional MaxFileSize that just holds the data written so far,
+ * and the File Allocation Table Header in EEPROM places free memory after the provisional slot, while the file keeps all of
+ * free memory in the Inode Table until it is closed.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFsync(int32 FileDescriptor)
+{
+    EEFS_FileHeader_t                   FileHeader;
+    uint32                              MaxFileSize;
+    void                               *FreeMemoryPointer;
+    uint32                              FreeMemorySize;
+    EEFS_InodeTable_t                  *InodeTable;
+    uint32                              InodeIndex;
+    int32                               ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
+
+        InodeTable = EEFS_FileDescriptorTable[FileDescriptor].InodeTable;
+        InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
+
+        /* The File Header is only updated if the file is open for write or creat */
+        if (EEFS_FileDescriptorTable[FileDescriptor].Mode & (EEFS_FCREAT | EEFS_FWRITE)) {
+
+            /* A reset before the file is closed leaves the provisional slot and the rest of the memory taken by the file is
+             * free memory again.  The File Allocation Table entry is written before the File Header for the same reason as in
+             * EEFS_LibClose(). */
+            FreeMemoryPointer = InodeTable->FreeMemoryPointer;
+            FreeMemorySize = InodeTable->FreeMemorySize;
+            if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FCREAT) {
+                MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                InodeTable->File[InodeIndex].MaxFileSize = EEFS_MIN((uint32)EEFS_ROUND_UP(EEFS_FileDescriptorTable[FileDescriptor].FileSize, 4), MaxFileSize);
+                EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+
+                /* A new file is always created at the start of free memory, so in EEPROM free memory starts after the
+                 * provisional slot.  Otherwise a reader that trusts the File Allocation Table Header would put a new file on
+                 * top of it. */
+                InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) +
+                                                InodeTable->File[InodeIndex].MaxFileSize;
+                InodeTable->FreeMemorySize = (uint32)((FreeMemoryPointer + FreeMemorySize) - InodeTable->FreeMemoryPointer);
+                InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
+            }
+
+            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+            FileHeader.FileSize = EEFS_FileDescriptorTable[FileDescriptor].FileSize;
+            FileHeader.ModificationDate = EEFS_LIB_TIME;
+            FileHeader.Crc = 0;   /* Automatically updating the CRC is not supported at this time */
+            EEFS_LibWriteFileHeader(InodeTable, InodeIndex, &FileHeader);
+
+            /* Makes the new file part of the file system in EEPROM */
+            if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FCREAT) {
+                EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+                InodeTable->FreeMemoryPointer = FreeMemoryPointer;
+                InodeTable->FreeMemorySize = FreeMemorySize;
+            }
+        }
+
+        EEFS_LIB_EEPROM_SYNC;
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid file descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibFsync() */
+
 /* Read from a file.  Returns the number of bytes read, 0 bytes if we have reached the end of file, or EEFS_INVALID_ARGUMENT
  * on error. */
 int32 EEFS_LibRead(int32 FileDescriptor, void *Buffer, uint32 Length)
@@ -669,6 +869,7 @@ int32 EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename)
                         /* Does the file have any open file descriptors */
                         if (EEFS_LibFmode(InodeTable, InodeIndex) == 0) {
 
+                            EEFS_LibAddToSpareHistory(InodeTable, InodeIndex, FileHeader.Filename);
                             memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t)); /* clears the InUse flag marking the file deleted */
                             EEFS_SwapFileHeader(&FileHeader); /* APC */
                             EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
@@ -704,104 +905,103 @@ int32 EEFS_LibRemove(EEFS_InodeTable_t *InodeTable, char *Filename)
     
 } /* End of EEFS_LibRemove() */
 
-/* Renames the specified file.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
- * or EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibRename(EEFS_InodeTable_t *InodeTable, char *OldFilename, char *NewFilename)
+/* Compacts the file system by moving files down over the slots of deleted files and returning the space to free memory.
+ * Each call stops once MaxBytesToCopy bytes have been written to EEPROM, except that at least one step is always taken, so
+ * the file system can be compacted incrementally by calling this function until it returns 0.  This implementation does
+ * not track the extents of open files, so no file can be open.  Returns the number of bytes written to EEPROM, 0 if nothing
+ * more can be compacted, or EEFS_PERMISSION_DENIED, EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibCompact(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToCopy)
 {
-    int32                           InodeIndex;
-    EEFS_FileHeader_t               FileHeader;
+    int32                           BytesWritten;
+    int32                           StepBytesWritten;
     int32                           ReturnCode;
 
     EEFS_LIB_LOCK;
-    if (InodeTable != NULL) {
-
-        if ((EEFS_LibIsValidFilename(OldFilename)) &&
-            (EEFS_LibIsValidFilename(NewFilename))) {
-
-            /* If the file system is not write protected */
-            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+    if ((InodeTable != NULL) && (MaxBytesToCopy > 0)) {
 
-                if ((EEFS_LibFindFile(InodeTable, NewFilename)) == EEFS_FILE_NOT_FOUND) {
+        /* If the file system is not write protected */
+        if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
 
-                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, OldFilename)) != EEFS_FILE_NOT_FOUND) {
+            if (EEFS_LibHasOpenFiles(InodeTable) == FALSE) {
 
-                        /* Can't rename a read only file */
-                        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-                         EEFS_SwapFileHeader(&FileHeader); /* APC */
-                        if ((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) {
+                BytesWritten = EEFS_LibTrimFreeMemory(InodeTable);
+                StepBytesWritten = 1;
+                while ((StepBytesWritten > 0) && ((uint32)BytesWritten < MaxBytesToCopy)) {
 
-                            strncpy(FileHeader.Filename, NewFilename, EEFS_MAX_FILENAME_SIZE);
-                            EEFS_SwapFileHeader(&FileHeader); /* APC */
-                            EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-                            EEFS_LIB_EEPROM_FLUSH;
-                            ReturnCode = EEFS_SUCCESS;
-                        }
-                        else { /* error read only file */
-                            ReturnCode = EEFS_PERMISSION_DENIED;
-                        }
+                    /* The first step is not limited so a file larger than MaxBytesToCopy can still be moved */
+                    if (BytesWritten == 0) {
+                        StepBytesWritten = EEFS_LibCompactStep(InodeTable, EEFS_COMPACT_NO_LIMIT);
                     }
-                    else { /* file not found */
-                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    else {
+                        StepBytesWritten = EEFS_LibCompactStep(InodeTable, (MaxBytesToCopy - BytesWritten));
                     }
+                    BytesWritten += StepBytesWritten;
                 }
-                else { /* new filename already exists */
-                    ReturnCode = EEFS_PERMISSION_DENIED;
-                }
+                ReturnCode = BytesWritten;
+            }
+            else { /* a file is open */
+                ReturnCode = EEFS_PERMISSION_DENIED;
             }
-            else { /* file system is write protected */
-                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
-            }                
         }
-        else { /* invalid filename size */
-            ReturnCode = EEFS_INVALID_ARGUMENT;
+        else { /* file system is write protected */
+            ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
         }
     }
-    else { /* invalid inode table */
+    else { /* invalid inode table or byte limit */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
     EEFS_LIB_UNLOCK;
     return(ReturnCode);
-    
-} /* End of EEFS_LibRename() */
 
-/* Returns file information for the specified filename in StatBuffer.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND,
- * or EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char *Filename, EEFS_Stat_t *StatBuffer)
+} /* End of EEFS_LibCompact() */
+
+/* Grows the slot of the specified file so it can hold at least NewMaxFileSize bytes, moving the file to free memory if its
+ * slot cannot be extended in place.  A slot that is already large enough is not changed.  The file must not be open and
+ * must not have extents.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * EEFS_NO_SPACE_LEFT_ON_DEVICE, EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibResize(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 NewMaxFileSize)
 {
     int32                           InodeIndex;
     EEFS_FileHeader_t               FileHeader;
     int32                           ReturnCode;
 
     EEFS_LIB_LOCK;
-    if (InodeTable != NULL)  {
+    if (InodeTable != NULL) {
 
-        if (StatBuffer != NULL) {
+        if (EEFS_LibIsValidFilename(Filename)) {
 
-            if (EEFS_LibIsValidFilename(Filename)) {
+            /* If the file system is not write protected */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
 
                 if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
 
-                    EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-                    EEFS_SwapFileHeader(&FileHeader); /* APC */
-                    StatBuffer->InodeIndex = InodeIndex;
-                    StatBuffer->Attributes = FileHeader.Attributes;
-                    StatBuffer->FileSize = FileHeader.FileSize;
-                    StatBuffer->ModificationDate = FileHeader.ModificationDate;
-                    StatBuffer->CreationDate = FileHeader.CreationDate;
-                    StatBuffer->Crc = FileHeader.Crc;
-                    strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
-                    ReturnCode = EEFS_SUCCESS;
+                    /* The File Descriptors of an open file point into its slot, and the extents of a file follow a full slot */
+                    if ((EEFS_LibFmode(InodeTable, InodeIndex) == 0) &&
+                        (EEFS_LibHasNextExtent(InodeTable, InodeIndex) == FALSE)) {
+
+                        if (NewMaxFileSize <= (InodeTable->FreeMemorySize + InodeTable->File[InodeIndex].MaxFileSize)) {
+                            EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                            ReturnCode = EEFS_LibRelocateFile(InodeTable, InodeIndex, (uint32)EEFS_ROUND_UP(NewMaxFileSize, 4),
+                                                              FileHeader.FileSize);
+                        }
+                        else { /* not enough free space in eeprom */
+                            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+                        }
+                    }
+                    else { /* error file is open or has extents */
+                        ReturnCode = EEFS_PERMISSION_DENIED;
+                    }
                 }
                 else { /* file not found */
                     ReturnCode = EEFS_FILE_NOT_FOUND;
                 }
             }
-            else { /* invalid filename */
-                ReturnCode = EEFS_INVALID_ARGUMENT;
+            else { /* file system is write protected */
+                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
             }
         }
-        else { /* invalid stat buffer */
+        else { /* invalid filename size */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
     }
@@ -811,34 +1011,75 @@ int32 EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char *Filename, EEFS_Stat_t *S
 
     EEFS_LIB_UNLOCK;
     return(ReturnCode);
-    
-} /* End of EEFS_LibStat() */
 
-/* Returns file information for the specified file descriptor in StatBuffer.  Returns EEFS_SUCCESS on success or 
- * EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibFstat(int32 FileDescriptor, EEFS_Stat_t *StatBuffer)
+} /* End of EEFS_LibResize() */
+
+/* Truncates a file that is open for write to Length bytes without releasing any space, so the file can be rewritten up to
+ * its old size after it has been truncated.  Truncate cannot make a file longer since the file system does not support
+ * holes.  The file pointer is moved to the new end of the file if it was past it.  Returns EEFS_SUCCESS on success,
+ * EEFS_PERMISSION_DENIED or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFtruncate(int32 FileDescriptor, uint32 Length)
 {
-    EEFS_FileHeader_t               FileHeader;
-    int32                           ReturnCode;
+    return(EEFS_LibFtruncateFile(FileDescriptor, Length, FALSE));
+
+} /* End of EEFS_LibFtruncate() */
+
+/* Truncates a file that is open for write to Length bytes like EEFS_LibFtruncate(), then releases the space past Length as
+ * EEFS_LibTruncate() does if no other File Descriptor has the file open.  Returns EEFS_SUCCESS on success,
+ * EEFS_PERMISSION_DENIED or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFtruncateRelease(int32 FileDescriptor, uint32 Length)
+{
+    return(EEFS_LibFtruncateFile(FileDescriptor, Length, TRUE));
+
+} /* End of EEFS_LibFtruncateRelease() */
+
+/* Truncates a file that is open for write to Length bytes.  When ReleaseSpace is TRUE the space past Length is released
+ * unless another File Descriptor has the file open. */
+int32 EEFS_LibFtruncateFile(int32 FileDescriptor, uint32 Length, uint8 ReleaseSpace)
+{
+    EEFS_InodeTable_t                  *InodeTable;
+    uint32                              InodeIndex;
+    uint32                              i;
+    int32                               ReturnCode;
 
     EEFS_LIB_LOCK;
     if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
-    
-        if (StatBuffer != NULL) {
 
-            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-            EEFS_SwapFileHeader(&FileHeader); /* APC */
-            StatBuffer->InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
-            StatBuffer->Attributes = FileHeader.Attributes;
-            StatBuffer->FileSize = FileHeader.FileSize;
-            StatBuffer->ModificationDate = FileHeader.ModificationDate;
-            StatBuffer->CreationDate = FileHeader.CreationDate;
-            StatBuffer->Crc = FileHeader.Crc;
-            strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
-            ReturnCode = EEFS_SUCCESS;
+        if (EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FWRITE) {
+
+            if (Length <= EEFS_FileDescriptorTable[FileDescriptor].FileSize) {
+
+                /* The File Header of a file that is being created is written when the file is closed */
+                if ((EEFS_FileDescriptorTable[FileDescriptor].Mode & EEFS_FCREAT) == 0) {
+
+                    InodeTable = EEFS_FileDescriptorTable[FileDescriptor].InodeTable;
+                    InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
+
+                    /* The FileDataPointers of other File Descriptors may point into the space that would be released */
+                    for (i=0; i < EEFS_MAX_OPEN_FILES; i++) {
+                        if ((i != (uint32)FileDescriptor) &&
+                            (EEFS_FileDescriptorTable[i].InUse == TRUE) &&
+                            (EEFS_FileDescriptorTable[i].InodeTable == InodeTable) &&
+                            (EEFS_FileDescriptorTable[i].InodeIndex == InodeIndex)) {
+                            ReleaseSpace = FALSE;
+                        }
+                    }
+                    EEFS_LibTruncateFile(InodeTable, InodeIndex, Length, ReleaseSpace);
+                    EEFS_FileDescriptorTable[FileDescriptor].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                }
+
+                EEFS_FileDescriptorTable[FileDescriptor].FileSize = Length;
+                EEFS_FileDescriptorTable[FileDescriptor].ByteOffset = EEFS_MIN(EEFS_FileDescriptorTable[FileDescriptor].ByteOffset, Length);
+                EEFS_FileDescriptorTable[FileDescriptor].FileDataPointer = EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer +
+                    sizeof(EEFS_FileHeader_t) + EEFS_FileDescriptorTable[FileDescriptor].ByteOffset;
+                ReturnCode = EEFS_SUCCESS;
+            }
+            else { /* truncate can not extend a file */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
+            }
         }
-        else { /* invalid stat buffer */
-            ReturnCode = EEFS_INVALID_ARGUMENT;
+        else { /* file not open for writing */
+            ReturnCode = EEFS_PERMISSION_DENIED;
         }
     }
     else { /* invalid file descriptor */
@@ -847,51 +1088,55 @@ int32 EEFS_LibFstat(int32 FileDescriptor, EEFS_Stat_t *StatBuffer)
 
     EEFS_LIB_UNLOCK;
     return(ReturnCode);
-    
-} /* End of EEFS_LibFstat() */
 
-/* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
- * attribute.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error.  To read file
- * attributes use the stat function. */
-int32 EEFS_LibSetFileAttributes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
+} /* End of EEFS_LibFtruncateFile() */
+
+/* Truncates the specified file to Length bytes.  If the slot of the file ends at free memory it is shrunk to Length plus
+ * the spare bytes given by the spare byte policy of the volume and the rest is returned to free memory.  The file must not be open.  Truncate cannot make a
+ * file longer since the file system does not support holes.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED,
+ * EEFS_FILE_NOT_FOUND, EEFS_READ_ONLY_FILE_SYSTEM or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibTruncate(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Length)
 {
     int32                           InodeIndex;
     EEFS_FileHeader_t               FileHeader;
     int32                           ReturnCode;
 
     EEFS_LIB_LOCK;
-    if (InodeTable != NULL)  {
+    if (InodeTable != NULL) {
 
-        if (Attributes == EEFS_ATTRIBUTE_NONE || Attributes == EEFS_ATTRIBUTE_READONLY) {
+        if (EEFS_LibIsValidFilename(Filename)) {
 
-            if (EEFS_LibIsValidFilename(Filename)) {
+            /* If the file system is not write protected */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
 
-                /* If the file system is not write protected */
-                if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+                if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
 
-                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+                    /* Can't truncate a read only file or a file that is open */
+                    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+                    if (((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) &&
+                        (EEFS_LibFmode(InodeTable, InodeIndex) == 0)) {
 
-                        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
-                        EEFS_SwapFileHeader(&FileHeader); /* APC */
-                        FileHeader.Attributes = Attributes;
-                        EEFS_SwapFileHeader(&FileHeader); /* APC */
-                        EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
-                        EEFS_LIB_EEPROM_FLUSH;
-                        ReturnCode = EEFS_SUCCESS;
+                        if (Length <= FileHeader.FileSize) {
+                            EEFS_LibTruncateFile(InodeTable, InodeIndex, Length, TRUE);
+                            ReturnCode = EEFS_SUCCESS;
+                        }
+                        else { /* truncate can not extend a file */
+                            ReturnCode = EEFS_INVALID_ARGUMENT;
+                        }
                     }
-                    else { /* file not found */
-                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    else { /* error read only file or file is open */
+                        ReturnCode = EEFS_PERMISSION_DENIED;
                     }
                 }
-                else { /* file system is write protected */
-                    ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+                else { /* file not found */
+                    ReturnCode = EEFS_FILE_NOT_FOUND;
                 }
             }
-            else { /* invalid filename */
-                ReturnCode = EEFS_INVALID_ARGUMENT;
+            else { /* file system is write protected */
+                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
             }
         }
-        else { /* invalid attributes */
+        else { /* invalid filename size */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
     }
@@ -900,102 +1145,1281 @@ int32 EEFS_LibSetFileAttributes(EEFS_InodeTable_t *InodeTable, char *Filename, u
     }
 
     EEFS_LIB_UNLOCK;
-    return(ReturnCode); 
-    
-} /* End of EEFS_LibSetFileAttributes() */
+    return(ReturnCode);
 
-/* Opens a file system for reading the file directory.  This should be followed by calls to EEFS_ReadDir() and EEFS_CloseDir().
- * Note that currently only one process can read the file directory at a time.  Returns a pointer to a directory descriptor
- * on success and a NULL pointer on error. */
-EEFS_DirectoryDescriptor_t *EEFS_LibOpenDir(EEFS_InodeTable_t *InodeTable)
+} /* End of EEFS_LibTruncate() */
+
+/* Sets the spare byte policy of the volume, which chooses the spare bytes added to the slot of a file that is created by
+ * EEFS_LibCreat() when it is closed.  Parameter is the number of spare bytes for EEFS_SPARE_POLICY_FIXED, the percentage of
+ * the file size for EEFS_SPARE_POLICY_PERCENT, the smallest slot for EEFS_SPARE_POLICY_POWER_OF_TWO, the spare bytes of a
+ * file that is not in the spare history for EEFS_SPARE_POLICY_LEARNED, and is passed to Function for
+ * EEFS_SPARE_POLICY_CUSTOM.  Function is ignored by the other policies.  Returns EEFS_SUCCESS on success or
+ * EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibSetSparePolicy(EEFS_InodeTable_t *InodeTable, uint32 Policy, uint32 Parameter, EEFS_SparePolicyFunction_t Function)
 {
-    EEFS_DirectoryDescriptor_t      *DirectoryDescriptor;
+    int32                           ReturnCode;
 
     EEFS_LIB_LOCK;
     if (InodeTable != NULL) {
 
-        if (EEFS_DirectoryDescriptor.InUse == FALSE) {
+        if ((Policy <= EEFS_SPARE_POLICY_LEARNED) ||
+            ((Policy == EEFS_SPARE_POLICY_CUSTOM) && (Function != NULL))) {
 
-            EEFS_DirectoryDescriptor.InUse = TRUE;
-            EEFS_DirectoryDescriptor.InodeIndex = 0;
-            EEFS_DirectoryDescriptor.InodeTable = InodeTable;
-            DirectoryDescriptor = &EEFS_DirectoryDescriptor;
+            InodeTable->SparePolicy.Policy = Policy;
+            InodeTable->SparePolicy.Parameter = Parameter;
+            InodeTable->SparePolicy.Function = (Policy == EEFS_SPARE_POLICY_CUSTOM) ? Function : NULL;
+            ReturnCode = EEFS_SUCCESS;
         }
-        else { /* no available directory descriptors */
-            DirectoryDescriptor = NULL;
+        else { /* invalid policy or policy function */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
         }
     }
     else { /* invalid inode table */
-        DirectoryDescriptor = NULL;
+        ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
     EEFS_LIB_UNLOCK;
-    return(DirectoryDescriptor);
+    return(ReturnCode);
+
+} /* End of EEFS_LibSetSparePolicy() */
+
+/* Returns the spare byte statistics of the volume in SpareStats.  If Reset is TRUE the statistics are cleared after they are
+ * read.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibGetSpareStats(EEFS_InodeTable_t *InodeTable, EEFS_SpareStats_t *SpareStats, uint8 Reset)
+{
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if ((InodeTable != NULL) && (SpareStats != NULL)) {
+
+        memcpy(SpareStats, &InodeTable->SpareStats, sizeof(EEFS_SpareStats_t));
+        if (Reset == TRUE) {
+            memset(&InodeTable->SpareStats, 0, sizeof(EEFS_SpareStats_t));
+        }
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid inode table or spare stats */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibGetSpareStats() */
+
+/* Renames the specified file.  Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED, EEFS_FILE_NOT_FOUND,
+ * or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibRename(EEFS_InodeTable_t *InodeTable, char *OldFilename, char *NewFilename)
+{
+    int32                           InodeIndex;
+    EEFS_FileHeader_t               FileHeader;
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (InodeTable != NULL) {
+
+        if ((EEFS_LibIsValidFilename(OldFilename)) &&
+            (EEFS_LibIsValidFilename(NewFilename))) {
+
+            /* If the file system is not write protected */
+            if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+
+                if ((EEFS_LibFindFile(InodeTable, NewFilename)) == EEFS_FILE_NOT_FOUND) {
+
+                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, OldFilename)) != EEFS_FILE_NOT_FOUND) {
+
+                        /* Can't rename a read only file */
+                        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+                         EEFS_SwapFileHeader(&FileHeader); /* APC */
+                        if ((FileHeader.Attributes & EEFS_ATTRIBUTE_READONLY) == 0) {
+
+                            strncpy(FileHeader.Filename, NewFilename, EEFS_MAX_FILENAME_SIZE);
+                            EEFS_SwapFileHeader(&FileHeader); /* APC */
+                            EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
+                            EEFS_LIB_EEPROM_FLUSH;
+                            ReturnCode = EEFS_SUCCESS;
+                        }
+                        else { /* error read only file */
+                            ReturnCode = EEFS_PERMISSION_DENIED;
+                        }
+                    }
+                    else { /* file not found */
+                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    }
+                }
+                else { /* new filename already exists */
+                    ReturnCode = EEFS_PERMISSION_DENIED;
+                }
+            }
+            else { /* file system is write protected */
+                ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+            }                
+        }
+        else { /* invalid filename size */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
     
-} /* End of EEFS_LibOpenDir() */
+} /* End of EEFS_LibRename() */
 
-/* Read the next file directory entry.  Returns a pointer to a EEFS_DirectoryEntry_t if successful or NULL if no more file
- * directory entries exist or an error occurs.  Note that all entries are returned, even empty slots. (The InUse flag will be
- * set to FALSE for empty slots) */
-EEFS_DirectoryEntry_t *EEFS_LibReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+/* Returns file information for the specified filename in StatBuffer.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND,
+ * or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibStat(EEFS_InodeTable_t *InodeTable, char *Filename, EEFS_Stat_t *StatBuffer)
 {
+    int32                           InodeIndex;
     EEFS_FileHeader_t               FileHeader;
-    EEFS_DirectoryEntry_t          *DirectoryEntry;
+    int32                           ReturnCode;
 
     EEFS_LIB_LOCK;
-    if (DirectoryDescriptor != NULL) {
+    if (InodeTable != NULL)  {
 
-        if (DirectoryDescriptor->InodeIndex < DirectoryDescriptor->InodeTable->NumberOfFiles) {
-            
-            EEFS_LIB_EEPROM_READ(&FileHeader, DirectoryDescriptor->InodeTable->File[DirectoryDescriptor->InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+        if (StatBuffer != NULL) {
+
+            if (EEFS_LibIsValidFilename(Filename)) {
+
+                if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                    EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+                    EEFS_SwapFileHeader(&FileHeader); /* APC */
+                    StatBuffer->InodeIndex = InodeIndex;
+                    StatBuffer->Attributes = FileHeader.Attributes;
+                    StatBuffer->FileSize = FileHeader.FileSize;
+                    StatBuffer->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                    StatBuffer->ModificationDate = FileHeader.ModificationDate;
+                    StatBuffer->CreationDate = FileHeader.CreationDate;
+                    StatBuffer->Crc = FileHeader.Crc;
+                    strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
+                    ReturnCode = EEFS_SUCCESS;
+                }
+                else { /* file not found */
+                    ReturnCode = EEFS_FILE_NOT_FOUND;
+                }
+            }
+            else { /* invalid filename */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
+            }
+        }
+        else { /* invalid stat buffer */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+    
+} /* End of EEFS_LibStat() */
+
+/* Returns file information for the specified file descriptor in StatBuffer.  Returns EEFS_SUCCESS on success or 
+ * EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibFstat(int32 FileDescriptor, EEFS_Stat_t *StatBuffer)
+{
+    EEFS_FileHeader_t               FileHeader;
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (EEFS_LibIsValidFileDescriptor(FileDescriptor) == TRUE) {
+    
+        if (StatBuffer != NULL) {
+
+            EEFS_LIB_EEPROM_READ(&FileHeader, EEFS_FileDescriptorTable[FileDescriptor].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
             EEFS_SwapFileHeader(&FileHeader); /* APC */
-            EEFS_DirectoryEntry.InodeIndex = DirectoryDescriptor->InodeIndex;
-            EEFS_DirectoryEntry.FileHeaderPointer = DirectoryDescriptor->InodeTable->File[DirectoryDescriptor->InodeIndex].FileHeaderPointer;
-            EEFS_DirectoryEntry.MaxFileSize = DirectoryDescriptor->InodeTable->File[DirectoryDescriptor->InodeIndex].MaxFileSize;
-            EEFS_DirectoryEntry.InUse = FileHeader.InUse;
-            strncpy(EEFS_DirectoryEntry.Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
-            DirectoryDescriptor->InodeIndex++;
-            DirectoryEntry = &EEFS_DirectoryEntry;
+            StatBuffer->InodeIndex = EEFS_FileDescriptorTable[FileDescriptor].InodeIndex;
+            StatBuffer->Attributes = FileHeader.Attributes;
+            StatBuffer->FileSize = FileHeader.FileSize;
+            StatBuffer->MaxFileSize = EEFS_FileDescriptorTable[FileDescriptor].MaxFileSize;
+            StatBuffer->ModificationDate = FileHeader.ModificationDate;
+            StatBuffer->CreationDate = FileHeader.CreationDate;
+            StatBuffer->Crc = FileHeader.Crc;
+            strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
+            ReturnCode = EEFS_SUCCESS;
         }
-        else { /* no more directory entries */
-            DirectoryEntry = NULL;
+        else { /* invalid stat buffer */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
         }
     }
-    else { /* invalid directory descriptor */
-        DirectoryEntry = NULL;
+    else { /* invalid file descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
     EEFS_LIB_UNLOCK;
-    return(DirectoryEntry);
+    return(ReturnCode);
     
-} /* End of EEFS_LibReadDir() */
+} /* End of EEFS_LibFstat() */
 
-/* Close file system for reading the file directory.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
-int32 EEFS_LibCloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+/* Returns file information for every file in use in the caller supplied StatBuffers array in a single pass over the
+ * Inode Table.  At most MaxEntries entries are filled in, and Count is set to the number of files in use, which may be
+ * larger than MaxEntries.  If SpaceInfo is not NULL it is filled in with the space totals of the file system.  Returns
+ * EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibSnapshot(EEFS_InodeTable_t *InodeTable, EEFS_Stat_t *StatBuffers, uint32 MaxEntries, uint32 *Count, EEFS_SpaceInfo_t *SpaceInfo)
 {
+    EEFS_FileHeader_t               FileHeader;
+    EEFS_Stat_t                    *StatBuffer;
+    uint32                          FilesInUse;
+    uint32                          i;
     int32                           ReturnCode;
 
     EEFS_LIB_LOCK;
-    if (DirectoryDescriptor != NULL) {
+    if (InodeTable != NULL) {
 
-        if (DirectoryDescriptor->InUse == TRUE) {
+        if (((StatBuffers != NULL) || (MaxEntries == 0)) && (Count != NULL)) {
 
-            memset(DirectoryDescriptor, 0, sizeof(EEFS_DirectoryDescriptor_t)); /* this sets InUse to FALSE */
-            memset(&EEFS_DirectoryEntry, 0, sizeof(EEFS_DirectoryEntry_t));
+            FilesInUse = 0;
+            for (i=0; i < InodeTable->NumberOfFiles; i++) {
+
+                EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[i].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+                EEFS_SwapFileHeader(&FileHeader); /* APC */
+                if (FileHeader.InUse == TRUE) {
+
+                    if (FilesInUse < MaxEntries) {
+                        StatBuffer = &StatBuffers[FilesInUse];
+                        StatBuffer->InodeIndex = i;
+                        StatBuffer->Attributes = FileHeader.Attributes;
+                        StatBuffer->FileSize = FileHeader.FileSize;
+                        StatBuffer->MaxFileSize = InodeTable->File[i].MaxFileSize;
+                        StatBuffer->ModificationDate = FileHeader.ModificationDate;
+                        StatBuffer->CreationDate = FileHeader.CreationDate;
+                        StatBuffer->Crc = FileHeader.Crc;
+                        strncpy(StatBuffer->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
+                    }
+                    FilesInUse++;
+                }
+            }
+
+            *Count = FilesInUse;
+            if (SpaceInfo != NULL) {
+                EEFS_LibFillSpaceInfo(InodeTable, SpaceInfo);
+            }
             ReturnCode = EEFS_SUCCESS;
         }
-        else { /* directory descriptor not in use */
+        else { /* invalid stat buffers or count */
             ReturnCode = EEFS_INVALID_ARGUMENT;
         }
     }
-    else { /* invalid directory descriptor */
+    else { /* invalid inode table */
         ReturnCode = EEFS_INVALID_ARGUMENT;
     }
 
     EEFS_LIB_UNLOCK;
     return(ReturnCode);
-    
-} /* End of EEFS_LibCloseDir() */
+
+} /* End of EEFS_LibSnapshot() */
+
+/* Returns the space totals of the file system in SpaceInfo, see Space Accounting.  This implementation does not keep running
+ * totals, so the File Headers are read from EEPROM.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibGetSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if ((InodeTable != NULL) && (SpaceInfo != NULL)) {
+
+        EEFS_LibFillSpaceInfo(InodeTable, SpaceInfo);
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid inode table or space info */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibGetSpaceInfo() */
+
+/* Waits until every change that has been made to the file system has been programmed into EEPROM, see EEPROM Access.
+ * Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibSync(EEFS_InodeTable_t *InodeTable)
+{
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (InodeTable != NULL) {
+
+        EEFS_LIB_EEPROM_SYNC;
+        ReturnCode = EEFS_SUCCESS;
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibSync() */
+
+/* Sets the Attributes for the specified file. Currently the only attribute that is supported is the EEFS_ATTRIBUTE_READONLY
+ * attribute.  Returns EEFS_SUCCESS on success, EEFS_FILE_NOT_FOUND or EEFS_INVALID_ARGUMENT on error.  To read file
+ * attributes use the stat function. */
+int32 EEFS_LibSetFileAttributes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 Attributes)
+{
+    int32                           InodeIndex;
+    EEFS_FileHeader_t               FileHeader;
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (InodeTable != NULL)  {
+
+        if (Attributes == EEFS_ATTRIBUTE_NONE || Attributes == EEFS_ATTRIBUTE_READONLY) {
+
+            if (EEFS_LibIsValidFilename(Filename)) {
+
+                /* If the file system is not write protected */
+                if (EEFS_LIB_IS_WRITE_PROTECTED == FALSE) {
+
+                    if ((InodeIndex = EEFS_LibFindFile(InodeTable, Filename)) != EEFS_FILE_NOT_FOUND) {
+
+                        EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+                        EEFS_SwapFileHeader(&FileHeader); /* APC */
+                        FileHeader.Attributes = Attributes;
+                        EEFS_SwapFileHeader(&FileHeader); /* APC */
+                        EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
+                        EEFS_LIB_EEPROM_FLUSH;
+                        ReturnCode = EEFS_SUCCESS;
+                    }
+                    else { /* file not found */
+                        ReturnCode = EEFS_FILE_NOT_FOUND;
+                    }
+                }
+                else { /* file system is write protected */
+                    ReturnCode = EEFS_READ_ONLY_FILE_SYSTEM;
+                }
+            }
+            else { /* invalid filename */
+                ReturnCode = EEFS_INVALID_ARGUMENT;
+            }
+        }
+        else { /* invalid attributes */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid inode table */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode); 
+    
+} /* End of EEFS_LibSetFileAttributes() */
+
+/* Opens a file system for reading the file directory.  This should be followed by calls to EEFS_ReadDir() and EEFS_CloseDir().
+ * Note that currently only one process can read the file directory at a time.  Returns a pointer to a directory descriptor
+ * on success and a NULL pointer on error. */
+EEFS_DirectoryDescriptor_t *EEFS_LibOpenDir(EEFS_InodeTable_t *InodeTable)
+{
+    EEFS_DirectoryDescriptor_t      *DirectoryDescriptor;
+
+    EEFS_LIB_LOCK;
+    if (InodeTable != NULL) {
+
+        if (EEFS_DirectoryDescriptor.InUse == FALSE) {
+
+            EEFS_DirectoryDescriptor.InUse = TRUE;
+            EEFS_DirectoryDescriptor.InodeIndex = 0;
+            EEFS_DirectoryDescriptor.InodeTable = InodeTable;
+            DirectoryDescriptor = &EEFS_DirectoryDescriptor;
+        }
+        else { /* no available directory descriptors */
+            DirectoryDescriptor = NULL;
+        }
+    }
+    else { /* invalid inode table */
+        DirectoryDescriptor = NULL;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(DirectoryDescriptor);
+    
+} /* End of EEFS_LibOpenDir() */
+
+/* Read the next file directory entry.  Returns a pointer to a EEFS_DirectoryEntry_t if successful or NULL if no more file
+ * directory entries exist or an error occurs.  Note that all entries are returned, even empty slots. (The InUse flag will be
+ * set to FALSE for empty slots) */
+EEFS_DirectoryEntry_t *EEFS_LibReadDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+{
+    EEFS_DirectoryEntry_t          *DirectoryEntry;
+
+    if ((DirectoryDescriptor != NULL) &&
+        (EEFS_LibReadDir_r(DirectoryDescriptor, &EEFS_DirectoryEntry) == 1)) {
+        DirectoryEntry = &EEFS_DirectoryEntry;
+    }
+    else { /* no more directory entries or invalid directory descriptor */
+        DirectoryEntry = NULL;
+    }
+
+    return(DirectoryEntry);
+    
+} /* End of EEFS_LibReadDir() */
+
+/* Reentrant version of EEFS_LibReadDir() that copies the next file directory entry into the caller supplied DirectoryEntry.
+ * Returns 1 if an entry was read, 0 if no more file directory entries exist, or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibReadDir_r(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntry)
+{
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if ((DirectoryDescriptor != NULL) &&
+        (DirectoryDescriptor->InUse == TRUE) &&
+        (DirectoryEntry != NULL)) {
+
+        if (DirectoryDescriptor->InodeIndex < DirectoryDescriptor->InodeTable->NumberOfFiles) {
+
+            EEFS_LibFillDirectoryEntry(DirectoryDescriptor->InodeTable, DirectoryDescriptor->InodeIndex, DirectoryEntry);
+            DirectoryDescriptor->InodeIndex++;
+            ReturnCode = 1;
+        }
+        else { /* no more directory entries */
+            ReturnCode = 0;
+        }
+    }
+    else { /* invalid directory descriptor or directory entry */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibReadDir_r() */
+
+/* Reads up to MaxEntries file directory entries into the caller supplied DirectoryEntries array.  If Flags contains
+ * EEFS_READDIR_SKIP_DELETED then empty slots and extents are skipped.  Returns the number of entries read, 0 if no more file
+ * directory entries exist, or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibReadDirBatch(EEFS_DirectoryDescriptor_t *DirectoryDescriptor, EEFS_DirectoryEntry_t *DirectoryEntries, uint32 MaxEntries, uint32 Flags)
+{
+    EEFS_InodeTable_t              *InodeTable;
+    uint32                          EntriesRead;
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if ((DirectoryDescriptor != NULL) &&
+        (DirectoryDescriptor->InUse == TRUE) &&
+        (DirectoryEntries != NULL) &&
+        ((Flags & ~EEFS_READDIR_SKIP_DELETED) == 0)) {
+
+        InodeTable = DirectoryDescriptor->InodeTable;
+        EntriesRead = 0;
+        while ((EntriesRead < MaxEntries) &&
+               (DirectoryDescriptor->InodeIndex < InodeTable->NumberOfFiles)) {
+
+            /* The entry is filled in before it is known whether it is skipped, it is overwritten by the next entry if so */
+            EEFS_LibFillDirectoryEntry(InodeTable, DirectoryDescriptor->InodeIndex, &DirectoryEntries[EntriesRead]);
+            if (((Flags & EEFS_READDIR_SKIP_DELETED) == 0) ||
+                (DirectoryEntries[EntriesRead].InUse == TRUE)) {
+                EntriesRead++;
+            }
+            DirectoryDescriptor->InodeIndex++;
+        }
+        ReturnCode = EntriesRead;
+    }
+    else { /* invalid directory descriptor, directory entries or flags */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+
+} /* End of EEFS_LibReadDirBatch() */
+
+/* Close file system for reading the file directory.  Returns EEFS_SUCCESS on success or EEFS_INVALID_ARGUMENT on error. */
+int32 EEFS_LibCloseDir(EEFS_DirectoryDescriptor_t *DirectoryDescriptor)
+{
+    int32                           ReturnCode;
+
+    EEFS_LIB_LOCK;
+    if (DirectoryDescriptor != NULL) {
+
+        if (DirectoryDescriptor->InUse == TRUE) {
+
+            memset(DirectoryDescriptor, 0, sizeof(EEFS_DirectoryDescriptor_t)); /* this sets InUse to FALSE */
+            memset(&EEFS_DirectoryEntry, 0, sizeof(EEFS_DirectoryEntry_t));
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* directory descriptor not in use */
+            ReturnCode = EEFS_INVALID_ARGUMENT;
+        }
+    }
+    else { /* invalid directory descriptor */
+        ReturnCode = EEFS_INVALID_ARGUMENT;
+    }
+
+    EEFS_LIB_UNLOCK;
+    return(ReturnCode);
+    
+} /* End of EEFS_LibCloseDir() */
+
+/* Fills in a directory entry from the File Header in EEPROM. */
+void EEFS_LibFillDirectoryEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_DirectoryEntry_t *DirectoryEntry)
+{
+    EEFS_FileHeader_t               FileHeader;
+
+    EEFS_LIB_EEPROM_READ(&FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+    EEFS_SwapFileHeader(&FileHeader); /* APC */
+    DirectoryEntry->InodeIndex = InodeIndex;
+    DirectoryEntry->FileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+    DirectoryEntry->MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+    DirectoryEntry->InUse = FileHeader.InUse;
+    memcpy(DirectoryEntry->Filename, FileHeader.Filename, EEFS_MAX_FILENAME_SIZE);
+    DirectoryEntry->Filename[EEFS_MAX_FILENAME_SIZE - 1] = '\0';
+
+} /* End of EEFS_LibFillDirectoryEntry() */
+
+/* Reads a File Header from EEPROM */
+void EEFS_LibReadFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader)
+{
+    EEFS_LIB_EEPROM_READ(FileHeader, InodeTable->File[InodeIndex].FileHeaderPointer, sizeof(EEFS_FileHeader_t));
+    EEFS_SwapFileHeader(FileHeader); /* APC */
+
+} /* End of EEFS_LibReadFileHeader() */
+
+/* Writes a File Header to EEPROM */
+void EEFS_LibWriteFileHeader(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, EEFS_FileHeader_t *FileHeader)
+{
+    EEFS_FileHeader_t               SwappedFileHeader;
+
+    memcpy(&SwappedFileHeader, FileHeader, sizeof(EEFS_FileHeader_t));
+    EEFS_SwapFileHeader(&SwappedFileHeader); /* APC */
+    EEFS_LIB_EEPROM_WRITE(InodeTable->File[InodeIndex].FileHeaderPointer, &SwappedFileHeader, sizeof(EEFS_FileHeader_t));
+    EEFS_LIB_EEPROM_FLUSH;
+
+} /* End of EEFS_LibWriteFileHeader() */
+
+/* Writes the free memory and number of files in the Inode Table to the File Allocation Table Header in EEPROM */
+void EEFS_LibWriteFileAllocationTableHeader(EEFS_InodeTable_t *InodeTable)
+{
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileAllocationTableHeader_t    FileAllocationTableHeader;
+
+    FileAllocationTable = (void *)InodeTable->BaseAddress;
+    EEFS_LIB_EEPROM_READ(&FileAllocationTableHeader, &FileAllocationTable->Header, sizeof(EEFS_FileAllocationTableHeader_t));
+    EEFS_SwapFileAllocationTableHeader(&FileAllocationTableHeader);/*APC */
+    FileAllocationTableHeader.FreeMemoryOffset = (uint32)(InodeTable->FreeMemoryPointer - InodeTable->BaseAddress);
+    FileAllocationTableHeader.FreeMemorySize = InodeTable->FreeMemorySize;
+    FileAllocationTableHeader.NumberOfFiles = InodeTable->NumberOfFiles;
+    EEFS_SwapFileAllocationTableHeader(&FileAllocationTableHeader);/*APC */
+    EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->Header, &FileAllocationTableHeader, sizeof(EEFS_FileAllocationTableHeader_t));
+    EEFS_LIB_EEPROM_FLUSH;
+
+} /* End of EEFS_LibWriteFileAllocationTableHeader() */
+
+/* Writes the location and size of a slot in the Inode Table to its File Allocation Table entry in EEPROM */
+void EEFS_LibWriteFileAllocationTableEntry(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
+
+    FileAllocationTable = (void *)InodeTable->BaseAddress;
+    FileAllocationTableEntry.FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+    FileAllocationTableEntry.MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+    EEFS_SwapFileAllocationTableEntry(&FileAllocationTableEntry); /* APC */
+    EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->File[InodeIndex], &FileAllocationTableEntry, sizeof(EEFS_FileAllocationTableEntry_t));
+    EEFS_LIB_EEPROM_FLUSH;
+
+} /* End of EEFS_LibWriteFileAllocationTableEntry() */
+
+/* Returns TRUE if a slot is followed by an extent of its file.  The link is read from the File Header in EEPROM. */
+uint8 EEFS_LibHasNextExtent(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex)
+{
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    EEFS_FileHeader_t               FileHeader;
+
+    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+    if ((FileHeader.InUse != FALSE) && (FileHeader.NextExtent != 0)) {
+        return(TRUE);
+    }
+#else
+    (void)InodeTable;
+    (void)InodeIndex;
+#endif
+    return(FALSE);
+
+} /* End of EEFS_LibHasNextExtent() */
+
+/* Returns the Inode of the slot with the lowest address above Address, or EEFS_FILE_NOT_FOUND if there are no more slots.
+ * Once a file system has been compacted the slots are not always in the same order in memory as in the Inode Table. */
+int32 EEFS_LibNextSlot(EEFS_InodeTable_t *InodeTable, void *Address)
+{
+    uint32      i;
+    int32       InodeIndex;
+
+    InodeIndex = EEFS_FILE_NOT_FOUND;
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if ((InodeTable->File[i].FileHeaderPointer > Address) &&
+            ((InodeIndex == EEFS_FILE_NOT_FOUND) ||
+             (InodeTable->File[i].FileHeaderPointer < InodeTable->File[InodeIndex].FileHeaderPointer))) {
+            InodeIndex = i;
+        }
+    }
+    return(InodeIndex);
+
+} /* End of EEFS_LibNextSlot() */
+
+/* Returns the Inode of the slot that starts at Address, or EEFS_FILE_NOT_FOUND if no slot starts at Address */
+int32 EEFS_LibFindSlot(EEFS_InodeTable_t *InodeTable, void *Address)
+{
+    uint32      i;
+
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if (InodeTable->File[i].FileHeaderPointer == Address) {
+            return(i);
+        }
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindSlot() */
+
+/* Extends each slot that is followed by unused memory up to the start of the next slot.  This recovers the File Header of a
+ * slot that was moved by a file creat that was interrupted by a reset before the previous slot was extended.  Returns the
+ * number of bytes written to EEPROM. */
+int32 EEFS_LibFillSlotGaps(EEFS_InodeTable_t *InodeTable)
+{
+    void       *SlotEnd;
+    uint32      i;
+    int32       NextInodeIndex;
+    int32       BytesWritten;
+
+    BytesWritten = 0;
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        SlotEnd = InodeTable->File[i].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize;
+        NextInodeIndex = EEFS_LibNextSlot(InodeTable, InodeTable->File[i].FileHeaderPointer);
+        if ((NextInodeIndex != EEFS_FILE_NOT_FOUND) &&
+            (InodeTable->File[NextInodeIndex].FileHeaderPointer > SlotEnd) &&
+            (EEFS_LibHasNextExtent(InodeTable, i) == FALSE)) {
+            InodeTable->File[i].MaxFileSize += (uint32)(InodeTable->File[NextInodeIndex].FileHeaderPointer - SlotEnd);
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, i);
+            BytesWritten += sizeof(EEFS_FileAllocationTableEntry_t);
+        }
+    }
+    return(BytesWritten);
+
+} /* End of EEFS_LibFillSlotGaps() */
+
+/* Moves the start of free memory to the end of the last slot.  This recovers the space of a deleted slot that was shrunk by a
+ * compaction step, or accounts for a slot that was extended into free memory, when a reset occurred before free memory was
+ * updated.  Returns the number of bytes written to EEPROM. */
+int32 EEFS_LibTrimFreeMemory(EEFS_InodeTable_t *InodeTable)
+{
+    void       *EndOfSlots;
+    void       *SlotEnd;
+    uint32      i;
+    int32       BytesWritten;
+
+    EndOfSlots = (void *)(InodeTable->BaseAddress + sizeof(EEFS_FileAllocationTable_t));
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        SlotEnd = InodeTable->File[i].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize;
+        if (SlotEnd > EndOfSlots) {
+            EndOfSlots = SlotEnd;
+        }
+    }
+
+    if (EndOfSlots < InodeTable->FreeMemoryPointer) {
+        InodeTable->FreeMemorySize += (uint32)(InodeTable->FreeMemoryPointer - EndOfSlots);
+        InodeTable->FreeMemoryPointer = EndOfSlots;
+        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+        BytesWritten = sizeof(EEFS_FileAllocationTableHeader_t);
+    }
+    else if ((EndOfSlots > InodeTable->FreeMemoryPointer) &&
+             (EndOfSlots <= (InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize))) {
+        InodeTable->FreeMemorySize -= (uint32)(EndOfSlots - InodeTable->FreeMemoryPointer);
+        InodeTable->FreeMemoryPointer = EndOfSlots;
+        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+        BytesWritten = sizeof(EEFS_FileAllocationTableHeader_t);
+    }
+    else {
+        BytesWritten = 0;
+    }
+    return(BytesWritten);
+
+} /* End of EEFS_LibTrimFreeMemory() */
+
+/* Takes the compaction step for the deleted slot with the lowest address that can be compacted, the same as the compaction
+ * step of the main library.  No step is taken if it would write more than MaxBytesToWrite bytes.  Returns the number of
+ * bytes written to EEPROM, or 0 if no step was taken. */
+int32 EEFS_LibCompactStep(EEFS_InodeTable_t *InodeTable, uint32 MaxBytesToWrite)
+{
+    EEFS_CompactJournal_t           Journal;
+    EEFS_FileHeader_t               FileHeader;
+    void                           *SlotEnd;
+    int32                           InodeIndex;
+    int32                           NextInodeIndex;
+    uint32                          BytesToWrite;
+    uint8                           LimitReached;
+    int32                           BytesWritten;
+
+    BytesWritten = 0;
+    LimitReached = FALSE;
+
+    InodeIndex = EEFS_LibNextSlot(InodeTable, (void *)InodeTable->BaseAddress);
+    while ((InodeIndex != EEFS_FILE_NOT_FOUND) && (BytesWritten == 0) && (LimitReached == FALSE)) {
+
+        EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+        if (FileHeader.InUse == FALSE) {
+
+            SlotEnd = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[InodeIndex].MaxFileSize;
+            NextInodeIndex = EEFS_LibFindSlot(InodeTable, SlotEnd);
+            memset(&Journal, 0, sizeof(EEFS_CompactJournal_t));
+
+            if (NextInodeIndex == EEFS_FILE_NOT_FOUND) {
+
+                if (SlotEnd == InodeTable->FreeMemoryPointer) {
+
+                    if ((uint32)InodeIndex == (InodeTable->NumberOfFiles - 1)) {
+
+                        /* Remove the last entry from the File Allocation Table */
+                        InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+                        InodeTable->FreeMemorySize += (sizeof(EEFS_FileHeader_t) + InodeTable->File[InodeIndex].MaxFileSize);
+                        InodeTable->NumberOfFiles--;
+                        memset(&InodeTable->File[InodeIndex], 0, sizeof(EEFS_InodeTableEntry_t));
+                        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+                        BytesWritten = sizeof(EEFS_FileAllocationTableHeader_t);
+                    }
+                    else if (InodeTable->File[InodeIndex].MaxFileSize > 0) {
+
+                        /* Shrink the slot to just its File Header.  The slot is written first so an interrupted step
+                         * only leaves space that EEFS_LibTrimFreeMemory() recovers. */
+                        InodeTable->FreeMemorySize += InodeTable->File[InodeIndex].MaxFileSize;
+                        InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t);
+                        InodeTable->File[InodeIndex].MaxFileSize = 0;
+                        EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+                        EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+                        BytesWritten = sizeof(EEFS_FileAllocationTableEntry_t) + sizeof(EEFS_FileAllocationTableHeader_t);
+                    }
+                }
+            }
+            else if ((InodeTable->File[InodeIndex].MaxFileSize > 0) &&
+                     (InodeTable->FreeMemorySize >= sizeof(EEFS_CompactJournal_t))) {
+
+                EEFS_LibReadFileHeader(InodeTable, NextInodeIndex, &Journal.FileHeader);
+                if (Journal.FileHeader.InUse == FALSE) {
+
+                    /* Merge the two deleted slots.  The next slot is reduced to a File Header at the start of this slot
+                     * and this slot gets all of the space. */
+                    memset(&Journal.FileHeader, 0, sizeof(EEFS_FileHeader_t));
+                    Journal.InodeIndex[0] = NextInodeIndex;
+                    Journal.File[0].FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+                    Journal.File[0].MaxFileSize = 0;
+                    Journal.InodeIndex[1] = InodeIndex;
+                    Journal.File[1].FileHeaderOffset = Journal.File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t);
+                    Journal.File[1].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize + InodeTable->File[NextInodeIndex].MaxFileSize;
+                    BytesWritten = EEFS_LibCommitCompactJournal(InodeTable, &Journal);
+                }
+                else {
+
+                    /* Move the next file down to the start of this slot, this slot then follows the file */
+                    Journal.InodeIndex[0] = NextInodeIndex;
+                    Journal.File[0].FileHeaderOffset = (uint32)(InodeTable->File[InodeIndex].FileHeaderPointer - InodeTable->BaseAddress);
+                    Journal.File[0].MaxFileSize = InodeTable->File[NextInodeIndex].MaxFileSize;
+                    Journal.InodeIndex[1] = InodeIndex;
+                    Journal.File[1].FileHeaderOffset = Journal.File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t) + Journal.File[0].MaxFileSize;
+                    Journal.File[1].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+                    Journal.SourceOffset = (uint32)(SlotEnd - InodeTable->BaseAddress);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+                    /* All of an extent is copied since its slot may have grown after its File Header was written */
+                    if (Journal.FileHeader.InUse == EEFS_EXTENT_IN_USE) {
+                        Journal.FileHeader.FileSize = Journal.File[0].MaxFileSize;
+                    }
+#endif
+
+                    BytesToWrite = sizeof(EEFS_CompactJournal_t) + (2 * sizeof(EEFS_FileHeader_t)) +
+                                   EEFS_MIN(Journal.FileHeader.FileSize, Journal.File[0].MaxFileSize) +
+                                   (2 * sizeof(EEFS_FileAllocationTableEntry_t));
+                    if (BytesToWrite <= MaxBytesToWrite) {
+                        BytesWritten = EEFS_LibCommitCompactJournal(InodeTable, &Journal);
+                    }
+                    else { /* the move would exceed the limit for this call */
+                        LimitReached = TRUE;
+                    }
+                }
+            }
+        }
+        InodeIndex = EEFS_LibNextSlot(InodeTable, InodeTable->File[InodeIndex].FileHeaderPointer);
+    }
+
+    return(BytesWritten);
+
+} /* End of EEFS_LibCompactStep() */
+
+/* Writes a compaction journal to the start of free memory, applies it and updates the Inode Table.  Returns the number of
+ * bytes written to EEPROM. */
+int32 EEFS_LibCommitCompactJournal(EEFS_InodeTable_t *InodeTable, EEFS_CompactJournal_t *Journal)
+{
+    EEFS_CompactJournal_t          *JournalPointer;
+    uint32                          i;
+
+    /* The magic number is written last so a partly written journal is never applied */
+    JournalPointer = InodeTable->FreeMemoryPointer;
+    Journal->Magic = 0;
+    EEFS_LibWriteCompactJournalField(JournalPointer, Journal, 0, sizeof(EEFS_CompactJournal_t));
+    EEFS_LIB_EEPROM_FLUSH;
+    Journal->Magic = EEFS_COMPACT_MAGIC;
+    EEFS_LibWriteCompactJournalField(JournalPointer, Journal, offsetof(EEFS_CompactJournal_t, Magic), sizeof(uint32));
+    EEFS_LIB_EEPROM_FLUSH;
+
+    EEFS_LibApplyCompactJournal(InodeTable->BaseAddress, JournalPointer, Journal);
+
+    for (i=0; i < 2; i++) {
+        InodeTable->File[Journal->InodeIndex[i]].FileHeaderPointer = (void *)(InodeTable->BaseAddress + Journal->File[i].FileHeaderOffset);
+        InodeTable->File[Journal->InodeIndex[i]].MaxFileSize = Journal->File[i].MaxFileSize;
+    }
+
+    return(sizeof(EEFS_CompactJournal_t) + (2 * sizeof(EEFS_FileHeader_t)) + Journal->BytesCopied +
+           (2 * sizeof(EEFS_FileAllocationTableEntry_t)));
+
+} /* End of EEFS_LibCommitCompactJournal() */
+
+/* Applies a compaction journal to EEPROM.  This only uses the journal and EEPROM, so it is used both by compaction and to
+ * complete a step that was interrupted by a reset, and every write can safely be repeated. */
+void EEFS_LibApplyCompactJournal(uint32 BaseAddress, EEFS_CompactJournal_t *JournalPointer, EEFS_CompactJournal_t *Journal)
+{
+    EEFS_FileAllocationTable_t         *FileAllocationTable;
+    EEFS_FileAllocationTableEntry_t     FileAllocationTableEntry;
+    EEFS_FileHeader_t                   FileHeader;
+    uint8                               Buffer[EEFS_COMPACT_PAGE_SIZE];
+    void                               *Source;
+    void                               *Destination;
+    uint32                              DataSize;
+    uint32                              Distance;
+    uint32                              BytesSaved;
+    uint32                              Length;
+    uint32                              i;
+
+    FileAllocationTable = (void *)BaseAddress;
+
+    if (Journal->SourceOffset != 0) {
+
+        /* Only the part of a file that is in the slot is copied, the rest of a file that has extents is in the extents */
+        DataSize = EEFS_MIN(Journal->FileHeader.FileSize, Journal->File[0].MaxFileSize);
+
+        /* Copy the file data starting from the lowest address.  Copying at most Distance bytes at a time only overwrites
+         * source data that has already been copied, and BytesCopied is saved before any source data above the saved value
+         * can be overwritten. */
+        Source = (void *)(BaseAddress + Journal->SourceOffset + sizeof(EEFS_FileHeader_t));
+        Destination = (void *)(BaseAddress + Journal->File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t));
+        Distance = Journal->SourceOffset - Journal->File[0].FileHeaderOffset;
+        BytesSaved = Journal->BytesCopied;
+        while (Journal->BytesCopied < DataSize) {
+
+            Length = EEFS_COMPACT_PAGE_SIZE - (((uint32)Destination + Journal->BytesCopied) % EEFS_COMPACT_PAGE_SIZE);
+            Length = EEFS_MIN(Length, Distance);
+            Length = EEFS_MIN(Length, (DataSize - Journal->BytesCopied));
+            if ((Journal->BytesCopied + Length) > (BytesSaved + Distance)) {
+                EEFS_LibWriteCompactJournalField(JournalPointer, Journal, offsetof(EEFS_CompactJournal_t, BytesCopied), sizeof(uint32));
+                EEFS_LIB_EEPROM_FLUSH;
+                BytesSaved = Journal->BytesCopied;
+            }
+            EEFS_LIB_EEPROM_READ(Buffer, (Source + Journal->BytesCopied), Length);
+            EEFS_LIB_EEPROM_WRITE((Destination + Journal->BytesCopied), Buffer, Length);
+            Journal->BytesCopied += Length;
+        }
+
+        /* The File Header of the deleted slot is written over the old file data, so the copy must be recorded as complete */
+        EEFS_LIB_EEPROM_FLUSH;
+        EEFS_LibWriteCompactJournalField(JournalPointer, Journal, offsetof(EEFS_CompactJournal_t, BytesCopied), sizeof(uint32));
+        EEFS_LIB_EEPROM_FLUSH;
+        memcpy(&FileHeader, &Journal->FileHeader, sizeof(EEFS_FileHeader_t));
+    }
+    else { /* two deleted slots are merged */
+        memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
+    }
+    EEFS_SwapFileHeader(&FileHeader); /* APC */
+    EEFS_LIB_EEPROM_WRITE((void *)(BaseAddress + Journal->File[0].FileHeaderOffset), &FileHeader, sizeof(EEFS_FileHeader_t));
+    memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
+    EEFS_SwapFileHeader(&FileHeader); /* APC */
+    EEFS_LIB_EEPROM_WRITE((void *)(BaseAddress + Journal->File[1].FileHeaderOffset), &FileHeader, sizeof(EEFS_FileHeader_t));
+    EEFS_LIB_EEPROM_FLUSH;
+
+    for (i=0; i < 2; i++) {
+        memcpy(&FileAllocationTableEntry, &Journal->File[i], sizeof(EEFS_FileAllocationTableEntry_t));
+        EEFS_SwapFileAllocationTableEntry(&FileAllocationTableEntry); /* APC */
+        EEFS_LIB_EEPROM_WRITE(&FileAllocationTable->File[Journal->InodeIndex[i]], &FileAllocationTableEntry, sizeof(EEFS_FileAllocationTableEntry_t));
+    }
+    EEFS_LIB_EEPROM_FLUSH;
+
+    /* The step is complete */
+    Journal->Magic = 0;
+    EEFS_LibWriteCompactJournalField(JournalPointer, Journal, offsetof(EEFS_CompactJournal_t, Magic), sizeof(uint32));
+    EEFS_LIB_EEPROM_FLUSH;
+
+} /* End of EEFS_LibApplyCompactJournal() */
+
+/* Writes the FieldSize bytes at FieldOffset of a compaction journal to the journal in EEPROM */
+void EEFS_LibWriteCompactJournalField(EEFS_CompactJournal_t *JournalPointer, EEFS_CompactJournal_t *Journal, uint32 FieldOffset, uint32 FieldSize)
+{
+    EEFS_CompactJournal_t           SwappedJournal;
+
+    memcpy(&SwappedJournal, Journal, sizeof(EEFS_CompactJournal_t));
+    EEFS_SwapCompactJournal(&SwappedJournal); /* APC */
+    EEFS_LIB_EEPROM_WRITE(((uint8 *)JournalPointer + FieldOffset), ((uint8 *)&SwappedJournal + FieldOffset), FieldSize);
+
+} /* End of EEFS_LibWriteCompactJournalField() */
+
+/* Looks for a compaction journal at the start of free memory and completes the compaction step if one was interrupted by a
+ * reset.  This is called before the File Allocation Table is loaded into the Inode Table. */
+void EEFS_LibRecoverCompactJournal(uint32 BaseAddress, EEFS_FileAllocationTableHeader_t *FileAllocationTableHeader)
+{
+    EEFS_CompactJournal_t          *JournalPointer;
+    EEFS_CompactJournal_t           Journal;
+
+    if ((EEFS_LIB_IS_WRITE_PROTECTED == FALSE) &&
+        (FileAllocationTableHeader->FreeMemorySize >= sizeof(EEFS_CompactJournal_t))) {
+
+        JournalPointer = (void *)(BaseAddress + FileAllocationTableHeader->FreeMemoryOffset);
+        EEFS_LIB_EEPROM_READ(&Journal, JournalPointer, sizeof(EEFS_CompactJournal_t));
+        EEFS_SwapCompactJournal(&Journal); /* APC */
+
+        /* Free memory is not initialized, so the journal is only used if it describes two adjacent slots in the file system */
+        if ((Journal.Magic == EEFS_COMPACT_MAGIC) &&
+            (Journal.InodeIndex[0] < FileAllocationTableHeader->NumberOfFiles) &&
+            (Journal.InodeIndex[1] < FileAllocationTableHeader->NumberOfFiles) &&
+            (Journal.InodeIndex[0] != Journal.InodeIndex[1]) &&
+            (Journal.File[0].FileHeaderOffset >= sizeof(EEFS_FileAllocationTable_t)) &&
+            (Journal.File[1].FileHeaderOffset == (Journal.File[0].FileHeaderOffset + sizeof(EEFS_FileHeader_t) + Journal.File[0].MaxFileSize)) &&
+            ((Journal.File[1].FileHeaderOffset + sizeof(EEFS_FileHeader_t) + Journal.File[1].MaxFileSize) <= FileAllocationTableHeader->FreeMemoryOffset) &&
+            ((Journal.SourceOffset == 0) ||
+             ((Journal.SourceOffset > Journal.File[0].FileHeaderOffset) &&
+              ((Journal.SourceOffset + sizeof(EEFS_FileHeader_t) + Journal.File[0].MaxFileSize) <= FileAllocationTableHeader->FreeMemoryOffset)))) {
+
+            EEFS_LibApplyCompactJournal(BaseAddress, JournalPointer, &Journal);
+        }
+    }
+
+} /* End of EEFS_LibRecoverCompactJournal() */
+
+/* Returns the Inode of the slot that ends at Address, or EEFS_FILE_NOT_FOUND if no slot ends at Address */
+int32 EEFS_LibFindSlotEnd(EEFS_InodeTable_t *InodeTable, void *Address)
+{
+    uint32      i;
+
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if ((InodeTable->File[i].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize) == Address) {
+            return(i);
+        }
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindSlotEnd() */
+
+/* Returns the Inode of a deleted slot that has been reduced to a File Header and follows another slot that can be extended over
+ * it, or EEFS_FILE_NOT_FOUND if there are none.  This implementation has no free slot list so every slot is checked. */
+int32 EEFS_LibFindEmptySlot(EEFS_InodeTable_t *InodeTable)
+{
+    EEFS_FileHeader_t               FileHeader;
+    uint32                          i;
+    int32                           PrevInodeIndex;
+
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+        if (InodeTable->File[i].MaxFileSize == 0) {
+            EEFS_LibReadFileHeader(InodeTable, i, &FileHeader);
+            PrevInodeIndex = EEFS_LibFindSlotEnd(InodeTable, InodeTable->File[i].FileHeaderPointer);
+            if ((FileHeader.InUse == FALSE) &&
+                (PrevInodeIndex != EEFS_FILE_NOT_FOUND) &&
+                (EEFS_LibHasNextExtent(InodeTable, PrevInodeIndex) == FALSE)) {
+                return(i);
+            }
+        }
+    }
+    return(EEFS_FILE_NOT_FOUND);
+
+} /* End of EEFS_LibFindEmptySlot() */
+
+/* Moves a deleted slot that has been reduced to a File Header to FileHeaderPointer and writes FileHeader to it.  The slot that
+ * ends where the moved slot started is extended over its old File Header.  The moved slot is written first so a reset only
+ * leaves a gap between the two slots that EEFS_LibFillSlotGaps() recovers. */
+void EEFS_LibMoveEmptySlot(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, void *FileHeaderPointer, EEFS_FileHeader_t *FileHeader)
+{
+    void       *OldFileHeaderPointer;
+    int32       PrevInodeIndex;
+
+    OldFileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+    InodeTable->File[InodeIndex].FileHeaderPointer = FileHeaderPointer;
+    EEFS_LibWriteFileHeader(InodeTable, InodeIndex, FileHeader);
+    EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+
+    /* This is the moved slot itself if it was moved to the slot in front of its old File Header */
+    PrevInodeIndex = EEFS_LibFindSlotEnd(InodeTable, OldFileHeaderPointer);
+    if (PrevInodeIndex != EEFS_FILE_NOT_FOUND) {
+        InodeTable->File[PrevInodeIndex].MaxFileSize += sizeof(EEFS_FileHeader_t);
+        EEFS_LibWriteFileAllocationTableEntry(InodeTable, PrevInodeIndex);
+    }
+
+} /* End of EEFS_LibMoveEmptySlot() */
+
+/* Grows the slot of a file to NewMaxFileSize bytes the same way as the main library, a slot that is already large enough is
+ * not changed.  A slot that ends at free memory is extended in place, otherwise the File Header and the first BytesToCopy
+ * bytes of the file are copied to free memory and the old slot is given a File Allocation Table entry as a deleted slot.
+ * Returns EEFS_SUCCESS on success, EEFS_PERMISSION_DENIED or EEFS_NO_SPACE_LEFT_ON_DEVICE on error.  The caller must make
+ * sure that no File Descriptor has the file open. */
+int32 EEFS_LibRelocateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 NewMaxFileSize, uint32 BytesToCopy)
+{
+    EEFS_FileHeader_t                   FileHeader;
+    uint8                               Buffer[EEFS_COMPACT_PAGE_SIZE];
+    void                               *EndOfFreeMemory;
+    void                               *OldFileHeaderPointer;
+    uint32                              OldMaxFileSize;
+    void                               *Source;
+    void                               *Destination;
+    uint32                              BytesCopied;
+    uint32                              Length;
+    int32                               DeletedInodeIndex;
+    int32                               ReturnCode;
+
+    EndOfFreeMemory = InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize;
+    OldFileHeaderPointer = InodeTable->File[InodeIndex].FileHeaderPointer;
+    OldMaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+
+    if (NewMaxFileSize <= OldMaxFileSize) {
+        ReturnCode = EEFS_SUCCESS;
+    }
+
+    /* A file that is being created owns all of free memory */
+    else if (EEFS_LibHasOpenCreat(InodeTable) == TRUE) {
+        ReturnCode = EEFS_PERMISSION_DENIED;
+    }
+
+    /* A slot that ends at free memory is extended in place.  The File Allocation Table entry is written first so a reset
+     * only leaves a slot that extends into free memory, which EEFS_LibTrimFreeMemory() accounts for. */
+    else if ((OldFileHeaderPointer + sizeof(EEFS_FileHeader_t) + OldMaxFileSize) == InodeTable->FreeMemoryPointer) {
+
+        if ((NewMaxFileSize - OldMaxFileSize) <= InodeTable->FreeMemorySize) {
+            InodeTable->File[InodeIndex].MaxFileSize = NewMaxFileSize;
+            InodeTable->FreeMemoryPointer = OldFileHeaderPointer + sizeof(EEFS_FileHeader_t) + NewMaxFileSize;
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* not enough free space in eeprom */
+            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+        }
+    }
+
+    /* Otherwise the file is copied to free memory, which needs a File Allocation Table entry for the old slot */
+    else if ((NewMaxFileSize <= InodeTable->FreeMemorySize) &&
+             ((InodeTable->FreeMemorySize - NewMaxFileSize) >= sizeof(EEFS_FileHeader_t))) {
+
+        if ((DeletedInodeIndex = EEFS_LibFindEmptySlot(InodeTable)) == EEFS_FILE_NOT_FOUND) {
+            DeletedInodeIndex = InodeTable->NumberOfFiles;
+        }
+
+        if (DeletedInodeIndex < EEFS_MAX_FILES) {
+
+            /* Nothing refers to free memory so a reset during the copy leaves the file system unchanged.  The File Header
+             * is copied as it is in EEPROM. */
+            EEFS_LIB_EEPROM_READ(&FileHeader, OldFileHeaderPointer, sizeof(EEFS_FileHeader_t));
+            EEFS_LIB_EEPROM_WRITE(InodeTable->FreeMemoryPointer, &FileHeader, sizeof(EEFS_FileHeader_t));
+            EEFS_SwapFileHeader(&FileHeader); /* APC */
+            BytesToCopy = EEFS_MIN(EEFS_MAX(BytesToCopy, FileHeader.FileSize), OldMaxFileSize);
+            Source = OldFileHeaderPointer + sizeof(EEFS_FileHeader_t);
+            Destination = InodeTable->FreeMemoryPointer + sizeof(EEFS_FileHeader_t);
+            BytesCopied = 0;
+            while (BytesCopied < BytesToCopy) {
+
+                /* Each chunk ends on a page boundary of the destination so each eeprom page is only written once */
+                Length = EEFS_COMPACT_PAGE_SIZE - (((uint32)Destination + BytesCopied) % EEFS_COMPACT_PAGE_SIZE);
+                Length = EEFS_MIN(Length, (BytesToCopy - BytesCopied));
+                EEFS_LIB_EEPROM_READ(Buffer, (Source + BytesCopied), Length);
+                EEFS_LIB_EEPROM_WRITE((Destination + BytesCopied), Buffer, Length);
+                BytesCopied += Length;
+            }
+            EEFS_LIB_EEPROM_FLUSH;
+
+            /* Point the file at the copy.  Until the File Allocation Table Header is written a reset leaves the new slot in
+             * free memory, which EEFS_LibTrimFreeMemory() accounts for. */
+            InodeTable->File[InodeIndex].FileHeaderPointer = InodeTable->FreeMemoryPointer;
+            InodeTable->File[InodeIndex].MaxFileSize = NewMaxFileSize;
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+            InodeTable->FreeMemoryPointer += (sizeof(EEFS_FileHeader_t) + NewMaxFileSize);
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+
+            /* Nothing refers to the old slot now, so a reset only leaves a gap that EEFS_LibFillSlotGaps() recovers until the
+             * old slot is given its File Allocation Table entry as a deleted slot */
+            memset(&FileHeader, 0, sizeof(EEFS_FileHeader_t));
+            if ((uint32)DeletedInodeIndex == InodeTable->NumberOfFiles) {
+                InodeTable->NumberOfFiles++;
+                InodeTable->File[DeletedInodeIndex].FileHeaderPointer = OldFileHeaderPointer;
+                InodeTable->File[DeletedInodeIndex].MaxFileSize = OldMaxFileSize;
+                EEFS_LibWriteFileHeader(InodeTable, DeletedInodeIndex, &FileHeader);
+                EEFS_LibWriteFileAllocationTableEntry(InodeTable, DeletedInodeIndex);
+            }
+            else {
+                InodeTable->File[DeletedInodeIndex].MaxFileSize = OldMaxFileSize;
+                EEFS_LibMoveEmptySlot(InodeTable, DeletedInodeIndex, OldFileHeaderPointer, &FileHeader);
+            }
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+            ReturnCode = EEFS_SUCCESS;
+        }
+        else { /* no available slots in the File Allocation Table */
+            ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+        }
+    }
+    else { /* not enough free space in eeprom */
+        ReturnCode = EEFS_NO_SPACE_LEFT_ON_DEVICE;
+    }
+
+    return(ReturnCode);
+
+} /* End of EEFS_LibRelocateFile() */
+
+/* Sets the FileSize of a file to Length bytes, which must not be more than its current FileSize.  When ReleaseSpace is TRUE
+ * the slot of the file is shrunk to Length plus the spare bytes given by the spare byte policy of the volume if it ends at
+ * free memory.  This copy does not
+ * follow extents, so a slot that is followed by an extent is not shrunk.  The File Header is written first so a reset only
+ * leaves space at the end of the slot, which EEFS_LibTrimFreeMemory() recovers.  When ReleaseSpace is TRUE the caller must
+ * make sure that no other File Descriptor has the file open. */
+void EEFS_LibTruncateFile(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, uint32 Length, uint8 ReleaseSpace)
+{
+    EEFS_FileHeader_t                   FileHeader;
+    void                               *EndOfFreeMemory;
+    uint32                              MaxFileSize;
+    uint32                              SpareBytes;
+
+    EEFS_LibReadFileHeader(InodeTable, InodeIndex, &FileHeader);
+    FileHeader.FileSize = Length;
+    FileHeader.ModificationDate = EEFS_LIB_TIME;
+    FileHeader.Crc = 0;   /* Automatically updating the CRC is not supported at this time */
+    EEFS_LibWriteFileHeader(InodeTable, InodeIndex, &FileHeader);
+    SpareBytes = EEFS_LibSpareBytes(InodeTable, FileHeader.Filename, Length, 0);
+
+    if (ReleaseSpace == TRUE) {
+
+        SpareBytes = EEFS_MIN(SpareBytes, InodeTable->File[InodeIndex].MaxFileSize);
+        MaxFileSize = EEFS_ROUND_UP((Length + SpareBytes), 4);
+
+        /* A file that is being created owns all of free memory */
+        if ((MaxFileSize < InodeTable->File[InodeIndex].MaxFileSize) &&
+            ((InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) +
+              InodeTable->File[InodeIndex].MaxFileSize) == InodeTable->FreeMemoryPointer) &&
+            (EEFS_LibHasNextExtent(InodeTable, InodeIndex) == FALSE) &&
+            (EEFS_LibHasOpenCreat(InodeTable) == FALSE)) {
+
+            EndOfFreeMemory = InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize;
+            InodeTable->File[InodeIndex].MaxFileSize = MaxFileSize;
+            InodeTable->FreeMemoryPointer = InodeTable->File[InodeIndex].FileHeaderPointer + sizeof(EEFS_FileHeader_t) + MaxFileSize;
+            InodeTable->FreeMemorySize = (uint32)(EndOfFreeMemory - InodeTable->FreeMemoryPointer);
+            EEFS_LibWriteFileAllocationTableEntry(InodeTable, InodeIndex);
+            EEFS_LibWriteFileAllocationTableHeader(InodeTable);
+        }
+    }
+
+} /* End of EEFS_LibTruncateFile() */
+
+/* Returns the number of spare bytes to add to a slot that holds FileSize bytes under the spare byte policy of the volume.
+ * PreviousMaxFileSize is the capacity of a removed file with the same name for EEFS_SPARE_POLICY_LEARNED, 0 if none. */
+uint32 EEFS_LibSpareBytes(EEFS_InodeTable_t *InodeTable, char *Filename, uint32 FileSize, uint32 PreviousMaxFileSize)
+{
+    uint32              Parameter;
+    uint32              SlotSize;
+    uint32              SpareBytes;
+
+    Parameter = InodeTable->SparePolicy.Parameter;
+    if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_PERCENT) {
+        SpareBytes = ((FileSize / 100) * Parameter) + (((FileSize % 100) * Parameter) / 100);
+    }
+    else if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_POWER_OF_TWO) {
+        SlotSize = 4;
+        while ((SlotSize < EEFS_MAX(FileSize, Parameter)) && (SlotSize < 0x80000000)) {
+            SlotSize <<= 1;
+        }
+        SpareBytes = (SlotSize > FileSize) ? (SlotSize - FileSize) : 0;
+    }
+    else if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_LEARNED) {
+        /* A file that has outgrown its old slot is given the default spare bytes again */
+        SpareBytes = (PreviousMaxFileSize >= FileSize) ? (PreviousMaxFileSize - FileSize) : Parameter;
+    }
+    else if (InodeTable->SparePolicy.Policy == EEFS_SPARE_POLICY_CUSTOM) {
+        SpareBytes = InodeTable->SparePolicy.Function(Filename, FileSize, PreviousMaxFileSize, Parameter);
+    }
+    else { /* EEFS_SPARE_POLICY_FIXED */
+        SpareBytes = Parameter;
+    }
+    return(SpareBytes);
+
+} /* End of EEFS_LibSpareBytes() */
+
+/* Remembers the name and slot size of a file that is about to be removed for the learned spare byte policy.  An older entry
+ * for the same name is replaced, otherwise the oldest entry is.  This copy does not follow extents, so only the first slot of
+ * the file is counted. */
+void EEFS_LibAddToSpareHistory(EEFS_InodeTable_t *InodeTable, uint32 InodeIndex, char *Filename)
+{
+    uint32      i;
+
+    for (i=0; i < EEFS_SPARE_HISTORY_SIZE; i++) {
+        if (strncmp(InodeTable->SpareHistory[i].Filename, Filename, EEFS_MAX_FILENAME_SIZE) == 0) {
+            break;
+        }
+    }
+    if (i == EEFS_SPARE_HISTORY_SIZE) {
+        i = InodeTable->SpareHistoryNext;
+        InodeTable->SpareHistoryNext = (InodeTable->SpareHistoryNext + 1) % EEFS_SPARE_HISTORY_SIZE;
+    }
+    memcpy(InodeTable->SpareHistory[i].Filename, Filename, EEFS_MAX_FILENAME_SIZE);
+    InodeTable->SpareHistory[i].MaxFileSize = InodeTable->File[InodeIndex].MaxFileSize;
+
+} /* End of EEFS_LibAddToSpareHistory() */
+
+/* Returns the slot size of the removed file with the specified Filename and forgets it, or returns 0 if the file is not in
+ * the spare history. */
+uint32 EEFS_LibTakeFromSpareHistory(EEFS_InodeTable_t *InodeTable, char *Filename)
+{
+    uint32      i;
+    uint32      MaxFileSize;
+
+    for (i=0; i < EEFS_SPARE_HISTORY_SIZE; i++) {
+        if ((InodeTable->SpareHistory[i].Filename[0] != '\0') &&
+            (strncmp(InodeTable->SpareHistory[i].Filename, Filename, EEFS_MAX_FILENAME_SIZE) == 0)) {
+            MaxFileSize = InodeTable->SpareHistory[i].MaxFileSize;
+            memset(&InodeTable->SpareHistory[i], 0, sizeof(EEFS_SpareHistoryEntry_t));
+            return(MaxFileSize);
+        }
+    }
+    return(0);
+
+} /* End of EEFS_LibTakeFromSpareHistory() */
+
+/* Fills in SpaceInfo by reading the File Header of every slot from EEPROM, giving the same totals that the main library
+ * keeps in its Inode Table */
+void EEFS_LibFillSpaceInfo(EEFS_InodeTable_t *InodeTable, EEFS_SpaceInfo_t *SpaceInfo)
+{
+    EEFS_FileHeader_t               FileHeader;
+    uint32                          i;
+
+    memset(SpaceInfo, 0, sizeof(EEFS_SpaceInfo_t));
+    for (i=0; i < InodeTable->NumberOfFiles; i++) {
+
+        EEFS_LibReadFileHeader(InodeTable, i, &FileHeader);
+        if (FileHeader.InUse == TRUE) {
+            SpaceInfo->FilesInUse++;
+            SpaceInfo->AllocatedSpace += (sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize);
+            SpaceInfo->UsedSpace += FileHeader.FileSize;
+            if (FileHeader.FileSize < InodeTable->File[i].MaxFileSize) {
+                SpaceInfo->SlackSpace += (InodeTable->File[i].MaxFileSize - FileHeader.FileSize);
+            }
+        }
+        else if (FileHeader.InUse == FALSE) {
+            SpaceInfo->DeletedSpace += (sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize);
+        }
+        else { /* extent */
+            SpaceInfo->AllocatedSpace += (sizeof(EEFS_FileHeader_t) + InodeTable->File[i].MaxFileSize);
+            SpaceInfo->SlackSpace += InodeTable->File[i].MaxFileSize;
+        }
+    }
+    SpaceInfo->TotalSpace = (uint32)((InodeTable->FreeMemoryPointer + InodeTable->FreeMemorySize) - InodeTable->BaseAddress);
+
+    /* A file of unknown size that is being created owns all of free memory until it is closed */
+    if (EEFS_LibHasOpenCreat(InodeTable) == TRUE) {
+        SpaceInfo->FreeSpace = 0;
+    }
+    else {
+        SpaceInfo->FreeSpace = InodeTable->FreeMemorySize;
+    }
+
+} /* End of EEFS_LibFillSpaceInfo() */
 
 /* Returns TRUE if any files in the file system are open. */
 uint8 EEFS_LibHasOpenFiles(EEFS_InodeTable_t *InodeTable)
@@ -98,6 +98,9 @@ void EEFS_SwapFileHeader( EEFS_FileHeader_t  *FileHeader)
     SwapUInt32(&FileHeader->FileSize);
     SwapUInt32((uint32 *)&FileHeader->ModificationDate);
     SwapUInt32((uint32 *)&FileHeader->CreationDate);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+    SwapUInt32(&FileHeader->NextExtent);
+#endif
 }
 
 /*
@@ -142,3 +145,21 @@ void    EEFS_SwapFileAllocationTableHeader(EEFS_FileAllocationTableHeader_t *Fil
 
 }
 
+/*
+** This function swaps a compaction journal
+*/
+void    EEFS_SwapCompactJournal(EEFS_CompactJournal_t *Journal)
+{
+    uint32                           i;
+
+    SwapUInt32(&Journal->Magic);
+    for (i=0; i < 2; i++)
+    {
+        SwapUInt32(&Journal->InodeIndex[i]);
+        EEFS_SwapFileAllocationTableEntry(&Journal->File[i]);
+    }
+    SwapUInt32(&Journal->SourceOffset);
+    SwapUInt32(&Journal->BytesCopied);
+    EEFS_SwapFileHeader(&Journal->FileHeader);
+}
+
@@ -61,6 +61,10 @@ CommandLineOptions_t CommandLineOptions;
 char                 eefs_filename[128];
 char                 eefs_mountpoint[64] = "/eebank1";
 
+EEFS_Stat_t          eefs_snapshot[EEFS_MAX_FILES];
+uint32               eefs_file_count;
+EEFS_SpaceInfo_t     eefs_space_info;
+
 /*
 ** Code 
 */
@@ -70,11 +74,12 @@ int main (int argc, char **argv)
     int32                         Status;
     EEFS_DirectoryDescriptor_t   *DirDescriptor = NULL;
     EEFS_DirectoryEntry_t        *DirEntry = NULL;
-	EEFS_Stat_t                   StatBuffer;
     int32                         eefs_fd;
     int                           host_fd;
+    struct stat                   host_stat;
 	int                           total_used_space;
 	int                           total_free_space;
+    uint32                        i;
 
     /*
     ** Process the command line options
@@ -126,7 +131,7 @@ int main (int argc, char **argv)
                   
           while ( (DirEntry = EEFS_ReadDir(DirDescriptor)) != NULL )
           {
-             if ( DirEntry->InUse != 0 )
+             if ( DirEntry->InUse == TRUE )
              {
                 printf("%32s      %10d\n",DirEntry->Filename,(int)DirEntry->MaxFileSize);
              }
@@ -140,44 +145,28 @@ int main (int argc, char **argv)
        /*
        ** Dump the EEPROM usage stats for the EEFS
        */
-       total_used_space = 0;
-       total_free_space = 0;
-       DirDescriptor = EEFS_OpenDir(eefs_mountpoint); 
-       if ( DirDescriptor != NULL )
+       Status = EEFS_Snapshot(eefs_mountpoint, eefs_snapshot, EEFS_MAX_FILES, &eefs_file_count, &eefs_space_info);
+       if ( Status == 0 )
        {
-          DirEntry = NULL;
-          printf("--> EEFS Usage Stats:\n");		  
+          printf("--> EEFS Usage Stats:\n");
           printf("%32s      %10s    %10s\n","Filename","Size", "Max Size");
           printf("------------------------------------------------------\n");
-                  
-          while ( (DirEntry = EEFS_ReadDir(DirDescriptor)) != NULL )
-          {
-             if ( DirEntry->InUse != 0 )
-             {
-                strcpy(eefs_filename, eefs_mountpoint);
-                strcat(eefs_filename,"/");
-				strcat(eefs_filename,DirEntry->Filename);
-                Status = EEFS_Stat(eefs_filename, &StatBuffer);
 
-                if ( Status == 0 )
-				{
-				   printf("%32s      %10d    %10d\n",DirEntry->Filename, (int)StatBuffer.FileSize,
-				                                     (int)DirEntry->MaxFileSize);
-				   total_used_space = total_used_space + StatBuffer.FileSize;
-				   total_free_space = total_free_space + 
-				                      ( DirEntry->MaxFileSize - StatBuffer.FileSize);
-				}
-				else
-				{
-				   printf("Error: Cannot get Stat buffer for file: %s\n",eefs_filename);
-				}
-             }
+          for ( i = 0; i < eefs_file_count && i < EEFS_MAX_FILES; i++ )
+          {
+             printf("%32s      %10d    %10d\n",eefs_snapshot[i].Filename, (int)eefs_snapshot[i].FileSize,
+                                               (int)eefs_snapshot[i].MaxFileSize);
           }
+          total_used_space = eefs_space_info.UsedSpace;
+          total_free_space = eefs_space_info.SlackSpace;
           printf("------------------------------------------------------\n");
-		  printf("Total Used space = %d bytes.\n",total_used_space);
-		  printf("Total Free space = %d bytes.\n",total_free_space);
-		  printf("Total Space = %d bytes.\n",total_used_space + total_free_space);
-          Status = EEFS_CloseDir(DirDescriptor); 
+          printf("Total Used space = %d bytes.\n",total_used_space);
+          printf("Total Free space = %d bytes.\n",total_free_space);
+          printf("Total Space = %d bytes.\n",total_used_space + total_free_space);
+       }
+       else
+       {
+          printf("Error: Cannot get usage stats for the EEPROM File System\n");
        }
     }
     else if ( CommandLineOptions.CopyFromCommand == TRUE )
@@ -253,7 +242,17 @@ int main (int argc, char **argv)
           strcat(eefs_filename,"/");
           strcat(eefs_filename,CommandLineOptions.Filename2);
 
-          eefs_fd = EEFS_Creat(eefs_filename, 0);
+          /*
+          ** The size of the host file is known, so reserve a slot of exactly that size
+          */
+          if ( fstat(host_fd, &host_stat) == 0 )
+          {
+             eefs_fd = EEFS_CreatSized(eefs_filename, (uint32)host_stat.st_size, 0);
+          }
+          else
+          {
+             eefs_fd = EEFS_Creat(eefs_filename, 0);
+          }
           if ( eefs_fd < 0 )
           {
              printf("Error calling EEFS_Creat on EEFS file: %s\n",CommandLineOptions.Filename2);
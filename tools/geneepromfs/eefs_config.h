@@ -36,5 +36,22 @@
    new file is created by calling the EEFS_LibCreat function */
 #define EEFS_DEFAULT_CREAT_SPARE_BYTES      512
 
+/* Number of removed files per volume whose MaxFileSize is remembered by
+   the learned spare byte policy */
+#define EEFS_SPARE_HISTORY_SIZE             8
+
+/* Number of buckets in the ram filename hash index used to locate files
+   by name.  A value close to EEFS_MAX_FILES keeps the hash chains short */
+#define EEFS_FILENAME_HASH_SIZE             64
+
+/* Set to TRUE to keep a write-through ram copy of every file header in the
+   inode table so metadata operations do not read file headers from EEPROM */
+#define EEFS_HEADER_CACHE                   FALSE
+
+/* Set to TRUE to let a file that outgrows its slot continue in extents that
+   are chained from its file header.  This adds a field to the file header,
+   so the file system image must be built with the same setting */
+#define EEFS_EXTENT_CHAINING                FALSE
+
 #endif 
 
@@ -321,6 +321,9 @@ void ByteSwapFileSystem(FileSystem_t *FileSystem)
         SwapUInt32(&FileHeader->FileSize);
         SwapUInt32((uint32 *)&FileHeader->ModificationDate);
         SwapUInt32((uint32 *)&FileHeader->CreationDate);
+#if (EEFS_EXTENT_CHAINING == TRUE)
+        SwapUInt32(&FileHeader->NextExtent);
+#endif
 
         /* this is done last because I use the FileHeaderOffset to calculate the
          * address of the file header above. */
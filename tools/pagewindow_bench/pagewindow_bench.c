@@ -0,0 +1,234 @@
+/*
+**      Copyright (c) 2010-2014, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+*/
+
+/*
+ * Filename: pagewindow_bench.c
+ *
+ * Purpose: This file contains a host microbenchmark for the page window library in libraries/page_window.  EEPROM is an
+ *   in-memory array behind LRO_Write_EEPROM() and LRO_Read_EEPROM(), so the benchmark measures the time spent in the page
+ *   window library itself and not the time to program EEPROM.
+ *
+ * Design Notes:
+ *
+ *   The benchmark runs three workloads and prints the bytes/sec of each, along with the page window statistics:
+ *     sequential write - a 100 KB buffer written at an address that is not page aligned, flushed after each pass
+ *     metadata update  - the writes of an EEFS file close: a File Allocation Table entry in page 0, a File Header in a
+ *                        later page and the File Allocation Table header in page 0, flushed after each update, with
+ *                        BENCH_METADATA_UPDATES updates in each pass since an update only writes a few bytes
+ *     sequential read  - a 100 KB buffer read back through EEPROM_PageWindowRead()
+ *   The number of passes of each workload can be given on the command line, the default is 200.
+ *
+ *   To compare two versions of the page window library build the benchmark once against each of them, see the Makefile.
+ *   A version that does not have EEPROM_PageWindowRead() is built with PAGEWINDOW_BENCH_NO_READ defined, which skips the
+ *   sequential read workload.
+ *
+ */
+
+/*
+ * Includes
+ */
+
+#include "common_types.h"
+#include "eeprom_pagewindow.h"
+#include "semLib.h"
+#include "taskLib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Macro Definitions
+ */
+
+#define BENCH_DEFAULT_PASSES        200
+#define BENCH_BUFFER_SIZE           (100 * 1024)
+#define BENCH_METADATA_UPDATES      100
+#define BENCH_SEQUENTIAL_OFFSET     (4096 + 3)  /* not page aligned so the first and last pages are partly written */
+#define BENCH_FAT_ENTRY_OFFSET      40          /* a File Allocation Table entry in page 0 */
+#define BENCH_FAT_ENTRY_SIZE        8
+#define BENCH_FAT_HEADER_OFFSET     0           /* the File Allocation Table header in page 0 */
+#define BENCH_FAT_HEADER_SIZE       32
+#define BENCH_FILE_HEADER_OFFSET    (2 * EEPROM_PAGE_WINDOW_SIZE + 16) /* a File Header in page 2 */
+#define BENCH_FILE_HEADER_SIZE      88
+
+/*
+ * Global Data
+ */
+
+uint32                      GSFC_EepromWriteEnableFlags = 0x3; /* both eeprom banks are write enabled */
+static uint8                Eeprom[EEPROM_SIZE];
+static uint8                Buffer[BENCH_BUFFER_SIZE];
+
+/*
+ * Local Function Prototypes
+ */
+
+int     LRO_Write_EEPROM(void *from_addr, unsigned long int eeprom_offset, unsigned int num_bytes);
+int     LRO_Read_EEPROM(void *to_addr, unsigned long int eeprom_offset, unsigned int num_bytes);
+double  BenchSeconds(void);
+void    BenchReport(char *Name, double Bytes, double Seconds, uint32 Operations);
+void    BenchSequentialWrite(uint32 Passes);
+void    BenchMetadataUpdate(uint32 Passes);
+void    BenchSequentialRead(uint32 Passes);
+
+/*
+ * Function Definitions
+ */
+
+int main(int argc, char *argv[])
+{
+    uint32      Passes;
+
+    Passes = (argc > 1) ? (uint32)strtoul(argv[1], NULL, 0) : BENCH_DEFAULT_PASSES;
+    if (Passes == 0) {
+        printf("usage: %s [passes]\n", argv[0]);
+        return(1);
+    }
+
+    if (EEPROM_PageWindowInit() != EEPROM_SUCCESS) {
+        printf("EEPROM_PageWindowInit failed\n");
+        return(1);
+    }
+
+    memset(Buffer, 0x5a, sizeof(Buffer));
+    BenchSequentialWrite(Passes);
+    BenchMetadataUpdate(Passes);
+#ifndef PAGEWINDOW_BENCH_NO_READ
+    BenchSequentialRead(Passes);
+#endif
+    return(0);
+
+} /* End of main() */
+
+/* In-memory stand in for the low level EEPROM write in LRO_System_Services.c */
+int LRO_Write_EEPROM(void *from_addr, unsigned long int eeprom_offset, unsigned int num_bytes)
+{
+    memcpy(&Eeprom[eeprom_offset], from_addr, num_bytes);
+    return(0);
+
+} /* End of LRO_Write_EEPROM() */
+
+/* In-memory stand in for the low level EEPROM read in LRO_System_Services.c */
+int LRO_Read_EEPROM(void *to_addr, unsigned long int eeprom_offset, unsigned int num_bytes)
+{
+    memcpy(to_addr, &Eeprom[eeprom_offset], num_bytes);
+    return(0);
+
+} /* End of LRO_Read_EEPROM() */
+
+/* Returns the time of a monotonic clock in seconds */
+double BenchSeconds(void)
+{
+    struct timespec     Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return((double)Now.tv_sec + ((double)Now.tv_nsec / 1e9));
+
+} /* End of BenchSeconds() */
+
+/* Prints the throughput of a workload, its page window statistics and the pages programmed for each of its Operations,
+ * then resets the statistics for the next workload.  EEPROM_PageWindowInit() clears them before the first one. */
+void BenchReport(char *Name, double Bytes, double Seconds, uint32 Operations)
+{
+    EEPROM_PageWindowStats_t    Stats;
+
+    EEPROM_PageWindowGetStats(&Stats, TRUE);
+    printf("%-18s %12.0f bytes in %8.4f s  %14.0f bytes/sec  hits %lu misses %lu programs/op %.2f\n", Name, Bytes, Seconds,
+           (Seconds > 0.0) ? (Bytes / Seconds) : 0.0, (unsigned long)Stats.Hits, (unsigned long)Stats.Misses,
+           (double)Stats.Flushes / (double)Operations);
+
+} /* End of BenchReport() */
+
+/* Writes BENCH_BUFFER_SIZE bytes starting part way into a page and flushes after each pass */
+void BenchSequentialWrite(uint32 Passes)
+{
+    double      Start;
+    uint32      i;
+
+    Start = BenchSeconds();
+    for (i=0; i < Passes; i++) {
+        EEPROM_PageWindowWrite((void *)(unsigned long)(EEPROM_START_ADDR + BENCH_SEQUENTIAL_OFFSET), Buffer, BENCH_BUFFER_SIZE);
+        EEPROM_PageWindowFlush();
+    }
+    BenchReport("sequential write", (double)Passes * BENCH_BUFFER_SIZE, BenchSeconds() - Start, Passes);
+
+} /* End of BenchSequentialWrite() */
+
+/* Makes the writes of an EEFS file close in the order EEFS makes them and flushes after each update */
+void BenchMetadataUpdate(uint32 Passes)
+{
+    double      Start;
+    uint32      i;
+
+    Start = BenchSeconds();
+    for (i=0; i < (Passes * BENCH_METADATA_UPDATES); i++) {
+        EEPROM_PageWindowWrite((void *)(unsigned long)(EEPROM_START_ADDR + BENCH_FAT_ENTRY_OFFSET), Buffer, BENCH_FAT_ENTRY_SIZE);
+        EEPROM_PageWindowWrite((void *)(unsigned long)(EEPROM_START_ADDR + BENCH_FILE_HEADER_OFFSET), Buffer, BENCH_FILE_HEADER_SIZE);
+        EEPROM_PageWindowWrite((void *)(unsigned long)(EEPROM_START_ADDR + BENCH_FAT_HEADER_OFFSET), Buffer, BENCH_FAT_HEADER_SIZE);
+        EEPROM_PageWindowFlush();
+    }
+    BenchReport("metadata update", (double)Passes * BENCH_METADATA_UPDATES * (BENCH_FAT_ENTRY_SIZE + BENCH_FILE_HEADER_SIZE +
+                BENCH_FAT_HEADER_SIZE), BenchSeconds() - Start, Passes * BENCH_METADATA_UPDATES);
+
+} /* End of BenchMetadataUpdate() */
+
+#ifndef PAGEWINDOW_BENCH_NO_READ
+/* Reads back the buffer written by BenchSequentialWrite() through the page windows */
+void BenchSequentialRead(uint32 Passes)
+{
+    double      Start;
+    uint32      i;
+
+    Start = BenchSeconds();
+    for (i=0; i < Passes; i++) {
+        EEPROM_PageWindowRead(Buffer, (void *)(unsigned long)(EEPROM_START_ADDR + BENCH_SEQUENTIAL_OFFSET), BENCH_BUFFER_SIZE);
+    }
+    BenchReport("sequential read", (double)Passes * BENCH_BUFFER_SIZE, BenchSeconds() - Start, Passes);
+
+} /* End of BenchSequentialRead() */
+#endif
+
+/* The benchmark is single threaded, so the page window lock does not need to do anything */
+SEM_ID semMCreate(int Options)
+{
+    return((SEM_ID)&Eeprom[0]);
+}
+
+SEM_ID semCCreate(int Options, int InitialCount)
+{
+    return((SEM_ID)&Eeprom[0]);
+}
+
+int semTake(SEM_ID SemId, int Timeout)
+{
+    return(0);
+}
+
+int semGive(SEM_ID SemId)
+{
+    return(0);
+}
+
+int semDelete(SEM_ID SemId)
+{
+    return(0);
+}
+
+/* No flush task can be started, so every flush is programmed by the caller */
+int taskSpawn(char *Name, int Priority, int Options, int StackSize, FUNCPTR EntryPoint, int Arg1, int Arg2, int Arg3,
+              int Arg4, int Arg5, int Arg6, int Arg7, int Arg8, int Arg9, int Arg10)
+{
+    return(ERROR);
+}
+
+/************************/
+/*  End of File Comment */
+/************************/
@@ -0,0 +1,50 @@
+/*
+**      Copyright (c) 2010-2014, United States government as represented by the 
+**      administrator of the National Aeronautics Space Administration.  
+**      All rights reserved. This software was created at NASAs Goddard 
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used, 
+**      distributed and modified only pursuant to the terms of that agreement.
+*/
+
+/*
+ * Filename: semLib.h
+ *
+ * Purpose: This file contains the host stand in for the vxWorks semaphore library that is used by the page window library.
+ *   The benchmark is single threaded so the semaphores do nothing, see pagewindow_bench.c.
+ *
+ */
+
+#ifndef _semLib_
+#define _semLib_
+
+/*
+ * Macro Definitions
+ */
+
+#define SEM_Q_PRIORITY              0x1
+#define SEM_INVERSION_SAFE          0x8
+#define WAIT_FOREVER                (-1)
+
+/*
+ * Type Definitions
+ */
+
+typedef void *SEM_ID;
+
+/*
+ * Exported Functions
+ */
+
+SEM_ID semMCreate(int Options);
+SEM_ID semCCreate(int Options, int InitialCount);
+int    semTake(SEM_ID SemId, int Timeout);
+int    semGive(SEM_ID SemId);
+int    semDelete(SEM_ID SemId);
+
+#endif
+
+/************************/
+/*  End of File Comment */
+/************************/
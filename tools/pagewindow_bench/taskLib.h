@@ -0,0 +1,45 @@
+/*
+**      Copyright (c) 2010-2014, United States government as represented by the 
+**      administrator of the National Aeronautics Space Administration.  
+**      All rights reserved. This software was created at NASAs Goddard 
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used, 
+**      distributed and modified only pursuant to the terms of that agreement.
+*/
+
+/*
+ * Filename: taskLib.h
+ *
+ * Purpose: This file contains the host stand in for the vxWorks task library that is used by the page window library.  No
+ *   tasks can be spawned, so the page window flush task is never started and every flush is synchronous.
+ *
+ */
+
+#ifndef _taskLib_
+#define _taskLib_
+
+/*
+ * Macro Definitions
+ */
+
+#define ERROR                       (-1)
+
+/*
+ * Type Definitions
+ */
+
+typedef int (*FUNCPTR)();
+
+/*
+ * Exported Functions
+ */
+
+int taskSpawn(char *Name, int Priority, int Options, int StackSize, FUNCPTR EntryPoint, int Arg1, int Arg2, int Arg3,
+              int Arg4, int Arg5, int Arg6, int Arg7, int Arg8, int Arg9, int Arg10);
+
+#endif
+
+/************************/
+/*  End of File Comment */
+/************************/